@@ -0,0 +1,192 @@
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+bool ARCReplacer::GhostList::Erase(page_id_t page_id) {
+  auto it = index_.find(page_id);
+  if (it == index_.end()) {
+    return false;
+  }
+  pages_.erase(it->second);
+  index_.erase(it);
+  return true;
+}
+
+void ARCReplacer::GhostList::Push(page_id_t page_id) {
+  pages_.push_front(page_id);
+  index_[page_id] = pages_.begin();
+}
+
+void ARCReplacer::GhostList::PopBack() {
+  index_.erase(pages_.back());
+  pages_.pop_back();
+}
+
+ARCReplacer::ARCReplacer(size_t num_pages) : capacity_(num_pages), frames_(num_pages) {}
+
+ARCReplacer::~ARCReplacer() = default;
+
+void ARCReplacer::Attach(frame_id_t frame_id, ListType list) {
+  FrameEntry &entry = frames_[frame_id];
+  auto &frames = list == ListType::kT1 ? t1_ : t2_;
+  frames.push_front(frame_id);
+  entry.list_ = list;
+  entry.pos_ = frames.begin();
+  if (entry.evictable_) {
+    num_evictable_++;
+  }
+}
+
+void ARCReplacer::Detach(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.list_ == ListType::kNone) {
+    return;
+  }
+  (entry.list_ == ListType::kT1 ? t1_ : t2_).erase(entry.pos_);
+  entry.list_ = ListType::kNone;
+  if (entry.evictable_) {
+    num_evictable_--;
+  }
+}
+
+bool ARCReplacer::EvictFrom(ListType list, frame_id_t *frame_id) {
+  auto &frames = list == ListType::kT1 ? t1_ : t2_;
+  for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+    FrameEntry &entry = frames_[*it];
+    if (!entry.evictable_) {
+      continue;
+    }
+    *frame_id = *it;
+    page_id_t page_id = entry.page_id_;
+    Detach(*frame_id);
+    entry = FrameEntry();
+    if (page_id != INVALID_PAGE_ID) {
+      (list == ListType::kT1 ? b1_ : b2_).Push(page_id);
+      TrimGhosts();
+    }
+    return true;
+  }
+  return false;
+}
+
+void ARCReplacer::TrimGhosts() {
+  while (!b1_.pages_.empty() && t1_.size() + b1_.pages_.size() > capacity_) {
+    b1_.PopBack();
+  }
+  while (!b2_.pages_.empty() && t1_.size() + t2_.size() + b1_.pages_.size() + b2_.pages_.size() > 2 * capacity_) {
+    b2_.PopBack();
+  }
+}
+
+bool ARCReplacer::Victim(frame_id_t *frame_id) {
+  if (num_evictable_ == 0) {
+    return false;
+  }
+  if (!t1_.empty() && t1_.size() > target_t1_) {
+    return EvictFrom(ListType::kT1, frame_id) || EvictFrom(ListType::kT2, frame_id);
+  }
+  return EvictFrom(ListType::kT2, frame_id) || EvictFrom(ListType::kT1, frame_id);
+}
+
+void ARCReplacer::Pin(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (!entry.evictable_) {
+    return;
+  }
+  entry.evictable_ = false;
+  if (entry.list_ != ListType::kNone) {
+    num_evictable_--;
+  }
+}
+
+/**
+ * A frame unpinned before any access was recorded (e.g. a prefetched page) is treated as a page seen once.
+ */
+void ARCReplacer::Unpin(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.evictable_) {
+    return;
+  }
+  entry.evictable_ = true;
+  if (entry.list_ == ListType::kNone) {
+    Attach(frame_id, ListType::kT1);
+    TrimGhosts();
+  } else {
+    num_evictable_++;
+  }
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.list_ != ListType::kNone && entry.page_id_ == page_id) {
+    // hit in T1 or T2
+    Detach(frame_id);
+    Attach(frame_id, ListType::kT2);
+    return;
+  }
+
+  // the frame starts holding a page that was not resident, a ghost hit adapts the target size of T1
+  Detach(frame_id);
+  entry.page_id_ = page_id;
+  size_t b1_size = b1_.pages_.size();
+  size_t b2_size = b2_.pages_.size();
+  if (b1_.Erase(page_id)) {
+    target_t1_ = std::min(capacity_, target_t1_ + std::max<size_t>(1, b2_size / b1_size));
+    Attach(frame_id, ListType::kT2);
+  } else if (b2_.Erase(page_id)) {
+    size_t delta = std::max<size_t>(1, b1_size / b2_size);
+    target_t1_ = target_t1_ > delta ? target_t1_ - delta : 0;
+    Attach(frame_id, ListType::kT2);
+  } else {
+    Attach(frame_id, ListType::kT1);
+  }
+  TrimGhosts();
+}
+
+/**
+ * Replays the choices of Victim. Evictions only move pages to the ghost lists, which do not change the target size.
+ */
+std::vector<frame_id_t> ARCReplacer::GetEvictionOrder() {
+  std::vector<frame_id_t> t1;
+  std::vector<frame_id_t> t2;
+  for (auto it = t1_.rbegin(); it != t1_.rend(); ++it) {
+    if (frames_[*it].evictable_) {
+      t1.push_back(*it);
+    }
+  }
+  for (auto it = t2_.rbegin(); it != t2_.rend(); ++it) {
+    if (frames_[*it].evictable_) {
+      t2.push_back(*it);
+    }
+  }
+  std::vector<frame_id_t> order;
+  size_t t1_size = t1_.size();
+  size_t i = 0;
+  size_t j = 0;
+  while (i < t1.size() || j < t2.size()) {
+    bool from_t1 = t1_size > target_t1_ ? i < t1.size() : j == t2.size();
+    if (from_t1) {
+      order.push_back(t1[i++]);
+      t1_size--;
+    } else {
+      order.push_back(t2[j++]);
+    }
+  }
+  return order;
+}
+
+size_t ARCReplacer::Size() { return num_evictable_; }
+
+/**
+ * Forgotten frames leave T1/T2 without a ghost entry, their pages were dropped by the buffer pool, not replaced.
+ */
+void ARCReplacer::Resize(size_t num_pages) {
+  for (size_t i = num_pages; i < frames_.size(); i++) {
+    Pin(static_cast<frame_id_t>(i));
+    Detach(static_cast<frame_id_t>(i));
+  }
+  frames_.resize(num_pages);
+  capacity_ = num_pages;
+  target_t1_ = std::min(target_t1_, capacity_);
+  TrimGhosts();
+}
@@ -0,0 +1,19 @@
+#include "buffer/buffer_access_strategy.h"
+
+BufferAccessStrategy::BufferAccessStrategy(AccessStrategyType type, size_t ring_size) : type_(type) {
+  if (ring_size == 0) {
+    ring_size = type == AccessStrategyType::kBulkRead ? BULK_READ_RING_SIZE : BULK_WRITE_RING_SIZE;
+  }
+  ring_size_ = ring_size;
+}
+
+BufferAccessStrategy::Ring &BufferAccessStrategy::GetRing(const BufferPoolManager *owner) {
+  std::lock_guard<std::mutex> guard(rings_latch_);
+  auto it = rings_.find(owner);
+  if (it == rings_.end()) {
+    it = rings_.emplace(owner, Ring()).first;
+    it->second.frames_.assign(ring_size_, INVALID_FRAME_ID);
+    it->second.pages_.assign(ring_size_, INVALID_PAGE_ID);
+  }
+  return it->second;
+}
@@ -1,24 +1,34 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
 static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-        : pool_size_(pool_size), disk_manager_(disk_manager) {
-    pages_ = new Page[pool_size_];
-    replacer_ = new LRUReplacer(pool_size_);
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer_type)
+        : pool_size_(pool_size), disk_manager_(disk_manager), writing_back_(pool_size, false),
+          retire_from_(pool_size), loading_(pool_size, false) {
+    arena_ = new FrameArena(pool_size_, max(pool_size_, MAX_BUFFER_POOL_SIZE));
+    pages_ = arena_->GetFrames();
+    replacer_ = Replacer::Create(replacer_type, pool_size_);
     for (size_t i = 0; i < pool_size_; i++) {
         free_list_.emplace_back(i);
     }
 }
 
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager)
+        : pool_size_(0), disk_manager_(disk_manager), arena_(nullptr), pages_(nullptr), replacer_(nullptr) {}
+
 BufferPoolManager::~BufferPoolManager() {
-    for (auto page : page_table_) {
-        FlushPage(page.first);
-    }
-    delete[] pages_;
+    StopPrefetcher();
+    StopBackgroundFlusher();
+    SaveWorkingSet();
+    FlushAllPages();
+    delete arena_;
     delete replacer_;
 }
 
@@ -32,32 +42,39 @@ BufferPoolManager::~BufferPoolManager() {
 // 2.     If R is dirty, write it back to the disk.
 // 3.     Delete R from the page table and insert P.
 // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-    lock_guard<recursive_mutex> guard(latch_);
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+    unique_lock<recursive_mutex> guard(latch_);
+
+    // a page still being read in by the prefetcher has its frame reserved, wait for the read to finish
+    while (page_table_.count(page_id) != 0 && loading_[page_table_[page_id]]) {
+        load_cv_.wait(guard);
+    }
 
     if (page_table_.count(page_id) != 0) {
         frame_id_t frame_id = page_table_[page_id];
         Page &page = pages_[frame_id];
         page.pin_count_++;
         replacer_->Pin(frame_id);
+        replacer_->RecordAccess(frame_id, page_id);
+        hits_++;
+        if (auto *owner = OwnerStats()) owner->hits_++;
         return &page;
     }
 
-    frame_id_t frame_id = TryToFindFreePage();
+    frame_id_t frame_id = FindFrame(page_id, strategy);
     if (frame_id == -1)
         return nullptr;
 
+    misses_++;
+    if (auto *owner = OwnerStats()) owner->misses_++;
     Page &victim = pages_[frame_id];
-    if (victim.IsDirty()) {
-        disk_manager_->WritePage(victim.page_id_, victim.data_);
-    }
-
-    page_table_.erase(victim.page_id_);
+    EvictFrame(victim);
     victim.page_id_ = page_id;
     victim.pin_count_ = 1;
     victim.is_dirty_ = false;
 
     page_table_[page_id] = frame_id;
+    replacer_->RecordAccess(frame_id, page_id);
     disk_manager_->ReadPage(page_id, victim.data_);
 
     return &victim;
@@ -71,22 +88,32 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
 // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
 // 3.   Update P's metadata, zero out memory and add P to the page table.
 // 4.   Set the page ID output parameter. Return a pointer to P.
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+Page *BufferPoolManager::NewPage(page_id_t &page_id, BufferAccessStrategy *strategy) {
     lock_guard<recursive_mutex> guard(latch_);
 
-    frame_id_t frame_id = TryToFindFreePage();
-    if (frame_id == -1)
+    if (free_list_.empty() && replacer_->Size() == 0)
         return nullptr;
 
-    Page &page = pages_[frame_id];
-    if (page.IsDirty()) {
-        disk_manager_->WritePage(page.page_id_, page.data_);
+    page_id = AllocatePage();
+    Page *page = NewPageAt(page_id, strategy);
+    // every evictable frame may be busy with a background write-back
+    if (page == nullptr) {
+        DeallocatePage(page_id);
     }
+    return page;
+}
 
-    page_id = AllocatePage();
+Page *BufferPoolManager::NewPageAt(page_id_t page_id, BufferAccessStrategy *strategy) {
+    lock_guard<recursive_mutex> guard(latch_);
+
+    frame_id_t frame_id = FindFrame(page_id, strategy);
+    if (frame_id == -1)
+        return nullptr;
 
-    page_table_.erase(page.page_id_);
+    Page &page = pages_[frame_id];
+    EvictFrame(page);
     page_table_[page_id] = frame_id;
+    replacer_->RecordAccess(frame_id, page_id);
 
     page.page_id_ = page_id;
     page.pin_count_ = 1;
@@ -114,7 +141,7 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
     frame_id_t frame_id = it->second;
     Page &page = pages_[frame_id];
 
-    if (page.pin_count_ > 0) return false;
+    if (page.pin_count_ > 0 || writing_back_[frame_id] || loading_[frame_id]) return false;
 
     DeallocatePage(page_id);
     page_table_.erase(it);
@@ -137,27 +164,52 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
     auto it = page_table_.find(page_id);
     if (it == page_table_.end()) return false;
 
-    frame_id_t frame_id = it->second;
-    Page &page =pages_[frame_id];
+    return UnpinFrame(&pages_[it->second], is_dirty);
+}
+
+bool BufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+    lock_guard<recursive_mutex> guard(latch_);
 
-    // ASSERT(page.pin_count_ > 0, "Page Not Pinned!");
+    frame_id_t frame_id = static_cast<frame_id_t>(page - pages_);
+
+    // ASSERT(page->pin_count_ > 0, "Page Not Pinned!");
     // 如果已经没有 pin，就直接返回 false（或者根据你想要的语义返回 true）
-    if (page.pin_count_ == 0) {
-        // LOG(WARNING) << "UnpinPage called on already-unpinned page " << page_id;
+    if (page->pin_count_ == 0) {
+        // LOG(WARNING) << "UnpinPage called on already-unpinned page " << page->page_id_;
         return false;
     }
 
-    page.pin_count_--;
+    page->pin_count_--;
 
-    if (is_dirty) page.is_dirty_ = true;
+    if (is_dirty) page->is_dirty_ = true;
 
-    if (page.pin_count_ == 0) {
-        replacer_->Unpin(frame_id);
+    if (page->pin_count_ == 0) {
+        MakeEvictable(frame_id);
     }
 
     return true;
 }
 
+PageGuard BufferPoolManager::FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy) {
+    Page *page = FetchPage(page_id, strategy);
+    if (page == nullptr) return PageGuard();
+    return PageGuard(this, page);
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPageBasic(page_id, strategy).UpgradeRead();
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPageBasic(page_id, strategy).UpgradeWrite();
+}
+
+PageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id, BufferAccessStrategy *strategy) {
+    Page *page = NewPage(page_id, strategy);
+    if (page == nullptr) return PageGuard();
+    return PageGuard(this, page);
+}
+
 /**
  * TODO: Student Implement
  */
@@ -169,12 +221,82 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) {
 
     frame_id_t frame_id = it->second;
     Page &page = pages_[frame_id];
+    // the content is not there yet, and a page being read in is clean anyway
+    if (loading_[frame_id]) return true;
 
     disk_manager_->WritePage(page.page_id_, page.data_);
     page.is_dirty_ = false;
     return true;
 }
 
+void BufferPoolManager::FlushAllPages() {
+    vector<WriteBackFrame> frames;
+    CollectDirtyFrames(frames);
+    if (frames.empty()) return;
+    WriteBackFrames(disk_manager_, frames, false);
+    disk_manager_->Sync();
+}
+
+void BufferPoolManager::CollectDirtyFrames(vector<WriteBackFrame> &frames) {
+    lock_guard<recursive_mutex> guard(latch_);
+    for (auto &entry : page_table_) {
+        frame_id_t frame_id = entry.second;
+        Page &page = pages_[frame_id];
+        // a frame written back by the flusher right now is dirty again only if it was modified since
+        if (!page.is_dirty_ || writing_back_[frame_id] || loading_[frame_id]) continue;
+        writing_back_[frame_id] = true;
+        page.is_dirty_ = false;
+        frames.push_back({entry.first, this, frame_id});
+    }
+}
+
+// 1.   Sort the frames by page id, i.e. by their place in the files.
+// 2.   Copy a batch of them, each page under its read latch, one page at a time.
+// 3.   Write each run of adjacent pages of one extent in the batch with a single vectored write and wait for all.
+// 4.   Give the frames of the batch back to the replacer of their pool, unless they are pinned.
+void BufferPoolManager::WriteBackFrames(DiskManager *disk_manager, vector<WriteBackFrame> &frames, bool background) {
+    sort(frames.begin(), frames.end(),
+         [](const WriteBackFrame &a, const WriteBackFrame &b) { return a.page_id_ < b.page_id_; });
+    AlignedBuffer copies(min<size_t>(frames.size(), WRITE_BACK_BATCH_PAGES) * PAGE_SIZE);
+    for (size_t begin = 0; begin < frames.size(); begin += WRITE_BACK_BATCH_PAGES) {
+        size_t end = min<size_t>(frames.size(), begin + WRITE_BACK_BATCH_PAGES);
+        // holding several page latches at once could deadlock with a thread latching the same pages in another order
+        for (size_t i = begin; i < end; i++) {
+            Page &page = frames[i].pool_->pages_[frames[i].frame_id_];
+            page.RLatch();
+            memcpy(copies.Data() + (i - begin) * PAGE_SIZE, page.data_, PAGE_SIZE);
+            page.RUnlatch();
+        }
+        vector<IoHandle> writes;
+        for (size_t first = begin; first < end;) {
+            page_id_t first_page_id = frames[first].page_id_;
+            vector<const char *> run;
+            size_t i = first;
+            for (; i < end && frames[i].page_id_ == first_page_id + static_cast<page_id_t>(run.size()) &&
+                   frames[i].page_id_ / DiskManager::BITMAP_SIZE == first_page_id / DiskManager::BITMAP_SIZE;
+                 i++) {
+                run.push_back(copies.Data() + (i - begin) * PAGE_SIZE);
+            }
+            writes.emplace_back(disk_manager->WritePagesAsync(first_page_id, run));
+            first = i;
+        }
+        for (auto &write : writes) {
+            write.Wait();
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            BufferPoolManager *pool = frames[i].pool_;
+            frame_id_t frame_id = frames[i].frame_id_;
+            lock_guard<recursive_mutex> guard(pool->latch_);
+            pool->writing_back_[frame_id] = false;
+            if (pool->pages_[frame_id].pin_count_ == 0) {
+                pool->MakeEvictable(frame_id);
+            }
+            if (background) pool->background_write_backs_++;
+        }
+    }
+}
+
 frame_id_t BufferPoolManager::TryToFindFreePage() {
     if (!free_list_.empty()) {
         frame_id_t frame = free_list_.front();
@@ -183,11 +305,445 @@ frame_id_t BufferPoolManager::TryToFindFreePage() {
     }
 
     frame_id_t victim;
-    if (replacer_->Victim(&victim)) return victim;
+    while (replacer_->Victim(&victim)) {
+        // frames being written back are handed to the replacer again once the write completes
+        if (!writing_back_[victim]) return victim;
+    }
 
     return -1;
 }
 
+// 1.   Without a strategy, or if the strategy's ring is not full yet, take a frame the usual way.
+// 2.   Otherwise reuse the frame of the ring slot whose turn it is, unless it has been pinned, evicted or is busy
+//      with a background read or write since the strategy filled it, in which case that slot gets a new frame.
+frame_id_t BufferPoolManager::FindFrame(page_id_t page_id, BufferAccessStrategy *strategy) {
+    if (strategy == nullptr)
+        return TryToFindFreePage();
+
+    auto &ring = strategy->GetRing(this);
+    size_t slot = ring.next_;
+    ring.next_ = (ring.next_ + 1) % ring.frames_.size();
+
+    frame_id_t frame_id = ring.frames_[slot];
+    // the ring may still remember frames released by a Resize
+    if (frame_id != INVALID_FRAME_ID && !IsRetiring(frame_id)) {
+        Page &page = pages_[frame_id];
+        if (page.page_id_ == ring.pages_[slot] && page.pin_count_ == 0 && !writing_back_[frame_id] &&
+            !loading_[frame_id]) {
+            replacer_->Pin(frame_id);
+            ring.pages_[slot] = page_id;
+            return frame_id;
+        }
+    }
+
+    frame_id = TryToFindFreePage();
+    ring.frames_[slot] = frame_id;
+    ring.pages_[slot] = frame_id == INVALID_FRAME_ID ? INVALID_PAGE_ID : page_id;
+    return frame_id;
+}
+
+void BufferPoolManager::PrefetchPages(const vector<page_id_t> &page_ids,
+                                      const shared_ptr<BufferAccessStrategy> &strategy) {
+    if (page_ids.empty()) return;
+    {
+        lock_guard<mutex> lock(prefetch_mutex_);
+        for (auto page_id : page_ids) {
+            // more outstanding requests than frames would only evict pages prefetched a moment ago
+            if (prefetch_queue_.size() >= pool_size_) break;
+            prefetch_queue_.emplace_back(page_id, strategy);
+        }
+        if (!prefetcher_.joinable()) {
+            prefetch_stop_ = false;
+            prefetcher_ = thread([this]() {
+                unique_lock<mutex> lock(prefetch_mutex_);
+                vector<pair<page_id_t, shared_ptr<BufferAccessStrategy>>> batch;
+                vector<Page *> loads;
+                while (true) {
+                    prefetch_cv_.wait(lock, [this]() { return prefetch_stop_ || !prefetch_queue_.empty(); });
+                    if (prefetch_stop_) break;
+                    // the reads of a whole batch are in flight together
+                    while (!prefetch_queue_.empty() && batch.size() < ASYNC_IO_QUEUE_DEPTH) {
+                        batch.emplace_back(std::move(prefetch_queue_.front()));
+                        prefetch_queue_.pop_front();
+                    }
+                    lock.unlock();
+                    for (auto &request : batch) {
+                        Page *page = BeginLoad(request.first, request.second.get());
+                        if (page != nullptr) {
+                            loads.push_back(page);
+                        }
+                    }
+                    LoadPages(loads);
+                    loads.clear();
+                    batch.clear();
+                    lock.lock();
+                }
+            });
+        }
+    }
+    prefetch_cv_.notify_one();
+}
+
+bool BufferPoolManager::IsPageResident(page_id_t page_id) {
+    lock_guard<recursive_mutex> guard(latch_);
+    auto it = page_table_.find(page_id);
+    return it != page_table_.end() && !loading_[it->second];
+}
+
+void BufferPoolManager::StopPrefetcher() {
+    {
+        lock_guard<mutex> lock(prefetch_mutex_);
+        prefetch_stop_ = true;
+        prefetch_queue_.clear();
+    }
+    prefetch_cv_.notify_all();
+    if (prefetcher_.joinable()) {
+        prefetcher_.join();
+    }
+}
+
+// 1.   If P is resident or freed on disk, there is nothing to do.
+// 2.   Reserve a frame for P exactly like FetchPage does, but leave it unpinned and mark it as loading.
+// 3.   The caller reads P without holding the pool latch, then FinishLoad hands the frame to the replacer and wakes
+//      up waiting fetches.
+Page *BufferPoolManager::BeginLoad(page_id_t page_id, BufferAccessStrategy *strategy) {
+    if (disk_manager_->IsPageFree(page_id))
+        return nullptr;
+
+    lock_guard<recursive_mutex> guard(latch_);
+
+    if (page_table_.count(page_id) != 0)
+        return nullptr;
+
+    frame_id_t frame_id = FindFrame(page_id, strategy);
+    if (frame_id == -1)
+        return nullptr;
+
+    Page &page = pages_[frame_id];
+    EvictFrame(page);
+    page.page_id_ = page_id;
+    page.pin_count_ = 0;
+    page.is_dirty_ = false;
+    page_table_[page_id] = frame_id;
+    loading_[frame_id] = true;
+    return &page;
+}
+
+void BufferPoolManager::FinishLoad(Page *loaded) {
+    lock_guard<recursive_mutex> guard(latch_);
+    frame_id_t frame_id = loaded - pages_;
+    Page &page = pages_[frame_id];
+    loading_[frame_id] = false;
+    if (page.pin_count_ == 0) {
+        MakeEvictable(frame_id);
+    }
+    load_cv_.notify_all();
+}
+
+void BufferPoolManager::LoadPages(vector<Page *> &pages) {
+    sort(pages.begin(), pages.end(), [](Page *a, Page *b) { return a->page_id_ < b->page_id_; });
+    vector<pair<size_t, IoHandle>> reads;  // index of the first page of each run in pages
+    vector<char *> run;
+    for (size_t i = 0; i < pages.size(); i += run.size()) {
+        run.clear();
+        page_id_t first_page_id = pages[i]->page_id_;
+        for (size_t j = i; j < pages.size(); j++) {
+            page_id_t page_id = pages[j]->page_id_;
+            if (page_id != first_page_id + static_cast<page_id_t>(run.size()) ||
+                page_id / DiskManager::BITMAP_SIZE != first_page_id / DiskManager::BITMAP_SIZE) {
+                break;
+            }
+            run.push_back(pages[j]->data_);
+        }
+        reads.emplace_back(i, run.size() == 1 ? disk_manager_->ReadPageAsync(first_page_id, run[0])
+                                              : disk_manager_->ReadPagesAsync(first_page_id, run));
+    }
+    for (size_t i = 0; i < reads.size(); i++) {
+        reads[i].second.Wait();
+        size_t end = i + 1 < reads.size() ? reads[i + 1].first : pages.size();
+        for (size_t j = reads[i].first; j < end; j++) {
+            FinishLoad(pages[j]);
+        }
+    }
+}
+
+vector<page_id_t> BufferPoolManager::GetWorkingSet() {
+    lock_guard<recursive_mutex> guard(latch_);
+    vector<frame_id_t> order = replacer_->GetEvictionOrder();
+    vector<bool> evictable(pool_size_, false);
+    for (auto frame_id : order) {
+        evictable[frame_id] = true;
+    }
+    vector<page_id_t> page_ids;
+    for (size_t i = 0; i < pool_size_; i++) {
+        if (!evictable[i] && pages_[i].page_id_ != INVALID_PAGE_ID) {
+            page_ids.push_back(pages_[i].page_id_);
+        }
+    }
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        if (pages_[*it].page_id_ != INVALID_PAGE_ID) {
+            page_ids.push_back(pages_[*it].page_id_);
+        }
+    }
+    return page_ids;
+}
+
+void BufferPoolManager::SaveWorkingSet() {
+    if (working_set_file_.empty()) return;
+    vector<page_id_t> page_ids = GetWorkingSet();
+    uint32_t magic = WORKING_SET_MAGIC_NUM;
+    auto count = static_cast<uint32_t>(page_ids.size());
+    // replaced in one step, a crash never leaves half a list behind
+    string temp_file = working_set_file_ + ".tmp";
+    {
+        ofstream out(temp_file, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
+        out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    }
+    if (rename(temp_file.c_str(), working_set_file_.c_str()) != 0) {
+        LOG(WARNING) << "Failed to save the working set to " << working_set_file_;
+        remove(temp_file.c_str());
+    }
+    working_set_file_.clear();
+}
+
+// 1.   Read the page ids saved by SaveWorkingSet and keep the hottest ones that fit into the pool.
+// 2.   Sort them by page id, i.e. by file and then by position in the file.
+// 3.   Reserve frames for a batch of them like the prefetcher does and read the batch, adjacent pages with one I/O.
+//      In the background the prefetcher does the same while the pool is in use.
+size_t BufferPoolManager::Prewarm(const string &file_name, bool background) {
+    ifstream in(file_name, ios::binary);
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    if (!in.read(reinterpret_cast<char *>(&magic), sizeof(magic)) || magic != WORKING_SET_MAGIC_NUM ||
+        !in.read(reinterpret_cast<char *>(&count), sizeof(count))) {
+        return 0;
+    }
+    vector<page_id_t> page_ids(min<size_t>(count, GetPoolSize()));
+    if (!in.read(reinterpret_cast<char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t))) {
+        LOG(WARNING) << "Working set in " << file_name << " is truncated";
+        return 0;
+    }
+    sort(page_ids.begin(), page_ids.end());
+    if (background) {
+        PrefetchPages(page_ids);
+        return page_ids.size();
+    }
+    size_t loaded = 0;
+    vector<Page *> loads;
+    for (size_t i = 0; i < page_ids.size(); i += PREWARM_BATCH_PAGES) {
+        for (size_t j = i; j < min<size_t>(i + PREWARM_BATCH_PAGES, page_ids.size()); j++) {
+            Page *page = BeginLoad(page_ids[j], nullptr);
+            if (page != nullptr) {
+                loads.push_back(page);
+            }
+        }
+        loaded += loads.size();
+        LoadPages(loads);
+        loads.clear();
+    }
+    return loaded;
+}
+
+void BufferPoolManager::EvictFrame(Page &victim) {
+    // frames from the free list hold no page
+    if (victim.page_id_ == INVALID_PAGE_ID)
+        return;
+    if (victim.IsDirty()) {
+        WriteBackVictim(victim);
+    }
+    page_table_.erase(victim.page_id_);
+    evictions_++;
+    if (auto *owner = OwnerStats()) owner->evictions_++;
+}
+
+void BufferPoolManager::MakeEvictable(frame_id_t frame_id) {
+    if (IsRetiring(frame_id)) {
+        resize_cv_.notify_all();
+    } else {
+        replacer_->Unpin(frame_id);
+    }
+}
+
+// Growing:
+// 1.   Commit the descriptors of the new frames and put them on the free list.
+// Shrinking:
+// 1.   Mark the frames at the end as retiring, so that unpinning them no longer makes them evictable, and take them
+//      out of the free list and the replacer.
+// 2.   Evict every retiring frame that is unpinned and idle, writing back dirty pages. Retiring frames still pinned,
+//      or busy with a background read or write, are waited for until the deadline.
+// 3.   On timeout, hand the retiring frames back, otherwise release their memory.
+bool BufferPoolManager::Resize(size_t pool_size, uint32_t timeout_ms) {
+    unique_lock<recursive_mutex> guard(latch_);
+
+    if (pool_size == 0 || pool_size > arena_->GetCapacity())
+        return false;
+
+    if (pool_size >= pool_size_) {
+        arena_->Resize(pool_size);
+        writing_back_.resize(pool_size, false);
+        loading_.resize(pool_size, false);
+        replacer_->Resize(pool_size);
+        for (size_t i = pool_size_; i < pool_size; i++) {
+            free_list_.emplace_back(i);
+        }
+        pool_size_ = pool_size;
+        retire_from_ = pool_size;
+        return true;
+    }
+
+    retire_from_ = pool_size;
+    free_list_.remove_if([this](frame_id_t frame_id) { return IsRetiring(frame_id); });
+    for (size_t i = pool_size; i < pool_size_; i++) {
+        replacer_->Pin(i);
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    while (true) {
+        bool busy = false;
+        for (size_t i = pool_size; i < pool_size_; i++) {
+            Page &page = pages_[i];
+            if (page.pin_count_ > 0 || writing_back_[i] || loading_[i]) {
+                busy = true;
+                continue;
+            }
+            EvictFrame(page);
+            page.page_id_ = INVALID_PAGE_ID;
+            page.is_dirty_ = false;
+        }
+        if (!busy)
+            break;
+        if (resize_cv_.wait_until(guard, deadline) == cv_status::timeout) {
+            // frames evicted so far go back to the free list, pinned ones become evictable again when unpinned
+            retire_from_ = pool_size_;
+            for (size_t i = pool_size; i < pool_size_; i++) {
+                Page &page = pages_[i];
+                if (page.page_id_ == INVALID_PAGE_ID) {
+                    free_list_.emplace_back(i);
+                } else if (page.pin_count_ == 0 && !writing_back_[i] && !loading_[i]) {
+                    replacer_->Unpin(i);
+                }
+            }
+            return false;
+        }
+    }
+
+    replacer_->Resize(pool_size);
+    arena_->Resize(pool_size);
+    writing_back_.resize(pool_size);
+    loading_.resize(pool_size);
+    pool_size_ = pool_size;
+    if (flush_cursor_ >= pool_size_) {
+        flush_cursor_ = 0;
+    }
+    return true;
+}
+
+void BufferPoolManager::WriteBackVictim(Page &victim) {
+    disk_manager_->WritePage(victim.page_id_, victim.data_);
+    foreground_write_backs_++;
+    if (auto *owner = OwnerStats()) owner->dirty_write_backs_++;
+    flusher_cv_.notify_one();
+}
+
+BufferPoolStats *BufferPoolManager::OwnerStats() {
+    IoOwner owner = IoOwnerScope::Current();
+    if (owner.kind_ == IoOwner::Kind::kNone)
+        return nullptr;
+    return &owner_stats_[owner.Key()];
+}
+
+BufferPoolStats BufferPoolManager::GetStats() const {
+    return {hits_.load(), misses_.load(), evictions_.load(),
+            foreground_write_backs_.load() + background_write_backs_.load()};
+}
+
+unordered_map<uint64_t, BufferPoolStats> BufferPoolManager::GetOwnerStats() {
+    lock_guard<recursive_mutex> guard(latch_);
+    return owner_stats_;
+}
+
+void BufferPoolManager::StartBackgroundFlusher(double dirty_watermark, uint32_t interval_ms) {
+    StopBackgroundFlusher();
+    dirty_watermark_ = dirty_watermark;
+    flusher_interval_ms_ = interval_ms;
+    flusher_stop_ = false;
+    flusher_ = thread([this]() {
+        unique_lock<mutex> lock(flusher_mutex_);
+        while (!flusher_stop_) {
+            flusher_cv_.wait_for(lock, chrono::milliseconds(flusher_interval_ms_));
+            if (flusher_stop_) break;
+            lock.unlock();
+            // keep going while each round makes progress, a round only writes a bounded batch
+            while (FlushDirtyFrames() > 0 && !flusher_stop_) {
+            }
+            lock.lock();
+        }
+    });
+}
+
+void BufferPoolManager::StopBackgroundFlusher() {
+    {
+        lock_guard<mutex> lock(flusher_mutex_);
+        flusher_stop_ = true;
+    }
+    flusher_cv_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+}
+
+void BufferPoolManager::PauseBackgroundIo() {
+    StopPrefetcher();
+    // joining the flusher waits for the write-backs of its current round
+    flusher_paused_ = flusher_.joinable();
+    StopBackgroundFlusher();
+}
+
+void BufferPoolManager::ResumeBackgroundIo() {
+    if (flusher_paused_) {
+        flusher_paused_ = false;
+        StartBackgroundFlusher(dirty_watermark_, flusher_interval_ms_);
+    }
+}
+
+// 1.   Count the dirty frames among the evictable (resident and unpinned) ones.
+// 2.   If they exceed the watermark, mark a batch of them as being written back and clear their dirty bit, so that
+//      a modification racing with the write makes the page dirty again.
+// 3.   Write the batch back without holding the pool latch, the same way FlushAllPages does.
+size_t BufferPoolManager::FlushDirtyFrames() {
+    vector<WriteBackFrame> batch;
+    {
+        lock_guard<recursive_mutex> guard(latch_);
+        size_t evictable = 0;
+        size_t dirty = 0;
+        for (size_t i = 0; i < pool_size_; i++) {
+            Page &page = pages_[i];
+            if (page.page_id_ == INVALID_PAGE_ID || page.pin_count_ > 0 || writing_back_[i]) continue;
+            evictable++;
+            if (page.is_dirty_) dirty++;
+        }
+        auto allowed = static_cast<size_t>(dirty_watermark_ * evictable);
+        if (dirty <= allowed) return 0;
+
+        size_t target = min(dirty - allowed, FLUSH_BATCH_SIZE);
+        for (size_t n = 0; n < pool_size_ && batch.size() < target; n++) {
+            frame_id_t frame_id = static_cast<frame_id_t>(flush_cursor_);
+            flush_cursor_ = (flush_cursor_ + 1) % pool_size_;
+            Page &page = pages_[frame_id];
+            if (page.page_id_ == INVALID_PAGE_ID || page.pin_count_ > 0 || writing_back_[frame_id] || !page.is_dirty_)
+                continue;
+            writing_back_[frame_id] = true;
+            page.is_dirty_ = false;
+            batch.push_back({page.page_id_, this, frame_id});
+        }
+    }
+
+    WriteBackFrames(disk_manager_, batch, true);
+    return batch.size();
+}
+
 page_id_t BufferPoolManager::AllocatePage() {
     int next_page_id = disk_manager_->AllocatePage();
     return next_page_id;
@@ -197,10 +753,49 @@ void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id
     disk_manager_->DeAllocatePage(page_id);
 }
 
+page_id_t BufferPoolManager::AllocatePages(uint32_t count, segment_id_t segment_id) {
+    return disk_manager_->AllocatePages(count, segment_id);
+}
+
+void BufferPoolManager::DeallocatePages(page_id_t first_page_id, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        disk_manager_->DeAllocatePage(first_page_id + i);
+    }
+}
+
 bool BufferPoolManager::IsPageFree(page_id_t page_id) {
     return disk_manager_->IsPageFree(page_id);
 }
 
+bool BufferPoolManager::DropSegment(segment_id_t segment_id) {
+    if (segment_id == 0) {
+        return false;
+    }
+    {
+        lock_guard<recursive_mutex> guard(latch_);
+        DiscardSegment(segment_id);
+    }
+    return disk_manager_->DropSegment(segment_id);
+}
+
+void BufferPoolManager::DiscardSegment(segment_id_t segment_id) {
+    for (auto it = page_table_.begin(); it != page_table_.end();) {
+        frame_id_t frame_id = it->second;
+        Page &page = pages_[frame_id];
+        // frames in use are left alone, their pages are written to the dropped file or nowhere when evicted
+        if (DiskManager::SegmentOf(it->first) != segment_id || page.pin_count_ > 0 || writing_back_[frame_id] ||
+            loading_[frame_id]) {
+            ++it;
+            continue;
+        }
+        it = page_table_.erase(it);
+        replacer_->Pin(frame_id);
+        page.page_id_ = INVALID_PAGE_ID;
+        page.is_dirty_ = false;
+        free_list_.emplace_back(frame_id);
+    }
+}
+
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
     bool res = true;
@@ -41,6 +41,29 @@ void CLOCKReplacer::Unpin(frame_id_t frame_id) {
     clock_status[frame_id] = 1;
 }
 
+std::vector<frame_id_t> CLOCKReplacer::GetEvictionOrder() {
+    // the hand clears reference bits on its way, so run it on a copy
+    CLOCKReplacer copy(*this);
+    std::vector<frame_id_t> order;
+    frame_id_t frame_id;
+    while (copy.Victim(&frame_id)) {
+        order.push_back(frame_id);
+    }
+    return order;
+}
+
 size_t CLOCKReplacer::Size() {
     return clock_list.size();
-}
\ No newline at end of file
+}
+
+void CLOCKReplacer::Resize(size_t num_pages) {
+    for (auto it = clock_list.begin(); it != clock_list.end();) {
+        if (static_cast<size_t>(*it) >= num_pages) {
+            clock_status.erase(*it);
+            it = clock_list.erase(it);
+        } else {
+            it++;
+        }
+    }
+    capacity = num_pages;
+}
@@ -0,0 +1,36 @@
+#include "buffer/extent_allocator.h"
+
+PageGuard ExtentAllocator::NewPageGuarded(page_id_t &page_id, BufferAccessStrategy *strategy) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (reserved_ == 0 && extent_size_ > 1) {
+    next_page_id_ = buffer_pool_manager_->AllocatePages(extent_size_, segment_id_);
+    reserved_ = next_page_id_ == INVALID_PAGE_ID ? 0 : extent_size_;
+  }
+  if (reserved_ == 0) {
+    if (segment_id_ == 0) {
+      return buffer_pool_manager_->NewPageGuarded(page_id, strategy);
+    }
+    // NewPage only allocates in the database file
+    next_page_id_ = buffer_pool_manager_->AllocatePages(1, segment_id_);
+    if (next_page_id_ == INVALID_PAGE_ID) {
+      return PageGuard();
+    }
+    reserved_ = 1;
+  }
+  // the page stays reserved if every frame is pinned
+  Page *page = buffer_pool_manager_->NewPageAt(next_page_id_, strategy);
+  if (page == nullptr) {
+    return PageGuard();
+  }
+  page_id = next_page_id_++;
+  reserved_--;
+  return PageGuard(buffer_pool_manager_, page);
+}
+
+void ExtentAllocator::Release() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (reserved_ > 0) {
+    buffer_pool_manager_->DeallocatePages(next_page_id_, reserved_);
+    reserved_ = 0;
+  }
+}
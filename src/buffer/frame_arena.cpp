@@ -0,0 +1,79 @@
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+/**
+ * Reserve size bytes of zero filled memory aligned to alignment, without committing any of it.
+ */
+static char *ReserveRegion(size_t size, size_t alignment) {
+  size_t map_size = size + alignment;
+  void *region = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (region == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  // the slack mapped for the alignment is given back right away
+  auto start = reinterpret_cast<uintptr_t>(region);
+  uintptr_t aligned = (start + alignment - 1) & ~(alignment - 1);
+  if (aligned > start) {
+    munmap(region, aligned - start);
+  }
+  size_t tail = start + map_size - (aligned + size);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void *>(aligned + size), tail);
+  }
+  return reinterpret_cast<char *>(aligned);
+}
+
+FrameArena::FrameArena(size_t num_frames, size_t capacity)
+    : num_frames_(num_frames), capacity_(std::max(num_frames, capacity)) {
+  // The region is huge page aligned and rounded up, so that it can be backed by huge pages once the pool is large
+  // enough. Untouched parts of the reservation cost no memory.
+  data_size_ = (std::max<size_t>(capacity_, 1) * PAGE_SIZE + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  data_ = ReserveRegion(data_size_, HUGE_PAGE_SIZE);
+  AdviseHugePages();
+
+  // descriptors live in their own reservation, so that growing never moves a descriptor a caller points to
+  static_assert(alignof(Page) <= PAGE_SIZE, "mmap only guarantees page alignment");
+  frames_size_ = std::max<size_t>(capacity_ * sizeof(Page), 1);
+  frames_ = reinterpret_cast<Page *>(ReserveRegion(frames_size_, PAGE_SIZE));
+  for (size_t i = 0; i < num_frames_; i++) {
+    new (&frames_[i]) Page(data_ + i * PAGE_SIZE);
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    frames_[i].~Page();
+  }
+  munmap(frames_, frames_size_);
+  munmap(data_, data_size_);
+}
+
+void FrameArena::Resize(size_t num_frames) {
+  ASSERT(num_frames <= capacity_, "Frame arena capacity exceeded.");
+  for (size_t i = num_frames_; i < num_frames; i++) {
+    new (&frames_[i]) Page(data_ + i * PAGE_SIZE);
+  }
+  for (size_t i = num_frames; i < num_frames_; i++) {
+    frames_[i].~Page();
+  }
+  if (num_frames < num_frames_) {
+    // anonymous memory reads back as zeros after MADV_DONTNEED, regrown frames need no reset either
+    madvise(data_ + num_frames * PAGE_SIZE, (num_frames_ - num_frames) * PAGE_SIZE, MADV_DONTNEED);
+  }
+  num_frames_ = num_frames;
+  AdviseHugePages();
+}
+
+void FrameArena::AdviseHugePages() {
+#ifdef MADV_HUGEPAGE
+  // small pools would pay a whole huge page for a few frames
+  if (!huge_pages_ && num_frames_ * PAGE_SIZE >= HUGE_PAGE_SIZE) {
+    huge_pages_ = madvise(data_, data_size_, MADV_HUGEPAGE) == 0;
+  }
+#endif
+}
@@ -0,0 +1,85 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : k_(k), correlated_period_(correlated_period), frames_(num_pages) {
+  ASSERT(k_ > 0, "LRU-K needs at least one access per frame.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+LRUKReplacer::EvictionKey LRUKReplacer::GetKey(frame_id_t frame_id) const {
+  const FrameEntry &entry = frames_[frame_id];
+  uint64_t oldest = entry.history_.empty() ? 0 : entry.history_.front();
+  return {entry.history_.size() >= k_, oldest, frame_id};
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if (evictable_.empty()) {
+    return false;
+  }
+  *frame_id = std::get<2>(*evictable_.begin());
+  evictable_.erase(evictable_.begin());
+  frames_[*frame_id] = FrameEntry();
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (!entry.evictable_) {
+    return;
+  }
+  evictable_.erase(GetKey(frame_id));
+  entry.evictable_ = false;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.evictable_) {
+    return;
+  }
+  entry.evictable_ = true;
+  evictable_.insert(GetKey(frame_id));
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.evictable_) {
+    evictable_.erase(GetKey(frame_id));
+  }
+  if (entry.page_id_ != page_id) {
+    entry.page_id_ = page_id;
+    entry.history_.clear();
+  }
+  uint64_t now = current_timestamp_++;
+  if (!entry.history_.empty() && now - entry.history_.back() <= correlated_period_) {
+    // a correlated access only refreshes the latest one
+    entry.history_.back() = now;
+  } else {
+    entry.history_.push_back(now);
+    if (entry.history_.size() > k_) {
+      entry.history_.pop_front();
+    }
+  }
+  if (entry.evictable_) {
+    evictable_.insert(GetKey(frame_id));
+  }
+}
+
+std::vector<frame_id_t> LRUKReplacer::GetEvictionOrder() {
+  std::vector<frame_id_t> order;
+  for (auto &key : evictable_) {
+    order.push_back(std::get<2>(key));
+  }
+  return order;
+}
+
+size_t LRUKReplacer::Size() { return evictable_.size(); }
+
+void LRUKReplacer::Resize(size_t num_pages) {
+  for (size_t i = num_pages; i < frames_.size(); i++) {
+    Pin(static_cast<frame_id_t>(i));
+  }
+  frames_.resize(num_pages);
+}
@@ -47,9 +47,25 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
     cache[frame_id] = lru_list_.begin();
 }
 
+std::vector<frame_id_t> LRUReplacer::GetEvictionOrder() {
+    return std::vector<frame_id_t>(lru_list_.rbegin(), lru_list_.rend());
+}
+
 /**
  * TODO: Student Implement
  */
 size_t LRUReplacer::Size() {
     return lru_list_.size();
-}
\ No newline at end of file
+}
+
+void LRUReplacer::Resize(size_t num_pages) {
+    for (auto it = lru_list_.begin(); it != lru_list_.end();) {
+        if (static_cast<size_t>(*it) >= num_pages) {
+            cache.erase(*it);
+            it = lru_list_.erase(it);
+        } else {
+            it++;
+        }
+    }
+    capacity = num_pages;
+}
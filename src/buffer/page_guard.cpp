@@ -0,0 +1,139 @@
+#include "buffer/page_guard.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+
+PageGuard::PageGuard(PageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_), scope_latched_(that.scope_latched_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+  that.scope_latched_ = false;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    scope_latched_ = that.scope_latched_;
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+    that.scope_latched_ = false;
+  }
+  return *this;
+}
+
+void PageGuard::Drop() {
+  if (page_ != nullptr) {
+    if (scope_latched_) {
+      PageWriteScope::Release(page_);
+    }
+    bpm_->UnpinFrame(page_, is_dirty_);
+  }
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+  scope_latched_ = false;
+}
+
+void PageGuard::SetDirty() {
+  is_dirty_ = true;
+  if (!scope_latched_) {
+    scope_latched_ = PageWriteScope::Acquire(page_);
+  }
+}
+
+ReadPageGuard PageGuard::UpgradeRead() {
+  ReadPageGuard read_guard;
+  if (page_ != nullptr) {
+    page_->RLatch();
+    read_guard.guard_ = std::move(*this);
+  }
+  return read_guard;
+}
+
+WritePageGuard PageGuard::UpgradeWrite() {
+  WritePageGuard write_guard;
+  if (page_ != nullptr) {
+    page_->WLatch();
+    write_guard.guard_ = std::move(*this);
+  }
+  return write_guard;
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (guard_.IsValid()) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop();
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (guard_.IsValid()) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop();
+}
+
+PageWriteScope::PageWriteScope() : prev_(current_) { current_ = this; }
+
+PageWriteScope::~PageWriteScope() {
+  // guards declared after the scope are gone already, anything left was moved out of it
+  for (auto &entry : latched_) {
+    entry.first->WUnlatch();
+  }
+  current_ = prev_;
+}
+
+bool PageWriteScope::Acquire(Page *page) {
+  PageWriteScope *scope = current_;
+  if (scope == nullptr) {
+    return false;
+  }
+  for (auto &entry : scope->latched_) {
+    if (entry.first == page) {
+      entry.second++;
+      return true;
+    }
+  }
+  page->WLatch();
+  scope->latched_.emplace_back(page, 1);
+  return true;
+}
+
+void PageWriteScope::Release(Page *page) {
+  PageWriteScope *scope = current_;
+  if (scope == nullptr) {
+    return;
+  }
+  auto &latched = scope->latched_;
+  auto it = std::find_if(latched.begin(), latched.end(), [page](const auto &entry) { return entry.first == page; });
+  if (it == latched.end()) {
+    return;
+  }
+  if (--it->second == 0) {
+    page->WUnlatch();
+    latched.erase(it);
+  }
+}
@@ -0,0 +1,233 @@
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager) {
+  ASSERT(num_instances > 0, "Buffer pool needs at least one instance.");
+  pool_size_ = pool_size;
+  for (size_t i = 0; i < num_instances; i++) {
+    // spread the remainder over the first instances so that no frame is lost
+    size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    instances_.emplace_back(new BufferPoolManager(instance_size, disk_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // the prefetcher loads pages into the instances
+  StopPrefetcher();
+  SaveWorkingSet();
+  FlushAllPages();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetInstance(page_id)->FetchPage(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+/**
+ * The frame belongs to the instance that owns its page id, the page cannot change while it is pinned.
+ */
+bool ParallelBufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+  return GetInstance(page->GetPageId())->UnpinFrame(page, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) { return GetInstance(page_id)->FlushPage(page_id); }
+
+/**
+ * Adjacent pages are cached by different instances, so the dirty frames of all of them are written back together.
+ */
+void ParallelBufferPoolManager::FlushAllPages() {
+  std::vector<WriteBackFrame> frames;
+  for (auto instance : instances_) {
+    instance->CollectDirtyFrames(frames);
+  }
+  if (frames.empty()) {
+    return;
+  }
+  WriteBackFrames(disk_manager_, frames, false);
+  disk_manager_->Sync();
+}
+
+/**
+ * The page id decides which instance caches the page, so the id is allocated first. If the owning instance has
+ * every frame pinned, the id is kept reserved and the next one is tried, so that a full instance does not fail the
+ * call while the others have room. The skipped ids are given back once a page is created or every instance failed.
+ */
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id, BufferAccessStrategy *strategy) {
+  std::vector<page_id_t> skipped;
+  std::vector<bool> full(instances_.size(), false);
+  size_t full_count = 0;
+  Page *page = nullptr;
+  // free page ids are handed out lowest first, so a few rounds reach every instance unless the free ids are sparse
+  for (size_t attempt = 0; attempt < NEW_PAGE_ROUNDS * instances_.size() && full_count < instances_.size();
+       attempt++) {
+    page_id_t new_page_id = disk_manager_->AllocatePage();
+    size_t index = new_page_id % instances_.size();
+    if (!full[index]) {
+      page = instances_[index]->NewPageAt(new_page_id, strategy);
+      if (page != nullptr) {
+        page_id = new_page_id;
+        break;
+      }
+      full[index] = true;
+      full_count++;
+    }
+    skipped.push_back(new_page_id);
+  }
+  for (auto skipped_page_id : skipped) {
+    disk_manager_->DeAllocatePage(skipped_page_id);
+  }
+  return page;
+}
+
+Page *ParallelBufferPoolManager::NewPageAt(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetInstance(page_id)->NewPageAt(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) { return GetInstance(page_id)->DeletePage(page_id); }
+
+/**
+ * The pages of a segment are spread over all instances.
+ */
+bool ParallelBufferPoolManager::DropSegment(segment_id_t segment_id) {
+  if (segment_id == 0) {
+    return false;
+  }
+  for (auto instance : instances_) {
+    lock_guard<recursive_mutex> guard(instance->latch_);
+    instance->DiscardSegment(segment_id);
+  }
+  return disk_manager_->DropSegment(segment_id);
+}
+
+bool ParallelBufferPoolManager::CheckAllUnpinned() {
+  bool res = true;
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
+  }
+  return res;
+}
+
+/**
+ * The frames are spread over the instances like in the constructor. An instance that cannot shrink keeps its size,
+ * the others are resized anyway, so the pool size afterwards is the sum of what the instances ended up with.
+ */
+bool ParallelBufferPoolManager::Resize(size_t pool_size, uint32_t timeout_ms) {
+  size_t num_instances = instances_.size();
+  if (pool_size < num_instances || pool_size > GetMaxPoolSize()) {
+    return false;
+  }
+  bool res = true;
+  pool_size_ = 0;
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    res = instances_[i]->Resize(instance_size, timeout_ms) && res;
+    pool_size_ += instances_[i]->GetPoolSize();
+  }
+  return res;
+}
+
+size_t ParallelBufferPoolManager::GetMaxPoolSize() const {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetMaxPoolSize();
+  }
+  return res;
+}
+
+void ParallelBufferPoolManager::StartBackgroundFlusher(double dirty_watermark, uint32_t interval_ms) {
+  for (auto instance : instances_) {
+    instance->StartBackgroundFlusher(dirty_watermark, interval_ms);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundFlusher() {
+  for (auto instance : instances_) {
+    instance->StopBackgroundFlusher();
+  }
+}
+
+void ParallelBufferPoolManager::PauseBackgroundIo() {
+  BufferPoolManager::PauseBackgroundIo();
+  for (auto instance : instances_) {
+    instance->PauseBackgroundIo();
+  }
+}
+
+void ParallelBufferPoolManager::ResumeBackgroundIo() {
+  for (auto instance : instances_) {
+    instance->ResumeBackgroundIo();
+  }
+}
+
+uint64_t ParallelBufferPoolManager::GetForegroundWriteBacks() const {
+  uint64_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetForegroundWriteBacks();
+  }
+  return res;
+}
+
+uint64_t ParallelBufferPoolManager::GetBackgroundWriteBacks() const {
+  uint64_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetBackgroundWriteBacks();
+  }
+  return res;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() const {
+  BufferPoolStats res;
+  for (auto instance : instances_) {
+    res += instance->GetStats();
+  }
+  return res;
+}
+
+std::unordered_map<uint64_t, BufferPoolStats> ParallelBufferPoolManager::GetOwnerStats() {
+  std::unordered_map<uint64_t, BufferPoolStats> res;
+  for (auto instance : instances_) {
+    for (const auto &owner : instance->GetOwnerStats()) {
+      res[owner.first] += owner.second;
+    }
+  }
+  return res;
+}
+
+/**
+ * Prefetching runs here rather than in the instances: adjacent pages belong to different instances, and only one
+ * prefetcher seeing all of them can read a run with one I/O.
+ */
+Page *ParallelBufferPoolManager::BeginLoad(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetInstance(page_id)->BeginLoad(page_id, strategy);
+}
+
+void ParallelBufferPoolManager::FinishLoad(Page *page) { GetInstance(page->GetPageId())->FinishLoad(page); }
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetWorkingSet() {
+  std::vector<std::vector<page_id_t>> lists;
+  size_t longest = 0;
+  for (auto instance : instances_) {
+    lists.push_back(instance->GetWorkingSet());
+    longest = std::max(longest, lists.back().size());
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t rank = 0; rank < longest; rank++) {
+    for (auto &list : lists) {
+      if (rank < list.size()) {
+        page_ids.push_back(list[rank]);
+      }
+    }
+  }
+  return page_ids;
+}
+
+bool ParallelBufferPoolManager::IsPageResident(page_id_t page_id) { return GetInstance(page_id)->IsPageResident(page_id); }
@@ -0,0 +1,20 @@
+#include "buffer/replacer.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+
+Replacer *Replacer::Create(ReplacerType type, size_t num_pages) {
+  switch (type) {
+    case ReplacerType::kClock:
+      return new CLOCKReplacer(num_pages);
+    case ReplacerType::kLRUK:
+      return new LRUKReplacer(num_pages);
+    case ReplacerType::kARC:
+      return new ARCReplacer(num_pages);
+    case ReplacerType::kLRU:
+    default:
+      return new LRUReplacer(num_pages);
+  }
+}
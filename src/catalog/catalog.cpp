@@ -138,7 +138,9 @@ CatalogManager::~CatalogManager() {
 dberr_t CatalogManager::CreateTable(const string &table_name,
                                     TableSchema *schema,
                                     Txn *txn,
-                                    TableInfo *&table_info) {
+                                    TableInfo *&table_info,
+                                    bool compressed) {
+    std::scoped_lock<std::mutex> lock(tables_latch_);
     // 1) pick a new table ID
     table_id_t table_id = next_table_id_.fetch_add(1);
 
@@ -152,12 +154,15 @@ dberr_t CatalogManager::CreateTable(const string &table_name,
     // 3) deep-copy the schema
     auto schema_copy = Schema::DeepCopySchema(schema);
 
-    // 4) create the *data* heap — this will internally call NewPage + Init()
+    // 4) create the *data* heap — this will internally call NewPage + Init(), in a segment file of its own so that
+    //    dropping the table only removes the file
     auto *heap = TableHeap::Create(buffer_pool_manager_,
                                    schema_copy,
                                    txn,
                                    log_manager_,
-                                   lock_manager_);
+                                   lock_manager_,
+                                   TABLE_HEAP_EXTENT_SIZE,
+                                   buffer_pool_manager_->CreateSegment(compressed));
     // now heap->GetFirstPageId() is a fully Init()’d page
     page_id_t first_data_page = heap->GetFirstPageId();
 
@@ -165,7 +170,9 @@ dberr_t CatalogManager::CreateTable(const string &table_name,
     auto *tbl_meta = TableMetadata::Create(table_id,
                                            table_name,
                                            first_data_page,
-                                           schema_copy);
+                                           schema_copy,
+                                           heap->GetExtentSize(),
+                                           heap->GetFreeSpaceMapPageId());
 
     // 6) serialize that metadata out to the catalog page
     tbl_meta->SerializeTo(meta_page->GetData());
@@ -242,6 +249,25 @@ dberr_t CatalogManager::GetTables(vector<TableInfo *> &tables) const {
     return DB_SUCCESS;
 }
 
+void CatalogManager::PinTables(vector<TableInfo *> &tables) {
+  std::scoped_lock<std::mutex> lock(tables_latch_);
+  for (auto &pr : tables_) {
+    table_pins_[pr.first]++;
+    tables.push_back(pr.second);
+  }
+}
+
+void CatalogManager::UnpinTable(TableInfo *table_info) {
+  {
+    std::scoped_lock<std::mutex> lock(tables_latch_);
+    auto it = table_pins_.find(table_info->GetTableId());
+    ASSERT(it != table_pins_.end(), "Unpin a table that is not pinned.");
+    if (--it->second > 0) return;
+    table_pins_.erase(it);
+  }
+  tables_unpinned_.notify_all();
+}
+
 /**
  * TODO: Student Implement
  */
@@ -286,7 +312,8 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     }
 
     // 4) 创建索引元数据
-    IndexMetadata *idx_meta = IndexMetadata::Create(index_id, index_name, table_id, key_map);
+    IndexMetadata *idx_meta = IndexMetadata::Create(index_id, index_name, table_id, key_map, INDEX_EXTENT_SIZE,
+                                                    buffer_pool_manager_->CreateSegment());
     // 5) 创建索引信息
     index_info = IndexInfo::Create();
     index_info->Init(idx_meta, table_info, buffer_pool_manager_);
@@ -309,7 +336,9 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     // 原表完整的 schema
     const Schema *orig_schema = table_info->GetSchema();
 
-    for (TableIterator it_table = table_heap->Begin(txn);
+    // 全表扫描使用 bulk read 策略，避免把缓冲池中的热点页换出
+    auto scan_strategy = std::make_shared<BufferAccessStrategy>(AccessStrategyType::kBulkRead);
+    for (TableIterator it_table = table_heap->Begin(txn, scan_strategy);
          it_table != table_heap->End();
          ++it_table) {
         // operator*() 返回当前行的 Row
@@ -364,6 +393,12 @@ dberr_t CatalogManager::GetTableIndexes(const std::string &table_name, std::vect
  * TODO: Student Implement
  */
 dberr_t CatalogManager::DropTable(const string &table_name) {
+    std::unique_lock<std::mutex> lock(tables_latch_);
+    // 0) wait until no background work has the table pinned
+    tables_unpinned_.wait(lock, [&] {
+      auto pinned = table_names_.find(table_name);
+      return pinned == table_names_.end() || table_pins_.count(pinned->second) == 0;
+    });
     // 1) 查找表 ID
     auto it = table_names_.find(table_name);
     if (it == table_names_.end()) return DB_FAILED;
@@ -437,7 +472,8 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
     if (it3 == indexes_.end()) return DB_FAILED;
     IndexInfo *index_info = it3->second;
 
-    // 3) 删除索引信息
+    // 3) 删除索引信息, an index with a segment file of its own gives back its pages by removing the file
+    index_info->GetIndex()->Destroy();
     delete index_info;
     indexes_.erase(it3);
     index_names_[table_name].erase(it2);
@@ -480,12 +516,14 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
     TableMetadata::DeserializeFrom(page->GetData(), tbl_meta);
     buffer_pool_manager_->UnpinPage(page_id, /*is_dirty=*/false);
 
-    // 2) 基于 metadata 和 page_id 构造 TableHeap
+    // 2) 基于 metadata 构造 TableHeap, the heap starts at its first data page, not at the metadata page
     TableHeap *heap = TableHeap::Create(buffer_pool_manager_,
-                                        page_id,
+                                        tbl_meta->GetFirstPageId(),
                                         tbl_meta->GetSchema(),
                                         log_manager_,
-                                        lock_manager_);
+                                        lock_manager_,
+                                        tbl_meta->GetExtentSize(),
+                                        tbl_meta->GetFreeSpaceMapPageId());
 
     // 3) 包装成 TableInfo 并保存到 maps
     TableInfo *tbl_info = TableInfo::Create();
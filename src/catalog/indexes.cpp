@@ -1,12 +1,17 @@
 #include "catalog/indexes.h"
 
 IndexMetadata::IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                             const std::vector<uint32_t> &key_map)
-    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map) {}
+                             const std::vector<uint32_t> &key_map, uint32_t extent_size, segment_id_t segment_id)
+    : index_id_(index_id),
+      index_name_(index_name),
+      table_id_(table_id),
+      key_map_(key_map),
+      extent_size_(extent_size),
+      segment_id_(segment_id) {}
 
 IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &index_name, const table_id_t table_id,
-                                     const vector<uint32_t> &key_map) {
-  return new IndexMetadata(index_id, index_name, table_id, key_map);
+                                     const vector<uint32_t> &key_map, uint32_t extent_size, segment_id_t segment_id) {
+  return new IndexMetadata(index_id, index_name, table_id, key_map, extent_size, segment_id);
 }
 
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
@@ -14,7 +19,7 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize index info.");
   // magic num
-  MACH_WRITE_UINT32(buf, INDEX_METADATA_MAGIC_NUM);
+  MACH_WRITE_UINT32(buf, INDEX_METADATA_SEGMENT_MAGIC_NUM);
   buf += 4;
   // index id
   MACH_WRITE_TO(index_id_t, buf, index_id_);
@@ -35,6 +40,12 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
     MACH_WRITE_UINT32(buf, col_index);
     buf += 4;
   }
+  // extent size
+  MACH_WRITE_UINT32(buf, extent_size_);
+  buf += 4;
+  // segment id
+  MACH_WRITE_UINT32(buf, segment_id_);
+  buf += 4;
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
   return ofs;
 }
@@ -43,7 +54,7 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
  * TODO: Student Implement
  */
 uint32_t IndexMetadata::GetSerializedSize() const {
-    uint32_t size = 4 + 4 + MACH_STR_SERIALIZED_SIZE(index_name_) + 4 + 4;
+    uint32_t size = 4 + 4 + MACH_STR_SERIALIZED_SIZE(index_name_) + 4 + 4 + 4 + 4;
     for (auto &col_index : key_map_) {
         size += 4;
     }
@@ -58,7 +69,9 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info.");
+  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM || magic_num == INDEX_METADATA_EXTENT_MAGIC_NUM ||
+             magic_num == INDEX_METADATA_SEGMENT_MAGIC_NUM,
+         "Failed to deserialize index info.");
   // index id
   index_id_t index_id = MACH_READ_FROM(index_id_t, buf);
   buf += 4;
@@ -80,8 +93,20 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     buf += 4;
     key_map.push_back(key_index);
   }
+  // extent size, older metadata has none
+  uint32_t extent_size = INDEX_EXTENT_SIZE;
+  if (magic_num != INDEX_METADATA_MAGIC_NUM) {
+    extent_size = MACH_READ_UINT32(buf);
+    buf += 4;
+  }
+  // segment id, older indexes live in the database file
+  segment_id_t segment_id = 0;
+  if (magic_num == INDEX_METADATA_SEGMENT_MAGIC_NUM) {
+    segment_id = MACH_READ_UINT32(buf);
+    buf += 4;
+  }
   // allocate space for index meta data
-  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map, extent_size, segment_id);
   return buf - p;
 }
 
@@ -116,5 +141,6 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager, meta_data_->extent_size_,
+                            meta_data_->segment_id_);
 }
@@ -3,16 +3,22 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, ReplacerType replacer_type, bool direct_io,
+                                 bool background_prewarm)
     : db_file_name_(std::move(db_name)), init_(init) {
   // Init database file if needed
   db_file_name_ = "./databases/" + db_file_name_;
   if (init_) {
-    remove(db_file_name_.c_str());
+    DiskManager::RemoveFiles(db_file_name_);
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, direct_io);
+  if (buffer_pool_instances > 1) {
+    bpm_ = new ParallelBufferPoolManager(buffer_pool_instances, buffer_pool_size, disk_mgr_, replacer_type);
+  } else {
+    bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, replacer_type);
+  }
 
   // Allocate static page for db storage engine
   if (init) {
@@ -37,11 +43,17 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
   } else {
     ASSERT(!bpm_->IsPageFree(CATALOG_META_PAGE_ID), "Invalid catalog meta page.");
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
+    // the pages cached at the last shutdown, instead of refilling the pool one miss at a time
+    bpm_->Prewarm(DiskManager::WorkingSetFileName(db_file_name_), background_prewarm);
   }
+  bpm_->SetWorkingSetFile(DiskManager::WorkingSetFileName(db_file_name_));
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  bpm_->StartBackgroundFlusher();
+  StartVacuumWorker();
 }
 
 DBStorageEngine::~DBStorageEngine() {
+  StopVacuumWorker();
   delete catalog_mgr_;
   delete bpm_;
   delete disk_mgr_;
@@ -50,3 +62,58 @@ DBStorageEngine::~DBStorageEngine() {
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Txn *txn) {
   return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
 }
+
+void DBStorageEngine::StartVacuumWorker(uint32_t interval_ms) {
+  StopVacuumWorker();
+  vacuum_stop_ = false;
+  vacuum_interval_ms_ = interval_ms;
+  vacuum_worker_ = std::thread([this, interval_ms]() {
+    std::unique_lock<std::mutex> lock(vacuum_mutex_);
+    while (!vacuum_stop_) {
+      vacuum_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms));
+      if (vacuum_stop_) break;
+      lock.unlock();
+      VacuumTables();
+      lock.lock();
+    }
+  });
+}
+
+void DBStorageEngine::StopVacuumWorker() {
+  {
+    std::lock_guard<std::mutex> lock(vacuum_mutex_);
+    vacuum_stop_ = true;
+  }
+  vacuum_cv_.notify_all();
+  if (vacuum_worker_.joinable()) {
+    vacuum_worker_.join();
+  }
+}
+
+size_t DBStorageEngine::VacuumTables(bool all) {
+  std::vector<TableInfo *> tables;
+  catalog_mgr_->PinTables(tables);
+  size_t reclaimed = 0;
+  for (auto table : tables) {
+    TableHeap *table_heap = table->GetTableHeap();
+    if (table_heap != nullptr && (all || table_heap->NeedsVacuum())) {
+      reclaimed += table_heap->Vacuum();
+    }
+    catalog_mgr_->UnpinTable(table);
+  }
+  return reclaimed;
+}
+
+size_t DBStorageEngine::Shrink() {
+  bool vacuum_running = vacuum_worker_.joinable();
+  StopVacuumWorker();
+  bpm_->PauseBackgroundIo();
+  // pages in use keep their place, so the buffer pool stays valid, it only has to be written back first
+  bpm_->FlushAllPages();
+  size_t released = disk_mgr_->Shrink();
+  bpm_->ResumeBackgroundIo();
+  if (vacuum_running) {
+    StartVacuumWorker(vacuum_interval_ms_);
+  }
+  return released;
+}
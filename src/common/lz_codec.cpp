@@ -0,0 +1,146 @@
+#include "common/lz_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr int HASH_BITS = 12;
+
+uint32_t Read32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+/** Write the part of a length that did not fit into its nibble of 15. */
+bool WriteLength(size_t length, char *&out, const char *end) {
+  for (; length >= 255; length -= 255) {
+    if (out == end) {
+      return false;
+    }
+    *out++ = static_cast<char>(255);
+  }
+  if (out == end) {
+    return false;
+  }
+  *out++ = static_cast<char>(length);
+  return true;
+}
+
+bool ReadLength(const uint8_t *&in, const uint8_t *end, size_t &length) {
+  uint8_t byte;
+  do {
+    if (in == end) {
+      return false;
+    }
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Write one sequence, match_length 0 for the last one, which has literals only. */
+bool WriteSequence(const char *literals, size_t literal_count, size_t offset, size_t match_length, char *&out,
+                   const char *end) {
+  if (out == end) {
+    return false;
+  }
+  size_t match_code = match_length == 0 ? 0 : match_length - LzCodec::MIN_MATCH;
+  *out++ = static_cast<char>((literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15));
+  if (literal_count >= 15 && !WriteLength(literal_count - 15, out, end)) {
+    return false;
+  }
+  if (static_cast<size_t>(end - out) < literal_count) {
+    return false;
+  }
+  memcpy(out, literals, literal_count);
+  out += literal_count;
+  if (match_length == 0) {
+    return true;
+  }
+  if (end - out < 2) {
+    return false;
+  }
+  *out++ = static_cast<char>(offset & 0xff);
+  *out++ = static_cast<char>(offset >> 8);
+  return match_code < 15 || WriteLength(match_code - 15, out, end);
+}
+
+}  // namespace
+
+size_t LzCodec::Compress(const char *src, size_t src_len, char *dst, size_t dst_capacity) {
+  // positions plus one of the last sequence with each hash, 0 for none
+  uint32_t table[1 << HASH_BITS];
+  memset(table, 0, sizeof(table));
+  char *out = dst;
+  const char *end = dst + dst_capacity;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= src_len) {
+    uint32_t sequence = Read32(src + pos);
+    uint32_t hash = Hash(sequence);
+    size_t candidate = table[hash];
+    table[hash] = pos + 1;
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || Read32(src + candidate - 1) != sequence) {
+      pos++;
+      continue;
+    }
+    size_t match = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (pos + length < src_len && src[match + length] == src[pos + length]) {
+      length++;
+    }
+    if (!WriteSequence(src + anchor, pos - anchor, pos - match, length, out, end)) {
+      return 0;
+    }
+    pos += length;
+    anchor = pos;
+  }
+  if (!WriteSequence(src + anchor, src_len - anchor, 0, 0, out, end)) {
+    return 0;
+  }
+  return out - dst;
+}
+
+bool LzCodec::Decompress(const char *src, size_t src_len, char *dst, size_t dst_len) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *in_end = in + src_len;
+  size_t out = 0;
+  while (in < in_end) {
+    uint8_t token = *in++;
+    size_t literal_count = token >> 4;
+    if (literal_count == 15 && !ReadLength(in, in_end, literal_count)) {
+      return false;
+    }
+    if (literal_count > static_cast<size_t>(in_end - in) || literal_count > dst_len - out) {
+      return false;
+    }
+    memcpy(dst + out, in, literal_count);
+    in += literal_count;
+    out += literal_count;
+    // the last sequence has no match
+    if (in == in_end) {
+      break;
+    }
+    if (in_end - in < 2) {
+      return false;
+    }
+    size_t offset = in[0] | in[1] << 8;
+    in += 2;
+    size_t length = (token & 15) + MIN_MATCH;
+    if ((token & 15) == 15 && !ReadLength(in, in_end, length)) {
+      return false;
+    }
+    if (offset == 0 || offset > out || length > dst_len - out) {
+      return false;
+    }
+    // byte by byte, a match may overlap the bytes it produces
+    for (size_t i = 0; i < length; i++, out++) {
+      dst[out] = dst[out - offset];
+    }
+  }
+  return out == dst_len;
+}
@@ -1,6 +1,7 @@
 #include "concurrency/txn_manager.h"
 
 #include "concurrency/lock_manager.h"
+#include "storage/table_heap.h"
 
 TxnManager::TxnManager(LockManager *lock_mgr) : lock_mgr_(lock_mgr) { lock_mgr_->SetTxnMgr(this); }
 
@@ -16,6 +17,12 @@ Txn *TxnManager::Begin(Txn *txn, IsolationLevel isolationLevel) {
 void TxnManager::Commit(Txn *txn) {
   // change state
   txn->SetState(TxnState::kCommitted);
+  // apply the deletes, nothing can roll them back anymore
+  std::vector<Txn::DeleteRecord> delete_set;
+  delete_set.swap(txn->GetDeleteSet());
+  for (auto &record : delete_set) {
+    record.table_heap_->ApplyDelete(record.rid_, txn);
+  }
   // release all locks
   ReleaseLocks(txn);
 }
@@ -23,6 +30,12 @@ void TxnManager::Commit(Txn *txn) {
 void TxnManager::Abort(Txn *txn) {
   // change state
   txn->SetState(TxnState::kAborted);
+  // roll the deletes back, the latest first
+  std::vector<Txn::DeleteRecord> delete_set;
+  delete_set.swap(txn->GetDeleteSet());
+  for (auto it = delete_set.rbegin(); it != delete_set.rend(); ++it) {
+    it->table_heap_->RollbackDelete(it->rid_, txn);
+  }
   // release all locks
   ReleaseLocks(txn);
 }
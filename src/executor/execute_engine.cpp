@@ -2,10 +2,14 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <strings.h>
 #include <sys/types.h>
 
 #include <chrono>
 #include <filesystem>
+#include <map>
+#include <set>
+#include <sstream>
 
 #include "common/result_writer.h"
 #include "executor/executors/delete_executor.h"
@@ -40,7 +44,9 @@ ExecuteEngine::ExecuteEngine() {
     while((stdir = readdir(dir)) != nullptr) {
       if( strcmp( stdir->d_name , "." ) == 0 ||
           strcmp( stdir->d_name , "..") == 0 ||
-          stdir->d_name[0] == '.')
+          stdir->d_name[0] == '.' ||
+          strstr(stdir->d_name, ".seg") != nullptr ||  // segment files of a database
+          strstr(stdir->d_name, ".prewarm") != nullptr)  // and its saved working set
         continue;
       dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
     }
@@ -132,6 +138,12 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
             return ExecuteDropTable(ast, context.get());
         case kNodeShowIndexes:
             return ExecuteShowIndexes(ast, context.get());
+        case kNodeShowStatus:
+            return ExecuteShowStatus(ast, context.get());
+        case kNodeSetVariable:
+            return ExecuteSetVariable(ast, context.get());
+        case kNodeVacuum:
+            return ExecuteVacuum(ast, context.get());
         case kNodeCreateIndex:
             return ExecuteCreateIndex(ast, context.get());
         case kNodeDropIndex:
@@ -256,7 +268,18 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
     if (dbs_.find(db_name) != dbs_.end()) {
         return DB_ALREADY_EXIST;
     }
-    dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true)));
+    // CREATE DATABASE name USING direct_io bypasses the OS page cache
+    bool direct_io = false;
+    if (ast->child_->next_ != nullptr) {
+        string option = ast->child_->next_->val_;
+        if (strcasecmp(option.c_str(), "direct_io") != 0) {
+            cout << "Unknown database option '" << option << "'" << endl;
+            return DB_FAILED;
+        }
+        direct_io = true;
+    }
+    dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true, DEFAULT_BUFFER_POOL_SIZE,
+                                                       DEFAULT_BUFFER_POOL_INSTANCES, ReplacerType::kLRU, direct_io)));
     return DB_SUCCESS;
 }
 
@@ -268,9 +291,10 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
     if (dbs_.find(db_name) == dbs_.end()) {
         return DB_NOT_EXIST;
     }
-    remove(("./databases/" + db_name).c_str());
     delete dbs_[db_name];
+    DiskManager::RemoveFiles("./databases/" + db_name);
     dbs_.erase(db_name);
+    status_baselines_.erase(db_name);
     if (db_name == current_db_)
         current_db_ = "";
     return DB_SUCCESS;
@@ -373,6 +397,17 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
 
     auto column_definition_list = ast->child_->next_;
 
+    // CREATE TABLE name (...) USING compression stores the table pages compressed
+    bool compressed = false;
+    if (column_definition_list->next_ != nullptr) {
+        string option = column_definition_list->next_->val_;
+        if (strcasecmp(option.c_str(), "compression") != 0) {
+            cout << "Unknown table option '" << option << "'" << endl;
+            return DB_FAILED;
+        }
+        compressed = true;
+    }
+
     for (auto column = column_definition_list->child_; column != nullptr; column = column->next_) {
 
         if (column->type_ == kNodeColumnDefinition) {
@@ -430,7 +465,7 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
 
     TableSchema * table_schema = new TableSchema(columns);
     Txn * txn;
-    dbs_[current_db_]->catalog_mgr_->CreateTable(table_name, table_schema, txn, table_info);
+    dbs_[current_db_]->catalog_mgr_->CreateTable(table_name, table_schema, txn, table_info, compressed);
     return DB_SUCCESS;
 }
 
@@ -501,6 +536,166 @@ dberr_t ExecuteEngine::ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *conte
     return DB_SUCCESS;
 }
 
+// 1.   "show status reset" snapshots the counters of the current database as the new baseline of this session.
+// 2.   "show status" prints the counters minus the baseline: one total row, then a row for every table and index
+//      that did any work. Owners that no longer exist in the catalog are shown by their id.
+// 3.   Then the dead tuples of every table and what vacuuming reclaimed so far, see TableHeap::GetVacuumStats.
+dberr_t ExecuteEngine::ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+    LOG(INFO) << "ExecuteShowStatus" << std::endl;
+#endif
+    pSyntaxNode what = ast->child_;
+    pSyntaxNode option = what->next_;
+    if (strcasecmp(what->val_, "status") != 0 || (option != nullptr && strcasecmp(option->val_, "reset") != 0)) {
+        cout << "Syntax error: expected SHOW STATUS [RESET]" << endl;
+        return DB_FAILED;
+    }
+    if (current_db_.empty()) {
+        cout << "No database selected" << endl;
+        return DB_FAILED;
+    }
+
+    DBStorageEngine *db = dbs_[current_db_];
+    StatusBaseline now{db->bpm_->GetStats(), db->disk_mgr_->GetIoStats(), db->bpm_->GetOwnerStats(),
+                       db->disk_mgr_->GetOwnerIoStats()};
+    if (option != nullptr) {
+        status_baselines_[current_db_] = std::move(now);
+        cout << "Query OK, status counters reset" << endl;
+        return DB_SUCCESS;
+    }
+    const StatusBaseline &base = status_baselines_[current_db_];
+    // every column as wide as its widest cell
+    auto print_table = [](const vector<string> &header, const vector<vector<string>> &rows) {
+        vector<int> data_width;
+        for (const auto &column : header) data_width.push_back(column.length());
+        for (const auto &row : rows) {
+            for (size_t i = 0; i < row.size(); i++) {
+                data_width[i] = max(data_width[i], int(row[i].length()));
+            }
+        }
+        ResultWriter writer(cout);
+        writer.Divider(data_width);
+        writer.BeginRow();
+        for (size_t i = 0; i < header.size(); i++) {
+            writer.WriteHeaderCell(header[i], data_width[i]);
+        }
+        writer.EndRow();
+        writer.Divider(data_width);
+        for (const auto &row : rows) {
+            writer.BeginRow();
+            for (size_t i = 0; i < row.size(); i++) {
+                writer.WriteCell(row[i], data_width[i]);
+            }
+            writer.EndRow();
+        }
+        writer.Divider(data_width);
+    };
+
+    map<uint64_t, string> owner_names;
+    vector<TableInfo *> tables;
+    db->catalog_mgr_->GetTables(tables);
+    for (auto table : tables) {
+        owner_names[IoOwner::Table(table->GetTableId()).Key()] = table->GetTableName();
+        vector<IndexInfo *> indexes;
+        db->catalog_mgr_->GetTableIndexes(table->GetTableName(), indexes);
+        for (auto index : indexes) {
+            owner_names[IoOwner::Index(index->GetIndexId()).Key()] =
+                    table->GetTableName() + "." + index->GetIndexName();
+        }
+    }
+
+    vector<string> header{"Scope", "Name", "Hits", "Misses", "Hit_ratio", "Evictions", "Write_backs",
+                          "Pages_read", "Pages_written", "Bytes_read", "Bytes_written", "IO_ms"};
+    vector<vector<string>> rows;
+    auto add_row = [&rows](const string &scope, const string &name, const BufferPoolStats &buffer,
+                           const IoStats &io) {
+        uint64_t fetches = buffer.hits_ + buffer.misses_;
+        stringstream ratio, io_ms;
+        ratio << fixed << setprecision(2) << (fetches == 0 ? 0.0 : 100.0 * buffer.hits_ / fetches) << "%";
+        io_ms << fixed << setprecision(3) << io.io_time_ns_ / 1e6;
+        rows.push_back({scope, name, to_string(buffer.hits_), to_string(buffer.misses_), ratio.str(),
+                        to_string(buffer.evictions_), to_string(buffer.dirty_write_backs_), to_string(io.pages_read_),
+                        to_string(io.pages_written_), to_string(io.bytes_read_), to_string(io.bytes_written_),
+                        io_ms.str()});
+    };
+    add_row("total", current_db_, now.buffer_ - base.buffer_, now.io_ - base.io_);
+
+    set<uint64_t> owners;
+    for (const auto &it : now.owner_buffer_) owners.insert(it.first);
+    for (const auto &it : now.owner_io_) owners.insert(it.first);
+    for (auto key : owners) {
+        BufferPoolStats buffer = now.owner_buffer_.count(key) ? now.owner_buffer_.at(key) : BufferPoolStats();
+        IoStats io = now.owner_io_.count(key) ? now.owner_io_.at(key) : IoStats();
+        if (base.owner_buffer_.count(key)) buffer = buffer - base.owner_buffer_.at(key);
+        if (base.owner_io_.count(key)) io = io - base.owner_io_.at(key);
+        if (buffer.hits_ + buffer.misses_ + buffer.dirty_write_backs_ + io.pages_read_ + io.pages_written_ == 0)
+            continue;
+        IoOwner owner = IoOwner::FromKey(key);
+        string name = owner_names.count(key) ? owner_names[key] : "#" + to_string(owner.id_);
+        add_row(owner.kind_ == IoOwner::Kind::kTable ? "table" : "index", name, buffer, io);
+    }
+
+    print_table(header, rows);
+    if (tables.empty()) {
+        return DB_SUCCESS;
+    }
+
+    header = {"Table", "Live_tuples", "Dead_tuples", "Dead_ratio", "Reclaimed_bytes", "Freed_pages", "Vacuums"};
+    rows.clear();
+    for (auto table : tables) {
+        VacuumStats stats = table->GetTableHeap()->GetVacuumStats();
+        stringstream ratio;
+        ratio << fixed << setprecision(2) << 100.0 * stats.GetDeadTupleRatio() << "%";
+        rows.push_back({table->GetTableName(), to_string(stats.live_tuples_), to_string(stats.dead_tuples_),
+                        ratio.str(), to_string(stats.reclaimed_bytes_), to_string(stats.freed_pages_),
+                        to_string(stats.vacuums_)});
+    }
+    print_table(header, rows);
+    return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+    LOG(INFO) << "ExecuteSetVariable" << std::endl;
+#endif
+    string name = ast->child_->val_;
+    string value = ast->child_->next_->val_;
+    if (strcasecmp(name.c_str(), "buffer_pool_size") != 0) {
+        cout << "Unknown system variable '" << name << "'" << endl;
+        return DB_FAILED;
+    }
+    if (current_db_.empty()) {
+        cout << "No database selected" << endl;
+        return DB_FAILED;
+    }
+    BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+    char *end = nullptr;
+    unsigned long long pool_size = strtoull(value.c_str(), &end, 10);
+    if (*end != '\0' || pool_size == 0 || pool_size > bpm->GetMaxPoolSize()) {
+        cout << "buffer_pool_size must be an integer between 1 and " << bpm->GetMaxPoolSize() << endl;
+        return DB_FAILED;
+    }
+    if (!bpm->Resize(pool_size)) {
+        cout << "Buffer pool is busy, resized to " << bpm->GetPoolSize() << " frames" << endl;
+        return DB_FAILED;
+    }
+    cout << "Query OK, buffer pool resized to " << bpm->GetPoolSize() << " frames" << endl;
+    return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+    LOG(INFO) << "ExecuteVacuum" << std::endl;
+#endif
+    if (current_db_.empty()) {
+        cout << "No database selected" << endl;
+        return DB_FAILED;
+    }
+    size_t released = dbs_[current_db_]->Shrink();
+    cout << "Query OK, " << released << " bytes of disk space released" << endl;
+    return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -4,6 +4,11 @@
 
 #include "executor/executors/insert_executor.h"
 
+#include <string>
+#include <unordered_set>
+
+#include "executor/plans/values_plan.h"
+
 InsertExecutor::InsertExecutor(ExecuteContext *exec_ctx, const InsertPlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
     : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
@@ -13,22 +18,75 @@ void InsertExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
   schema_ = table_info_->GetSchema();
   exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->GetTableName(), index_info_);
+  auto values_plan = dynamic_cast<const ValuesPlanNode *>(plan_->GetChildPlan().get());
+  if (values_plan != nullptr && values_plan->GetValues().size() > 1) {
+    bulk_insert_strategy_ = std::make_unique<BufferAccessStrategy>(AccessStrategyType::kBulkWrite);
+  }
 }
 
-bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
+bool InsertExecutor::CheckUniqueKeys(Row &insert_row) {
+    for (auto info: index_info_) {
+        Row key_row;
+        insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
+        std::vector<RowId> result;
+        if (!key_row.GetFields().empty() &&
+            info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
+            std::cout << "key already exists" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// 与逐行插入一样，遇到重复的键就停下: the rows before it are inserted. A key is a duplicate if an index holds it
+// already or an earlier row of the batch has it, the latter compared by the serialized key.
+void InsertExecutor::InsertBatch() {
+    std::vector<Row> rows;
+    std::vector<std::unordered_set<std::string>> batch_keys(index_info_.size());
     Row insert_row;
     RowId insert_rid;
-    if (child_executor_->Next(&insert_row, &insert_rid)) {
-        for (auto info: index_info_) {
+    while (child_executor_->Next(&insert_row, &insert_rid)) {
+        if (!CheckUniqueKeys(insert_row)) break;
+        bool duplicate = false;
+        for (size_t i = 0; i < index_info_.size() && !duplicate; i++) {
             Row key_row;
-            insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
-            std::vector<RowId> result;
-            if (!key_row.GetFields().empty() &&
-                info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
-                std::cout << "key already exists" << std::endl;
-                return false;
-            }
+            insert_row.GetKeyFromRow(schema_, index_info_[i]->GetIndexKeySchema(), key_row);
+            std::string key(key_row.GetSerializedSize(index_info_[i]->GetIndexKeySchema()), '\0');
+            key_row.SerializeTo(&key[0], index_info_[i]->GetIndexKeySchema());
+            duplicate = !batch_keys[i].insert(std::move(key)).second;
         }
+        if (duplicate) {
+            std::cout << "key already exists" << std::endl;
+            break;
+        }
+        rows.push_back(insert_row);
+    }
+    std::vector<RowId> rids;
+    table_info_->GetTableHeap()->InsertTuples(rows, exec_ctx_->GetTransaction(), &rids, bulk_insert_strategy_.get());
+    for (size_t i = 0; i < rids.size(); i++) {
+        Row key_row;
+        for (auto info: index_info_) {  // 更新索引
+            rows[i].GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
+            info->GetIndex()->InsertEntry(key_row, rids[i], exec_ctx_->GetTransaction());
+        }
+    }
+    batch_rows_ = rids.size();
+}
+
+bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
+    if (bulk_insert_strategy_ != nullptr) {
+        if (!batch_inserted_) {
+            InsertBatch();
+            batch_inserted_ = true;
+        }
+        if (batch_rows_reported_ == batch_rows_) return false;
+        batch_rows_reported_++;
+        return true;
+    }
+    Row insert_row;
+    RowId insert_rid;
+    if (child_executor_->Next(&insert_row, &insert_rid)) {
+        if (!CheckUniqueKeys(insert_row)) return false;
         if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
             Row key_row;
             for (auto info: index_info_) {  // 更新索引
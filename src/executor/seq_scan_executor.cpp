@@ -49,7 +49,9 @@ void SeqScanExecutor::Init() {
   auto first_row = table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction());
 //  cout << "SeqScanExecutor::Init() first_row " << first_row->GetRowId().GetPageId() << ", "
 //       << first_row->GetRowId().GetSlotNum() << endl;
-  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
+  // a full pass recycles a small ring of frames, so it does not evict the working set of other queries
+  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction(),
+                                                  std::make_shared<BufferAccessStrategy>(AccessStrategyType::kBulkRead)));
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
 }
@@ -29,7 +29,8 @@ bool UpdateExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
       src_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), src_key_row);
       dest_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), dest_key_row);
       info->GetIndex()->RemoveEntry(src_key_row, src_rid, txn_);
-      info->GetIndex()->InsertEntry(dest_key_row, src_rid, txn_);
+      // an update that does not fit into its page moves the tuple, and a vacuum may give the old slot to another tuple
+      info->GetIndex()->InsertEntry(dest_key_row, dest_row.GetRowId(), txn_);
     }
     return true;
   }
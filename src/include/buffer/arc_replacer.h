@@ -0,0 +1,85 @@
+#ifndef MINISQL_ARC_REPLACER_H
+#define MINISQL_ARC_REPLACER_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+/**
+ * ARCReplacer implements Adaptive Replacement Cache. Resident pages seen once recently live in T1 and pages seen
+ * at least twice in T2. The ids of pages recently evicted from them are remembered in the ghost lists B1 and B2,
+ * and a hit in a ghost list moves the target size of T1 towards the list that would have kept the page.
+ * Pinned frames stay in their list but are skipped when looking for a victim.
+ */
+class ARCReplacer : public Replacer {
+ public:
+  /**
+   * Create a new ARCReplacer.
+   * @param num_pages the maximum number of pages the ARCReplacer will be required to store
+   */
+  explicit ARCReplacer(size_t num_pages);
+
+  ~ARCReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
+  size_t Size() override;
+
+  void Resize(size_t num_pages) override;
+
+  /** @return the current target size of T1 */
+  size_t GetTargetT1Size() const { return target_t1_; }
+
+ private:
+  enum class ListType { kNone, kT1, kT2 };
+
+  struct FrameEntry {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    ListType list_{ListType::kNone};
+    std::list<frame_id_t>::iterator pos_;
+    bool evictable_{false};
+  };
+
+  struct GhostList {
+    std::list<page_id_t> pages_;  // most recently evicted first
+    std::unordered_map<page_id_t, std::list<page_id_t>::iterator> index_;
+
+    bool Erase(page_id_t page_id);
+    void Push(page_id_t page_id);
+    void PopBack();
+  };
+
+  /** Insert a frame at the MRU end of T1 or T2. */
+  void Attach(frame_id_t frame_id, ListType list);
+
+  /** Remove a frame from the list it is in, without remembering its page. */
+  void Detach(frame_id_t frame_id);
+
+  /** Evict the least recently used unpinned frame of a list, its page goes to the matching ghost list. */
+  bool EvictFrom(ListType list, frame_id_t *frame_id);
+
+  /** Keep |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c. */
+  void TrimGhosts();
+
+  size_t capacity_;
+  size_t target_t1_{0};  // the adaptation parameter p
+  size_t num_evictable_{0};
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  GhostList b1_;
+  GhostList b2_;
+  std::vector<FrameEntry> frames_;
+};
+
+#endif  // MINISQL_ARC_REPLACER_H
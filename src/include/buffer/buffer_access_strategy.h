@@ -0,0 +1,58 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+class BufferPoolManager;
+
+/**
+ * Kinds of bulk access that should not push the working set out of the buffer pool.
+ */
+enum class AccessStrategyType {
+  kBulkRead,   // sequential scans, e.g. a full table pass
+  kBulkWrite,  // bulk loads that append many new pages
+};
+
+/**
+ * A BufferAccessStrategy makes the pages an operation reads in miss recycle a small private ring of frames instead
+ * of taking frames from the shared replacer. Once the ring is full, the next miss reuses the frame of the oldest
+ * ring page, as long as nobody pinned it and it still holds that page. Pages that are already resident are used
+ * in place, so hot pages found by a scan stay where they are.
+ *
+ * The strategy keeps one ring per buffer pool instance, each ring is only touched under the latch of its instance.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  /**
+   * @param type the kind of access, it decides the ring size
+   * @param ring_size number of frames per buffer pool instance, 0 to use the default of the type
+   */
+  explicit BufferAccessStrategy(AccessStrategyType type, size_t ring_size = 0);
+
+  AccessStrategyType GetType() const { return type_; }
+
+  size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  struct Ring {
+    std::vector<frame_id_t> frames_;  // INVALID_FRAME_ID for slots not used yet
+    std::vector<page_id_t> pages_;    // page each slot was last filled with
+    size_t next_{0};                  // slot the next miss will use
+  };
+
+  /** @return the ring of frames owned by this strategy in the given buffer pool instance */
+  Ring &GetRing(const BufferPoolManager *owner);
+
+  AccessStrategyType type_;
+  size_t ring_size_;
+  std::mutex rings_latch_;
+  std::unordered_map<const BufferPoolManager *, Ring> rings_;
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
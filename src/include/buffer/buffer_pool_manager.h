@@ -1,36 +1,221 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/frame_arena.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
+#include "buffer/replacer.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/**
+ * Buffer pool activity, in total or for one owner.
+ */
+struct BufferPoolStats {
+    BufferPoolStats &operator+=(const BufferPoolStats &that) {
+        hits_ += that.hits_;
+        misses_ += that.misses_;
+        evictions_ += that.evictions_;
+        dirty_write_backs_ += that.dirty_write_backs_;
+        return *this;
+    }
+
+    /** @return the activity since that snapshot was taken */
+    BufferPoolStats operator-(const BufferPoolStats &that) const {
+        return {hits_ - that.hits_, misses_ - that.misses_, evictions_ - that.evictions_,
+                dirty_write_backs_ - that.dirty_write_backs_};
+    }
+
+    uint64_t hits_{0};               // fetches of resident pages
+    uint64_t misses_{0};             // fetches that read the page in
+    uint64_t evictions_{0};          // resident pages replaced by another page
+    uint64_t dirty_write_backs_{0};  // dirty pages written back before their frame was reused
+};
+
 class BufferPoolManager {
+    friend class ParallelBufferPoolManager;
+
 public:
-    explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+    explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                               ReplacerType replacer_type = ReplacerType::kLRU);
+
+    virtual ~BufferPoolManager();
+
+    /**
+     * Pin a page, reading it in on a miss.
+     * @param strategy if not null, a miss recycles a frame of the strategy's ring instead of the shared pool
+     */
+    virtual Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+    virtual bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+    virtual bool FlushPage(page_id_t page_id);
+
+    /**
+     * Write back every dirty page in the pool in page id order, adjacent pages of an extent with one vectored write,
+     * and sync the files once at the end.
+     */
+    virtual void FlushAllPages();
 
-    ~BufferPoolManager();
+    virtual Page *NewPage(page_id_t &page_id, BufferAccessStrategy *strategy = nullptr);
 
-    Page *FetchPage(page_id_t page_id);
+    virtual bool DeletePage(page_id_t page_id);
 
-    bool UnpinPage(page_id_t page_id, bool is_dirty);
+    /**
+     * Give back one pin of a frame returned by FetchPage/NewPage. Unlike UnpinPage the frame is addressed directly,
+     * so no page table lookup is needed. Used by the page guards.
+     */
+    virtual bool UnpinFrame(Page *page, bool is_dirty);
+
+    /** FetchPage wrapped in a guard that unpins the page when it goes out of scope. */
+    PageGuard FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+    /** FetchPage plus the read latch, both released by the returned guard. */
+    ReadPageGuard FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
 
-    bool FlushPage(page_id_t page_id);
+    /** FetchPage plus the write latch, both released by the returned guard. */
+    WritePageGuard FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+    /** NewPage wrapped in a guard, the guard is empty if all frames are pinned. */
+    PageGuard NewPageGuarded(page_id_t &page_id, BufferAccessStrategy *strategy = nullptr);
+
+    /**
+     * Reserve count adjacent page ids on disk, see DiskManager::AllocatePages. The pages are brought into the pool one
+     * at a time with NewPageAt, the ones never used are given back with DeallocatePages.
+     * @param segment_id the segment file to allocate the pages in, see CreateSegment
+     * @return the first page id of the run, INVALID_PAGE_ID if no run of that length is free
+     */
+    page_id_t AllocatePages(uint32_t count, segment_id_t segment_id = 0);
 
-    Page *NewPage(page_id_t &page_id);
+    /** Give back page ids reserved with AllocatePages that were never brought into the pool. */
+    void DeallocatePages(page_id_t first_page_id, uint32_t count);
 
-    bool DeletePage(page_id_t page_id);
+    /**
+     * Bring a page whose id is already allocated on disk into a free frame of this pool.
+     * @return the pinned and zeroed page, nullptr if all frames are pinned
+     */
+    virtual Page *NewPageAt(page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
 
     bool IsPageFree(page_id_t page_id);
 
-    bool CheckAllUnpinned();
+    /**
+     * Create a segment file for the pages of one table or index, see DiskManager::CreateSegment.
+     * @param compressed pages of the segment are compressed when written back and decompressed when read in
+     * @return the segment id to pass to AllocatePages, 0 (the database file) if no segment is left
+     */
+    segment_id_t CreateSegment(bool compressed = false) { return disk_manager_->CreateSegment(compressed); }
+
+    /**
+     * Drop all pages of a segment at once by removing its file. Cached pages of the segment are discarded without
+     * being written back, the segment's pages must not be in use anymore.
+     * @return false for segment 0 or a segment that does not exist
+     */
+    virtual bool DropSegment(segment_id_t segment_id);
+
+    virtual bool CheckAllUnpinned();
+
+    /** @return the number of frames managed by this buffer pool */
+    size_t GetPoolSize() const { return pool_size_; }
+
+    /**
+     * Change the number of frames while the pool is in use. Growing adds the new frames to the free list. Shrinking
+     * releases the frames at the end of the pool: their unpinned pages are written back if dirty and evicted, and
+     * pinned ones are waited for.
+     * @param timeout_ms how long shrinking waits for pinned frames to be released
+     * @return false if the size is out of range or some frames stayed pinned, the pool size is unchanged then
+     */
+    virtual bool Resize(size_t pool_size, uint32_t timeout_ms = DEFAULT_RESIZE_TIMEOUT_MS);
+
+    /** @return the largest size this pool can be resized to */
+    virtual size_t GetMaxPoolSize() const { return arena_->GetCapacity(); }
+
+    /**
+     * Start a background thread that writes back dirty unpinned frames whenever they make up more than
+     * dirty_watermark of the evictable frames, so that evictions can usually pick clean victims.
+     * @param dirty_watermark allowed fraction of dirty frames among the evictable ones
+     * @param interval_ms how often the flusher checks the pool when nobody wakes it up
+     */
+    virtual void StartBackgroundFlusher(double dirty_watermark = DEFAULT_DIRTY_PAGE_WATERMARK,
+                                        uint32_t interval_ms = DEFAULT_FLUSH_INTERVAL_MS);
+
+    virtual void StopBackgroundFlusher();
+
+    /**
+     * Stop the background threads doing page I/O, the flusher and the prefetcher, and wait for the I/O they have in
+     * flight, e.g. before DiskManager::Shrink. Queued prefetches are dropped.
+     */
+    virtual void PauseBackgroundIo();
+
+    /** Restart the flusher if PauseBackgroundIo stopped it, the prefetcher starts again with the next prefetch. */
+    virtual void ResumeBackgroundIo();
+
+    /** @return number of dirty victims written back inline by FetchPage/NewPage */
+    virtual uint64_t GetForegroundWriteBacks() const { return foreground_write_backs_; }
+
+    /** @return number of dirty frames written back by the background flusher */
+    virtual uint64_t GetBackgroundWriteBacks() const { return background_write_backs_; }
+
+    /**
+     * @return hits, misses and evictions of all fetches so far, write-backs include the background flusher's
+     */
+    virtual BufferPoolStats GetStats() const;
+
+    /**
+     * @return the activity charged to each owner, keyed by IoOwner::Key. Background work is not charged.
+     */
+    virtual unordered_map<uint64_t, BufferPoolStats> GetOwnerStats();
+
+    /**
+     * Asynchronously read the given pages into frames without pinning them, so that a later FetchPage hits.
+     * Pages that are already resident are skipped, requests beyond the pool size are dropped. Pages adjacent in the
+     * file are read with one I/O.
+     */
+    virtual void PrefetchPages(const vector<page_id_t> &page_ids,
+                               const shared_ptr<BufferAccessStrategy> &strategy = nullptr);
+
+    /** @return true if the page is cached and its content has been read in */
+    virtual bool IsPageResident(page_id_t page_id);
+
+    /**
+     * Save the working set to this file when the pool is destroyed, so that the next start can Prewarm from it.
+     */
+    void SetWorkingSetFile(const string &file_name) { working_set_file_ = file_name; }
+
+    /**
+     * @return the ids of the resident pages, hottest first: the pinned ones, then the others from the last victim
+     * the replacer would pick to the first
+     */
+    virtual vector<page_id_t> GetWorkingSet();
+
+    /**
+     * Read the pages of a saved working set back into the pool, as many of the hottest ones as fit. They are read in
+     * page id order, so that runs of adjacent pages take one I/O each. Pages freed in the meantime are skipped.
+     * @param background hand the pages to the prefetcher and return at once instead of waiting for the reads
+     * @return the number of pages read in, or queued in the background
+     */
+    size_t Prewarm(const string &file_name, bool background = false);
+
+    static constexpr uint32_t WORKING_SET_MAGIC_NUM = 731925;
+
+protected:
+    /**
+     * Used by buffer pools that manage their frames through other instances, no frame is allocated here.
+     */
+    explicit BufferPoolManager(DiskManager *disk_manager);
 
 private:
     /**
@@ -45,14 +230,124 @@ private:
 
     frame_id_t TryToFindFreePage();
 
-private:
+    /**
+     * Find a frame for a page about to be brought in, honoring the access strategy if there is one.
+     */
+    frame_id_t FindFrame(page_id_t page_id, BufferAccessStrategy *strategy);
+
+    /**
+     * Detach the page currently held by a frame about to be reused, writing it back first if it is dirty.
+     */
+    void EvictFrame(Page &victim);
+
+    void WriteBackVictim(Page &victim);
+
+    /**
+     * Hand an unpinned frame to the replacer, or report it to a waiting Resize if the frame is being released.
+     */
+    void MakeEvictable(frame_id_t frame_id);
+
+    /** @return true if the frame is released by an ongoing Resize and must not hold a page anymore */
+    bool IsRetiring(frame_id_t frame_id) const { return static_cast<size_t>(frame_id) >= retire_from_; }
+
+    /**
+     * @return the counters of the owner the calling thread works for, nullptr if it works for nobody
+     */
+    BufferPoolStats *OwnerStats();
+
+    /**
+     * Reserve an unpinned frame for a page the prefetcher reads in, fetches of the page wait until FinishLoad.
+     * @return the frame to read the page into, nullptr if the page is resident, free or no frame is left
+     */
+    virtual Page *BeginLoad(page_id_t page_id, BufferAccessStrategy *strategy);
+
+    /** Hand a frame filled by the prefetcher to the replacer and wake up the fetches waiting for it. */
+    virtual void FinishLoad(Page *page);
+
+    /**
+     * Read the frames reserved by BeginLoad, runs of adjacent pages of one extent with a single I/O each.
+     */
+    void LoadPages(vector<Page *> &pages);
+
+    /**
+     * Write the working set to the file set by SetWorkingSetFile, once
+     */
+    void SaveWorkingSet();
+
+    void StopPrefetcher();
+
+    /**
+     * Free the frames caching pages of a dropped segment, the caller holds latch_
+     */
+    void DiscardSegment(segment_id_t segment_id);
+
+    /**
+     * One round of the background flusher.
+     * @return number of frames written back in this round
+     */
+    size_t FlushDirtyFrames();
+
+    /** A frame marked as being written back, the pool it belongs to is needed to hand it back afterwards. */
+    struct WriteBackFrame {
+        page_id_t page_id_;
+        BufferPoolManager *pool_;
+        frame_id_t frame_id_;
+    };
+
+    /**
+     * Mark every dirty frame whose content is there as being written back and clear its dirty bit, so that a
+     * modification racing with the write makes the page dirty again.
+     */
+    void CollectDirtyFrames(vector<WriteBackFrame> &frames);
+
+    /**
+     * Write back frames marked as being written back, possibly of several pools on the same disk manager. They are
+     * sorted by page id and copied WRITE_BACK_BATCH_PAGES at a time, each run of adjacent pages of an extent is written
+     * with one vectored I/O. The frames are handed back to their replacer afterwards.
+     * @param background count the pages as written back by the background flusher
+     */
+    static void WriteBackFrames(DiskManager *disk_manager, vector<WriteBackFrame> &frames, bool background);
+
+protected:
     size_t pool_size_;                                 // number of pages in buffer pool
-    Page *pages_;                                      // array of pages
     DiskManager *disk_manager_;                        // pointer to the disk manager.
+
+private:
+    FrameArena *arena_;                                // memory of the frames
+    Page *pages_;                                      // array of pages, the descriptors in arena_
     unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
     Replacer *replacer_;                               // to find an unpinned page for replacement
     list<frame_id_t> free_list_;                       // to find a free page for replacement
     recursive_mutex latch_;                            // to protect shared data structure
+    vector<bool> writing_back_;                        // frames being written back by the flusher
+    size_t flush_cursor_{0};                           // where the flusher resumes scanning the frames
+    size_t retire_from_{0};                            // frames from here on are being released by Resize
+    condition_variable_any resize_cv_;                 // signaled when a frame being released becomes unpinned
+
+    static constexpr size_t FLUSH_BATCH_SIZE = 64;     // max frames written back per flusher round
+    thread flusher_;
+    mutex flusher_mutex_;
+    condition_variable flusher_cv_;
+    bool flusher_stop_{true};
+    double dirty_watermark_{DEFAULT_DIRTY_PAGE_WATERMARK};
+    uint32_t flusher_interval_ms_{DEFAULT_FLUSH_INTERVAL_MS};
+    bool flusher_paused_{false};                       // stopped by PauseBackgroundIo, ResumeBackgroundIo restarts it
+    atomic<uint64_t> foreground_write_backs_{0};
+    atomic<uint64_t> background_write_backs_{0};
+    atomic<uint64_t> hits_{0};
+    atomic<uint64_t> misses_{0};
+    atomic<uint64_t> evictions_{0};
+    unordered_map<uint64_t, BufferPoolStats> owner_stats_;  // protected by latch_
+
+    vector<bool> loading_;                             // frames being read in by the prefetcher
+    condition_variable_any load_cv_;                   // signaled when a frame finishes loading
+    thread prefetcher_;
+    mutex prefetch_mutex_;
+    condition_variable prefetch_cv_;
+    deque<pair<page_id_t, shared_ptr<BufferAccessStrategy>>> prefetch_queue_;
+    bool prefetch_stop_{false};
+
+    string working_set_file_;                          // written on destruction if not empty
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -36,8 +36,12 @@ class CLOCKReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
   size_t Size() override;
 
+  void Resize(size_t num_pages) override;
+
  private:
   size_t capacity;
   list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
@@ -0,0 +1,48 @@
+#ifndef MINISQL_EXTENT_ALLOCATOR_H
+#define MINISQL_EXTENT_ALLOCATOR_H
+
+#include <mutex>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+
+/**
+ * Hands out new pages for one table heap or index. Pages are reserved extent_size at a time with
+ * BufferPoolManager::AllocatePages, so an object growing one page at a time still ends up in runs of adjacent pages
+ * and scanning it reads the file sequentially. Pages still reserved are given back by Release.
+ */
+class ExtentAllocator {
+ public:
+  /**
+   * @param segment_id the segment file the object lives in, 0 for the database file
+   */
+  ExtentAllocator(BufferPoolManager *buffer_pool_manager, uint32_t extent_size, segment_id_t segment_id = 0)
+      : buffer_pool_manager_(buffer_pool_manager), extent_size_(extent_size), segment_id_(segment_id) {}
+
+  ~ExtentAllocator() { Release(); }
+
+  DISALLOW_COPY_AND_MOVE(ExtentAllocator);
+
+  /**
+   * Like BufferPoolManager::NewPageGuarded, the page comes from the current extent. If no run of extent_size pages
+   * is free anymore, single pages are allocated.
+   */
+  PageGuard NewPageGuarded(page_id_t &page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /** Give back the pages reserved but not handed out yet. */
+  void Release();
+
+  uint32_t GetExtentSize() const { return extent_size_; }
+
+  segment_id_t GetSegmentId() const { return segment_id_; }
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  uint32_t extent_size_;
+  segment_id_t segment_id_;
+  std::mutex latch_;
+  page_id_t next_page_id_{INVALID_PAGE_ID};  // protected by latch_
+  uint32_t reserved_{0};                     // pages reserved from next_page_id_ on, protected by latch_
+};
+
+#endif  // MINISQL_EXTENT_ALLOCATOR_H
@@ -0,0 +1,56 @@
+#ifndef MINISQL_FRAME_ARENA_H
+#define MINISQL_FRAME_ARENA_H
+
+#include <cstddef>
+
+#include "common/macros.h"
+#include "page/page.h"
+
+/**
+ * FrameArena owns the memory of one buffer pool. The data of all frames is a single page aligned mmap region, with a
+ * transparent huge page hint for large pools, and the frame descriptors are a separate cache line aligned array.
+ * Frame i uses the i-th descriptor and the i-th PAGE_SIZE block of the region.
+ *
+ * Address space for capacity frames is reserved up front, but memory is only used by the frames in use, so the pool
+ * can be resized without moving any frame.
+ */
+class FrameArena {
+ public:
+  /**
+   * @param num_frames frames in use from the start
+   * @param capacity frames the arena can grow to, at least num_frames
+   */
+  explicit FrameArena(size_t num_frames, size_t capacity = MAX_BUFFER_POOL_SIZE);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena)
+
+  /** @return the descriptor array, one Page per frame */
+  Page *GetFrames() const { return frames_; }
+
+  size_t GetCapacity() const { return capacity_; }
+
+  /**
+   * Change the number of frames in use. New frames are zero filled, the memory of dropped frames is given back to
+   * the system. The caller makes sure dropped frames are no longer referenced.
+   */
+  void Resize(size_t num_frames);
+
+  /** @return true if the kernel accepted the huge page hint for the data region */
+  bool UsesHugePages() const { return huge_pages_; }
+
+ private:
+  /** Give the hint once the frames in use cover at least one huge page. */
+  void AdviseHugePages();
+
+  size_t num_frames_;
+  size_t capacity_;
+  Page *frames_{nullptr};
+  size_t frames_size_{0};
+  char *data_{nullptr};
+  size_t data_size_{0};
+  bool huge_pages_{false};
+};
+
+#endif  // MINISQL_FRAME_ARENA_H
@@ -0,0 +1,65 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <deque>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+/**
+ * LRUKReplacer evicts the frame whose k-th most recent access lies furthest in the past. Frames with fewer than k
+ * accesses have an infinite backward k-distance and are evicted first, oldest access first, so pages touched once by
+ * a sequential scan leave the pool before pages that are accessed repeatedly. Accesses to a page that follow its
+ * previous access within the correlated reference period (e.g. one per tuple while a scan is on the page) count as
+ * a single access.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of accesses remembered per frame
+   * @param correlated_period number of accesses to other pages after which an access counts as a new one
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = DEFAULT_LRU_K,
+                        uint64_t correlated_period = DEFAULT_LRU_K_CORRELATED_PERIOD);
+
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
+  size_t Size() override;
+
+  void Resize(size_t num_pages) override;
+
+ private:
+  // (has k accesses, timestamp of the oldest remembered access, frame), ordered by eviction priority
+  using EvictionKey = std::tuple<bool, uint64_t, frame_id_t>;
+
+  struct FrameEntry {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    std::deque<uint64_t> history_;  // at most k access timestamps, oldest first
+    bool evictable_{false};
+  };
+
+  EvictionKey GetKey(frame_id_t frame_id) const;
+
+  size_t k_;
+  uint64_t correlated_period_;
+  uint64_t current_timestamp_{0};
+  std::vector<FrameEntry> frames_;
+  std::set<EvictionKey> evictable_;
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -35,8 +35,12 @@ public:
 
     void Unpin(frame_id_t frame_id) override;
 
+    std::vector<frame_id_t> GetEvictionOrder() override;
+
     size_t Size() override;
 
+    void Resize(size_t num_pages) override;
+
 private:
     // add your own private member variables here
     size_t capacity;
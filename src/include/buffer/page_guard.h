@@ -0,0 +1,224 @@
+#ifndef MINISQL_PAGE_GUARD_H
+#define MINISQL_PAGE_GUARD_H
+
+#include <utility>
+#include <vector>
+
+#include "page/page.h"
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * PageGuard owns one pin of a buffer pool frame and gives it back when it is destroyed or dropped.
+ *
+ * The guard keeps the frame pointer itself, so releasing the pin needs no page table lookup. Guards are move-only:
+ * moving one transfers the pin, and the moved-from guard becomes empty.
+ */
+class PageGuard {
+ public:
+  PageGuard() = default;
+
+  PageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  PageGuard(const PageGuard &) = delete;
+
+  PageGuard &operator=(const PageGuard &) = delete;
+
+  PageGuard(PageGuard &&that) noexcept;
+
+  /** Releases the pin held by this guard before taking over the one held by that guard. */
+  PageGuard &operator=(PageGuard &&that) noexcept;
+
+  ~PageGuard() { Drop(); }
+
+  /** Unpin the page now, the guard is empty afterwards. Dropping an empty guard does nothing. */
+  void Drop();
+
+  /** @return false if the guard holds no page, e.g. the fetch failed or the guard was moved from */
+  bool IsValid() const { return page_ != nullptr; }
+
+  page_id_t PageId() const { return page_->GetPageId(); }
+
+  Page *GetPage() const { return page_; }
+
+  const char *GetData() const { return page_->GetData(); }
+
+  /**
+   * Same as GetData, but the page is written back when the guard releases it. Inside a PageWriteScope the page is
+   * write latched first, so call this before changing the page.
+   */
+  char *GetDataMut() {
+    SetDirty();
+    return page_->GetData();
+  }
+
+  /** View the page content as T without marking the page dirty. */
+  template <class T>
+  T *As() const {
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+  /** View the page content as T and mark the page dirty. */
+  template <class T>
+  T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /** Mark the page dirty, for changes made through GetPage. Like GetDataMut, call it before changing the page. */
+  void SetDirty();
+
+  /** Take the read latch and move the pin into a ReadPageGuard, this guard is empty afterwards. */
+  ReadPageGuard UpgradeRead();
+
+  /** Take the write latch and move the pin into a WritePageGuard, this guard is empty afterwards. */
+  WritePageGuard UpgradeWrite();
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+  /** True if the guard holds a write latch taken for the current PageWriteScope. */
+  bool scope_latched_{false};
+};
+
+/**
+ * ReadPageGuard holds the read latch and one pin of a page. Both are released together, the latch first.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** @param page a page already pinned and read latched by the caller */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  bool IsValid() const { return guard_.IsValid(); }
+
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  Page *GetPage() const { return guard_.GetPage(); }
+
+  const char *GetData() const { return guard_.GetData(); }
+
+  template <class T>
+  T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class PageGuard;
+
+  PageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds the write latch and one pin of a page. Both are released together, the latch first.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** @param page a page already pinned and write latched by the caller */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  bool IsValid() const { return guard_.IsValid(); }
+
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  Page *GetPage() const { return guard_.GetPage(); }
+
+  const char *GetData() const { return guard_.GetData(); }
+
+  // the write latch is held already, so the page is only marked dirty
+  char *GetDataMut() {
+    SetDirty();
+    return guard_.page_->GetData();
+  }
+
+  template <class T>
+  T *As() const {
+    return guard_.As<T>();
+  }
+
+  template <class T>
+  T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  void SetDirty() { guard_.is_dirty_ = true; }
+
+ private:
+  friend class PageGuard;
+
+  PageGuard guard_;
+};
+
+/**
+ * While a PageWriteScope is alive, a PageGuard of the current thread write latches its page the first time the page is
+ * marked dirty, and releases the latch together with the pin. Several guards of the thread may hold the same page,
+ * the latch is taken by the first of them and released by the last, so an operation that reaches a page through
+ * nested guards does not deadlock on itself. Optimistic readers thereby never validate a page while it is changed.
+ *
+ * Latches are only held on pinned pages, so a latched frame is never evicted and reused. A thread inside a scope must
+ * not take page latches in any other way, in particular it must not read optimistically.
+ */
+class PageWriteScope {
+ public:
+  PageWriteScope();
+
+  PageWriteScope(const PageWriteScope &) = delete;
+
+  PageWriteScope &operator=(const PageWriteScope &) = delete;
+
+  ~PageWriteScope();
+
+  /** @return true if the current thread is inside a scope */
+  static bool IsActive() { return current_ != nullptr; }
+
+  /**
+   * Write latch the page unless a guard of the current scope holds it already.
+   * @return false if the thread is not inside a scope, nothing was latched then
+   */
+  static bool Acquire(Page *page);
+
+  /** Give back a latch taken by Acquire, the page is unlatched when its last holder releases it. */
+  static void Release(Page *page);
+
+ private:
+  // latched pages and the number of guards holding each of them
+  std::vector<std::pair<Page *, uint32_t>> latched_;
+  PageWriteScope *prev_;
+  static inline thread_local PageWriteScope *current_{nullptr};
+};
+
+#endif  // MINISQL_PAGE_GUARD_H
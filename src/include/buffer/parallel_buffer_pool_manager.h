@@ -0,0 +1,89 @@
+#ifndef MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
+#define MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into several independent BufferPoolManager instances.
+ * A page is always cached by the instance selected by its page id, and every instance owns its page table,
+ * free list, replacer and latch, so accesses to pages of different instances never serialize on one latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @param num_instances number of independent buffer pool instances
+   * @param pool_size total number of frames, shared out evenly between the instances
+   * @param disk_manager the disk manager shared by all instances
+   * @param replacer_type replacement policy used by every instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            ReplacerType replacer_type = ReplacerType::kLRU);
+
+  ~ParallelBufferPoolManager() override;
+
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  void FlushAllPages() override;
+
+  Page *NewPage(page_id_t &page_id, BufferAccessStrategy *strategy = nullptr) override;
+
+  Page *NewPageAt(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  bool DropSegment(segment_id_t segment_id) override;
+
+  bool UnpinFrame(Page *page, bool is_dirty) override;
+
+  bool CheckAllUnpinned() override;
+
+  bool Resize(size_t pool_size, uint32_t timeout_ms = DEFAULT_RESIZE_TIMEOUT_MS) override;
+
+  size_t GetMaxPoolSize() const override;
+
+  void StartBackgroundFlusher(double dirty_watermark, uint32_t interval_ms) override;
+
+  void StopBackgroundFlusher() override;
+
+  /** The prefetcher of the pool and the flushers of the instances. */
+  void PauseBackgroundIo() override;
+
+  void ResumeBackgroundIo() override;
+
+  uint64_t GetForegroundWriteBacks() const override;
+
+  uint64_t GetBackgroundWriteBacks() const override;
+
+  BufferPoolStats GetStats() const override;
+
+  std::unordered_map<uint64_t, BufferPoolStats> GetOwnerStats() override;
+
+  bool IsPageResident(page_id_t page_id) override;
+
+  /** The lists of the instances interleaved, pages of the same rank are about equally hot. */
+  std::vector<page_id_t> GetWorkingSet() override;
+
+  /** @return the number of buffer pool instances */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+ private:
+  /** NewPage gives up after this many page ids per instance, even if some instance was never reached. */
+  static constexpr size_t NEW_PAGE_ROUNDS = 4;
+
+  Page *BeginLoad(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  void FinishLoad(Page *page) override;
+
+  /** @return the instance responsible for caching the given page */
+  BufferPoolManager *GetInstance(page_id_t page_id) const { return instances_[page_id % instances_.size()]; }
+
+  std::vector<BufferPoolManager *> instances_;
+};
+
+#endif  // MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
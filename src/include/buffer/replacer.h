@@ -2,9 +2,15 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
+/**
+ * Replacement policies a buffer pool can be created with.
+ */
+enum class ReplacerType { kLRU, kClock, kLRUK, kARC };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -14,6 +20,13 @@ class Replacer {
 
   virtual ~Replacer() = default;
 
+  /**
+   * Create a replacer implementing the given policy.
+   * @param type the replacement policy
+   * @param num_pages the maximum number of pages the replacer will be required to store
+   */
+  static Replacer *Create(ReplacerType type, size_t num_pages);
+
   /**
    * Remove the victim frame as defined by the replacement policy.
    * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
@@ -33,8 +46,29 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Records that the page held by a frame has been accessed. Policies that only look at pin/unpin order ignore it.
+   * A frame that starts holding another page loses the history of its previous page.
+   * @param frame_id the id of the accessed frame
+   * @param page_id the id of the page held by the frame
+   */
+  virtual void RecordAccess([[maybe_unused]] frame_id_t frame_id, [[maybe_unused]] page_id_t page_id) {}
+
+  /**
+   * @return the frames that can be victimized, in the order Victim would hand them out, without removing them.
+   * Used to save the working set of a buffer pool.
+   */
+  virtual std::vector<frame_id_t> GetEvictionOrder() = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Change the number of frames the replacer tracks. Frames at or beyond num_pages are forgotten when shrinking,
+   * the caller makes sure they are not handed to the replacer again.
+   * @param num_pages the new maximum number of pages the replacer will be required to store
+   */
+  virtual void Resize(size_t num_pages) = 0;
 };
 
 #endif  // MINISQL_REPLACER_H
@@ -1,7 +1,9 @@
 #ifndef MINISQL_CATALOG_H
 #define MINISQL_CATALOG_H
 
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -76,7 +78,11 @@ class CatalogManager {
 
   ~CatalogManager();
 
-  dberr_t CreateTable(const std::string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info);
+  /**
+   * @param compressed store the table pages compressed, see DiskManager::CreateSegment
+   */
+  dberr_t CreateTable(const std::string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info,
+                      bool compressed = false);
 
   dberr_t GetTable(const std::string &table_name, TableInfo *&table_info);
 
@@ -94,6 +100,14 @@ class CatalogManager {
 
   dberr_t DropIndex(const std::string &table_name, const std::string &index_name);
 
+  /**
+   * Snapshots the tables and pins each of them, so that background work, e.g. the vacuum worker, can walk them without
+   * holding the tables latch. DropTable waits until the table it drops is unpinned.
+   */
+  void PinTables(std::vector<TableInfo *> &tables);
+
+  void UnpinTable(TableInfo *table_info);
+
  private:
   dberr_t DropTable(table_id_t table_id);
 
@@ -115,6 +129,10 @@ class CatalogManager {
   // map for tables
   std::unordered_map<std::string, table_id_t> table_names_;
   std::unordered_map<table_id_t, TableInfo *> tables_;
+  std::mutex tables_latch_;
+  // tables pinned by background work, with the count of their pins
+  std::unordered_map<table_id_t, uint32_t> table_pins_;
+  std::condition_variable tables_unpinned_;
   // map for indexes: table_name->index_name->indexes
   std::unordered_map<std::string, std::unordered_map<std::string, index_id_t>> index_names_;
   std::unordered_map<index_id_t, IndexInfo *> indexes_;
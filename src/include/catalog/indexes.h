@@ -15,7 +15,8 @@ class IndexMetadata {
 
  public:
   static IndexMetadata *Create(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                               const std::vector<uint32_t> &key_map);
+                               const std::vector<uint32_t> &key_map, uint32_t extent_size = INDEX_EXTENT_SIZE,
+                               segment_id_t segment_id = 0);
 
   uint32_t SerializeTo(char *buf) const;
 
@@ -33,18 +34,30 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  /** @return adjacent pages the index reserves at a time */
+  inline uint32_t GetExtentSize() const { return extent_size_; }
+
+  /** @return the segment file holding the index pages, 0 for the database file */
+  inline segment_id_t GetSegmentId() const { return segment_id_; }
+
  private:
   IndexMetadata() = delete;
 
   explicit IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                         const std::vector<uint32_t> &key_map);
+                         const std::vector<uint32_t> &key_map, uint32_t extent_size, segment_id_t segment_id);
 
  private:
   static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+  // metadata written since the extent size is kept, it follows the key mapping
+  static constexpr uint32_t INDEX_METADATA_EXTENT_MAGIC_NUM = 344529;
+  // metadata written since indexes can have a segment file, the segment id follows the extent size
+  static constexpr uint32_t INDEX_METADATA_SEGMENT_MAGIC_NUM = 344530;
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  uint32_t extent_size_;
+  segment_id_t segment_id_;
 };
 
 /**
@@ -77,6 +90,8 @@ class IndexInfo {
 
   std::string GetIndexName() { return meta_data_->GetIndexName(); }
 
+  inline index_id_t GetIndexId() const { return meta_data_->GetIndexId(); }
+
   IndexSchema *GetIndexKeySchema() { return key_schema_; }
 
  private:
@@ -23,7 +23,8 @@ class TableMetadata {
    * will create new table schema and owned by mem heap
    */
   static TableMetadata *Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                               TableSchema *schema);
+                               TableSchema *schema, uint32_t extent_size = TABLE_HEAP_EXTENT_SIZE,
+                               page_id_t free_space_map_page_id = INVALID_PAGE_ID);
 
   inline table_id_t GetTableId() const { return table_id_; }
 
@@ -33,17 +34,30 @@ class TableMetadata {
 
   inline Schema *GetSchema() const { return schema_; }
 
+  /** @return adjacent pages the table heap reserves at a time */
+  inline uint32_t GetExtentSize() const { return extent_size_; }
+
+  /** @return the root of the table heap's free space map, INVALID_PAGE_ID if the table has none on disk */
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_page_id_; }
+
  private:
   TableMetadata() = delete;
 
-  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema);
+  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                uint32_t extent_size, page_id_t free_space_map_page_id);
 
  private:
   static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
+  // metadata written since the extent size is kept, it follows the schema
+  static constexpr uint32_t TABLE_METADATA_EXTENT_MAGIC_NUM = 344529;
+  // metadata written since the free space map root is kept, it follows the extent size
+  static constexpr uint32_t TABLE_METADATA_FSM_MAGIC_NUM = 344530;
   table_id_t table_id_;
   std::string table_name_;
   page_id_t root_page_id_;
   Schema *schema_;
+  uint32_t extent_size_;
+  page_id_t free_space_map_page_id_;
 };
 
 /**
@@ -61,6 +75,7 @@ class TableInfo {
   void Init(TableMetadata *table_meta, TableHeap *table_heap) {
     table_meta_ = table_meta;
     table_heap_ = table_heap;
+    table_heap_->SetTableId(table_meta_->table_id_);
   }
 
   inline TableHeap *GetTableHeap() const { return table_heap_; }
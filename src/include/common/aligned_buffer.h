@@ -0,0 +1,44 @@
+#ifndef MINISQL_ALIGNED_BUFFER_H
+#define MINISQL_ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * Heap memory aligned to a page, as reads and writes on files opened with O_DIRECT require it.
+ */
+class AlignedBuffer {
+ public:
+  explicit AlignedBuffer(size_t size = PAGE_SIZE)
+      : data_(static_cast<char *>(::operator new[](size, std::align_val_t{PAGE_SIZE}))), size_(size) {}
+
+  DISALLOW_COPY(AlignedBuffer)
+
+  AlignedBuffer(AlignedBuffer &&that) noexcept : data_(that.data_), size_(that.size_) {
+    that.data_ = nullptr;
+    that.size_ = 0;
+  }
+
+  ~AlignedBuffer() {
+    if (data_ != nullptr) {
+      ::operator delete[](data_, std::align_val_t{PAGE_SIZE});
+    }
+  }
+
+  char *Data() const { return data_; }
+
+  size_t Size() const { return size_; }
+
+  /** @return true if the buffer can be used for direct I/O as it is */
+  static bool IsAligned(const void *buf) { return reinterpret_cast<uintptr_t>(buf) % PAGE_SIZE == 0; }
+
+ private:
+  char *data_;
+  size_t size_;
+};
+
+#endif  // MINISQL_ALIGNED_BUFFER_H
@@ -14,7 +14,34 @@ static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalo
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
 static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
+static constexpr int SEGMENT_ID_BITS = 6;               // high bits of a page id naming the file the page lives in
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 4;  // default number of buffer pool instances
+static constexpr size_t MAX_BUFFER_POOL_SIZE = 262144;   // frames a buffer pool instance can grow to by resizing
+static constexpr uint32_t DEFAULT_RESIZE_TIMEOUT_MS = 1000;  // how long shrinking waits for pinned frames
+static constexpr uint32_t OPTIMISTIC_READ_RETRIES = 8;  // unlatched page reads tried before taking the read latch
+static constexpr double DEFAULT_DIRTY_PAGE_WATERMARK = 0.25;  // allowed dirty fraction of evictable frames
+static constexpr uint32_t DEFAULT_FLUSH_INTERVAL_MS = 50;      // background flusher wake-up interval
+static constexpr uint32_t TABLE_READ_AHEAD_PAGES = 16;         // pages prefetched ahead of a table scan
+static constexpr uint32_t PREWARM_BATCH_PAGES = 256;           // pages read in together when prewarming a pool
+static constexpr uint32_t WRITE_BACK_BATCH_PAGES = 256;        // dirty pages copied and written together by a flush
+static constexpr uint32_t TABLE_HEAP_EXTENT_SIZE = 8;          // adjacent pages a table heap grows by
+static constexpr uint32_t MAX_TABLE_INSERT_POINTS = 16;        // pages a table heap fills at once for parallel inserts
+static constexpr uint32_t DEFAULT_VACUUM_INTERVAL_MS = 1000;   // vacuum worker wake-up interval
+static constexpr uint32_t VACUUM_MIN_DEAD_TUPLES = 50;         // dead tuples a table needs before it is vacuumed
+static constexpr double VACUUM_DEAD_TUPLE_RATIO = 0.1;         // and their share of the table's tuples
+static constexpr uint32_t INDEX_EXTENT_SIZE = 8;               // adjacent pages a b+ tree grows by
+static constexpr size_t COMPRESSED_SECTOR_SIZE = 512;          // compressed pages are stored in slots of sectors
+static constexpr uint32_t FILE_GROWTH_MIN_PAGES = 64;          // a file is preallocated at least this many pages
+static constexpr uint32_t FILE_GROWTH_MAX_PAGES = 8192;        // at most, in between it grows by its own size
+static constexpr size_t ASYNC_IO_QUEUE_DEPTH = 64;              // asynchronous disk I/Os in flight per disk manager
+static constexpr size_t ASYNC_IO_THREADS = 4;                   // threads of the fallback asynchronous I/O backend
+static constexpr size_t DEFAULT_LRU_K = 2;                     // history depth of the LRU-K replacer
+static constexpr uint64_t DEFAULT_LRU_K_CORRELATED_PERIOD = 8;  // accesses within this distance count once
+static constexpr size_t BULK_READ_RING_SIZE = 32;    // frames recycled by a sequential scan per pool instance
+static constexpr size_t BULK_WRITE_RING_SIZE = 128;  // frames recycled by a bulk load per pool instance
+static constexpr size_t CACHE_LINE_SIZE = 64;              // frame descriptors are aligned to cache lines
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;  // transparent huge page size of the frame arena
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
@@ -22,6 +49,7 @@ static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of var
 // static std::string DB_META_FILE = "minisql.meta.db";
 
 using page_id_t = int32_t;
+using segment_id_t = uint32_t;
 using frame_id_t = int32_t;
 using txn_id_t = int32_t;
 using lsn_t = int32_t;
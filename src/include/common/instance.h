@@ -1,10 +1,14 @@
 #ifndef MINISQL_INSTANCE_H
 #define MINISQL_INSTANCE_H
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
 #include "common/dberr.h"
@@ -14,18 +18,55 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param background_prewarm when opening an existing database, read the pages cached at the last shutdown back in
+   * the background instead of before returning
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = ReplacerType::kLRU, bool direct_io = false,
+                           bool background_prewarm = false);
 
   ~DBStorageEngine();
 
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Txn *txn);
 
+  /**
+   * Vacuum the tables with many dead tuples in the background, see TableHeap::Vacuum. The worker is started by the
+   * constructor.
+   * @param interval_ms how often the worker looks for tables to vacuum
+   */
+  void StartVacuumWorker(uint32_t interval_ms = DEFAULT_VACUUM_INTERVAL_MS);
+
+  void StopVacuumWorker();
+
+  /**
+   * What the vacuum worker does each time it wakes up.
+   * @param all vacuum every table, not only the ones that need it
+   * @return bytes reclaimed
+   */
+  size_t VacuumTables(bool all = false);
+
+  /**
+   * Give back the disk space of free pages, see VACUUM FULL. The vacuum worker and the background I/O of the buffer
+   * pool are stopped meanwhile, DiskManager::Shrink needs the files to itself.
+   * @return the number of bytes of disk space released
+   */
+  size_t Shrink();
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
   std::string db_file_name_;
   bool init_;
+
+ private:
+  std::thread vacuum_worker_;
+  std::mutex vacuum_mutex_;
+  std::condition_variable vacuum_cv_;
+  bool vacuum_stop_{true};
+  uint32_t vacuum_interval_ms_{DEFAULT_VACUUM_INTERVAL_MS};
 };
 
 #endif  // MINISQL_INSTANCE_H
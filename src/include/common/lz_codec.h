@@ -0,0 +1,31 @@
+#ifndef MINISQL_LZ_CODEC_H
+#define MINISQL_LZ_CODEC_H
+
+#include <cstddef>
+
+/**
+ * A small LZ77 block codec in the style of LZ4, fast enough to run on every page write-back. It has no entropy
+ * stage, so it pays off on repeated byte strings and runs of zeros, e.g. padded CHAR columns and free page space.
+ *
+ * A block is a list of sequences. Each sequence is a token byte, the high nibble holding the number of literals and
+ * the low nibble the match length minus MIN_MATCH, a nibble of 15 continued by bytes of 255 and one final byte. The
+ * literals follow, then the 2-byte little endian offset of the match. The last sequence has literals only.
+ */
+class LzCodec {
+ public:
+  static constexpr size_t MIN_MATCH = 4;
+  static constexpr size_t MAX_OFFSET = 65535;
+
+  /**
+   * @return the size of the compressed block in dst, 0 if it does not fit into dst_capacity bytes
+   */
+  static size_t Compress(const char *src, size_t src_len, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompress a block written by Compress. Corrupt input is detected, it never reads or writes out of bounds.
+   * @return true if the block decompressed to exactly dst_len bytes
+   */
+  static bool Decompress(const char *src, size_t src_len, char *dst, size_t dst_len);
+};
+
+#endif  // MINISQL_LZ_CODEC_H
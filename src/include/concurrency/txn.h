@@ -3,10 +3,13 @@
 
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rowid.h"
 
+class TableHeap;
+
 /**
  * Transaction isolation level.
  */
@@ -52,6 +55,13 @@ class TxnAbortException : public std::exception {
 
 class Txn {
  public:
+  /** A tuple the transaction marked deleted. The delete is applied on commit and rolled back on abort. */
+  struct DeleteRecord {
+    RowId rid_;
+    TableHeap *table_heap_;
+  };
+
+
   explicit Txn(txn_id_t txn_id = INVALID_TXN_ID, IsolationLevel iso_level = IsolationLevel::kRepeatedRead)
       : txn_id_(txn_id), iso_level_(iso_level), thread_id_(std::this_thread::get_id()) {}
 
@@ -73,6 +83,8 @@ class Txn {
 
   inline std::unordered_set<RowId> &GetExclusiveLockSet() { return exclusive_lock_set_; }
 
+  inline std::vector<DeleteRecord> &GetDeleteSet() { return delete_set_; }
+
  private:
   txn_id_t txn_id_{INVALID_TXN_ID};
   IsolationLevel iso_level_{IsolationLevel::kRepeatedRead};
@@ -80,6 +92,7 @@ class Txn {
   std::thread::id thread_id_;
   std::unordered_set<RowId> shared_lock_set_;
   std::unordered_set<RowId> exclusive_lock_set_;
+  std::vector<DeleteRecord> delete_set_;
 };
 
 #endif  // MINISQL_TXN_H
@@ -59,6 +59,22 @@ class ExecuteEngine {
 
   dberr_t ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *context);
 
+  /**
+   * SHOW STATUS prints the buffer pool and disk activity of the current database since this session last ran
+   * SHOW STATUS RESET, in total and per table and index.
+   */
+  dberr_t ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  /**
+   * SET <variable> = <number>. Only buffer_pool_size is supported, it resizes the pool of the current database.
+   */
+  dberr_t ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context);
+
+  /**
+   * VACUUM FULL gives the disk space of free pages of the current database back to the file system.
+   */
+  dberr_t ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context);
+
   dberr_t ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *context);
 
   dberr_t ExecuteDropIndex(pSyntaxNode ast, ExecuteContext *context);
@@ -76,6 +92,15 @@ class ExecuteEngine {
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
+
+  /** Counters of a database at the time this session reset them */
+  struct StatusBaseline {
+    BufferPoolStats buffer_;
+    IoStats io_;
+    std::unordered_map<uint64_t, BufferPoolStats> owner_buffer_;
+    std::unordered_map<uint64_t, IoStats> owner_io_;
+  };
+  std::unordered_map<std::string, StatusBaseline> status_baselines_; /** per database, empty until a reset */
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
@@ -5,6 +5,9 @@
 #ifndef MINISQL_INSERT_EXECUTOR_H
 #define MINISQL_INSERT_EXECUTOR_H
 
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/insert_plan.h"
@@ -12,7 +15,8 @@
 /**
  * InsertExecutor executes an insert on a table.
  *
- * Inserted values are always pulled from a child executor.
+ * Inserted values are always pulled from a child executor. A statement with several VALUES tuples is inserted as one
+ * batch on the first call to Next(), the later calls report the inserted rows one by one.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -42,12 +46,24 @@ class InsertExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
  private:
+  /** @return true if no index holds the key of the row yet */
+  bool CheckUniqueKeys(Row &insert_row);
+
+  /** Pull all rows from the child and insert them with one TableHeap::InsertTuples call. */
+  void InsertBatch();
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_{};
   const Schema *schema_{};
   std::vector<IndexInfo *> index_info_;
+  /** Bulk write ring used when a single statement inserts several rows */
+  std::unique_ptr<BufferAccessStrategy> bulk_insert_strategy_;
+  /** Rows inserted by the batch and how many of them Next() has reported so far */
+  bool batch_inserted_{false};
+  size_t batch_rows_{0};
+  size_t batch_rows_reported_{0};
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
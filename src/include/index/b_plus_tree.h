@@ -1,10 +1,14 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <atomic>
+#include <fstream>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "buffer/extent_allocator.h"
 #include "concurrency/txn.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -20,14 +24,22 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Writers are serialized by writer_latch_ and write latch every page they change, see PageWriteScope. Point
+ * lookups take no latch at all: they read nodes optimistically and retry when a writer got in their way.
  */
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage;
   using LeafPage = BPlusTreeLeafPage;
 
  public:
+  /**
+   * @param extent_size adjacent pages the tree reserves at a time for new nodes, so leaf chains stay mostly sequential
+   * @param segment_id the segment file holding the tree's nodes, see BufferPoolManager::CreateSegment
+   */
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
-                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
+                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE,
+                     uint32_t extent_size = INDEX_EXTENT_SIZE, segment_id_t segment_id = 0);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -47,8 +59,9 @@ class BPlusTree {
 
   IndexIterator End();
 
-  // expose for test purpose
-  Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
+  // expose for test purpose, the returned guard keeps the leaf pinned. The leaf is the one the key belonged to when
+  // its parent was read, concurrent writers may have moved the key since.
+  PageGuard FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
 
   // used to check whether all pages are unpinned
   bool Check();
@@ -56,6 +69,9 @@ class BPlusTree {
   // destroy the b plus tree
   void Destroy(page_id_t current_page_id = INVALID_PAGE_ID);
 
+  // drop all nodes at once by removing the tree's segment file, false if the tree lives in the database file
+  bool DropSegment();
+
   void PrintTree(std::ofstream &out, Schema *schema) {
     if (IsEmpty()) {
       return;
@@ -76,12 +92,12 @@ class BPlusTree {
 
   void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction = nullptr);
 
-  LeafPage *Split(LeafPage *node, Txn *transaction);
+  PageGuard Split(LeafPage *node, Txn *transaction);
 
-  InternalPage *Split(InternalPage *node, Txn *transaction);
+  PageGuard Split(InternalPage *node, Txn *transaction);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *&node, Txn *transaction = nullptr);
+  bool CoalesceOrRedistribute(PageGuard &node_guard, Txn *transaction = nullptr);
 
   bool Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
                 Txn *transaction = nullptr);
@@ -93,10 +109,13 @@ class BPlusTree {
 
   void Redistribute(InternalPage *neighbor_node, InternalPage *node, int index);
 
-  bool AdjustRoot(BPlusTreePage *node);
+  bool AdjustRoot(PageGuard &root_guard);
 
   void UpdateRootPageId(int insert_record = 0);
 
+  // FindLeafPage for writers, which read their pages directly
+  PageGuard FindLeafPageLatched(const GenericKey *key, page_id_t page_id, bool leftMost);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const;
 
@@ -104,11 +123,15 @@ class BPlusTree {
 
   // member variable
   index_id_t index_id_;
-  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::atomic<page_id_t> root_page_id_{INVALID_PAGE_ID};
   BufferPoolManager *buffer_pool_manager_;
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  ExtentAllocator extent_allocator_;
+  std::mutex writer_latch_;
+  // odd while a writer is changing the tree, lets readers tell a missing key from one being moved
+  std::atomic<uint64_t> structure_version_{0};
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
@@ -7,7 +7,8 @@
 
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+                 uint32_t extent_size = INDEX_EXTENT_SIZE, segment_id_t segment_id = 0);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
@@ -15,6 +16,7 @@ class BPlusTreeIndex : public Index {
 
   dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
 
+  /** Free the index pages, an index in a segment file of its own is dropped by removing the file. */
   dberr_t Destroy() override;
 
   IndexIterator GetBeginIterator();
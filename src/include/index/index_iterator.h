@@ -12,6 +12,13 @@ class IndexIterator {
 
   explicit IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index = 0);
 
+  /** Start at the leaf held by leaf_guard, the iterator takes over its pin. */
+  explicit IndexIterator(PageGuard leaf_guard, BufferPoolManager *bpm, int index = 0);
+
+  IndexIterator(IndexIterator &&that) noexcept = default;
+
+  IndexIterator &operator=(IndexIterator &&that) noexcept = default;
+
   ~IndexIterator();
 
   /** Return the key/value pair this iterator is currently pointing at. */
@@ -32,6 +39,7 @@ class IndexIterator {
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
   // add your own private member variables here
+  PageGuard page_guard;  // keeps the current leaf pinned
 };
 
 #endif  // MINISQL_INDEX_ITERATOR_H
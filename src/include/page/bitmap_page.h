@@ -20,6 +20,13 @@ class BitmapPage {
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate a run of adjacent pages, the lowest free run that is long enough.
+   * @param page_offset Index in extent of the first page allocated.
+   * @return true if a long enough run was free.
+   */
+  bool AllocatePages(uint32_t count, uint32_t &page_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -30,7 +37,23 @@ class BitmapPage {
    */
   bool IsPageFree(uint32_t page_offset) const;
 
+  /**
+   * @return the number of pages allocated, counted from the bits rather than the stored counter
+   */
+  uint32_t CountAllocatedPages() const;
+
  private:
+  /**
+   * Search the bitmap a 64 bit word at a time.
+   *
+   * @param free look for a free page if true, for an allocated one otherwise
+   * @return the first such page at or after start, GetMaxSupportedSize() if there is none
+   */
+  uint32_t FindPage(uint32_t start, bool free) const;
+
+  /** @return the word_index-th 64 bit word of bytes, page i is bit i % 64 of word i / 64 */
+  uint64_t LoadWord(size_t word_index) const;
+
   /**
    * check a bit(byte_index, bit_index) in bytes is free(value 0).
    *
@@ -42,6 +65,8 @@ class BitmapPage {
 
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  static constexpr size_t MAX_WORDS = MAX_CHARS / sizeof(uint64_t);
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "the bitmap is scanned in whole words");
 
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
@@ -1,14 +1,25 @@
 #ifndef MINISQL_DISK_FILE_META_PAGE_H
 #define MINISQL_DISK_FILE_META_PAGE_H
 
+#include <algorithm>
 #include <cstdint>
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+// the last two words of the meta page hold the preallocated size and the file flags instead of the used page counts
+// of more extents, the high bits of a page id name the segment file, see DiskManager. With 6 segment bits a file
+// still holds 1020 extents, about 33.4M pages, 2 extents less than before the segments.
+static constexpr uint32_t MAX_EXTENTS = std::min<uint32_t>(
+    (PAGE_SIZE - 16) / 4, (1u << (31 - SEGMENT_ID_BITS)) / BitmapPage<PAGE_SIZE>::GetMaxSupportedSize());
+static constexpr page_id_t MAX_VALID_PAGE_ID = MAX_EXTENTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
 class DiskFileMetaPage {
  public:
+  /** The file is read and written with O_DIRECT, chosen when the database was created. */
+  static constexpr uint32_t FLAG_DIRECT_IO = 1;
+  /** The pages are compressed into a data file of their own, chosen when the segment was created. */
+  static constexpr uint32_t FLAG_COMPRESSED = 2;
+
   uint32_t GetExtentNums() { return num_extents_; }
 
   uint32_t GetAllocatedPages() { return num_allocated_pages_; }
@@ -20,6 +31,20 @@ class DiskFileMetaPage {
     return extent_used_page_[extent_id];
   }
 
+  uint32_t GetFlags() const { return *FlagsWord(); }
+
+  void SetFlags(uint32_t flags) { *const_cast<uint32_t *>(FlagsWord()) = flags; }
+
+  /** @return the number of physical pages reserved in the file with fallocate, including the meta page */
+  uint32_t GetPreallocatedPages() const { return *(FlagsWord() - 1); }
+
+  void SetPreallocatedPages(uint32_t pages) { *(const_cast<uint32_t *>(FlagsWord()) - 1) = pages; }
+
+ private:
+  const uint32_t *FlagsWord() const {
+    return reinterpret_cast<const uint32_t *>(reinterpret_cast<const char *>(this) + PAGE_SIZE - sizeof(uint32_t));
+  }
+
  public:
   uint32_t num_allocated_pages_{0};
   uint32_t num_extents_{0};  // each extent consists with a bit map and BIT_MAP_SIZE pages
@@ -0,0 +1,60 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * One page of a table heap's free space map. The map pages form a chain, together they list the heap pages in the
+ * order they were added to the heap, each with its free space rounded down to a category, see FreeSpaceMap.
+ *
+ * Format (size in byte):
+ *  ----------------------------------------------------------------------------------------------
+ * | NextPageId (4) | Count (4) | PageId_1 (4) | ... | PageId_n (4) | Category_1 (1) | ... | Category_n (1) |
+ *  ----------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  static constexpr uint32_t CAPACITY = (PAGE_SIZE - 8) / 5;
+
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+  }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetCount() const { return count_; }
+
+  page_id_t GetPageId(uint32_t index) const { return page_ids_[index]; }
+
+  void SetPageId(uint32_t index, page_id_t page_id) { page_ids_[index] = page_id; }
+
+  uint8_t GetCategory(uint32_t index) const { return categories_[index]; }
+
+  void SetCategory(uint32_t index, uint8_t category) { categories_[index] = category; }
+
+  /** @return false if the page is full */
+  bool Add(page_id_t page_id, uint8_t category) {
+    if (count_ == CAPACITY) {
+      return false;
+    }
+    page_ids_[count_] = page_id;
+    categories_[count_] = category;
+    count_++;
+    return true;
+  }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t count_;
+  page_id_t page_ids_[CAPACITY];
+  uint8_t categories_[CAPACITY];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE, "A free space map page must fit into a page.");
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
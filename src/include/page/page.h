@@ -1,30 +1,42 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <shared_mutex>
+#include <thread>
 
 #include "common/config.h"
-#include "common/rwlatch.h"
+#include "common/macros.h"
 
 /**
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * Inside the buffer pool a Page is only the frame descriptor, the page data lives in the pool's FrameArena. The
+ * descriptors are cache line aligned, so scanning them never touches page data and no two frames share a line.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
     // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
     friend class BufferPoolManager;
+    friend class FrameArena;
 
 public:
     DISALLOW_COPY(Page)
 
-    /** Constructor. Zeros out the page data. */
-    Page() { ResetMemory(); }
+    /** Constructor for a page outside the buffer pool. Allocates page aligned data and zeros it out. */
+    Page() : data_(static_cast<char *>(::operator new[](PAGE_SIZE, std::align_val_t{PAGE_SIZE}))), owns_data_(true) {
+        ResetMemory();
+    }
 
-    /** Default destructor. */
-    ~Page() = default;
+    ~Page() {
+        if (owns_data_) {
+            ::operator delete[](data_, std::align_val_t{PAGE_SIZE});
+        }
+    }
 
     /** @return the actual data contained within this page */
     inline char *GetData() { return data_; }
@@ -38,17 +50,60 @@ public:
     /** @return true if the page in memory has been modified from the page on disk, false otherwise */
     inline bool IsDirty() { return is_dirty_; }
 
-    /** Acquire the page write latch. */
-    inline void WLatch() { rwlatch_.WLock(); }
+    /** Acquire the page write latch. The version is odd while the latch is held. */
+    inline void WLatch() {
+        rwlatch_.lock();
+        version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
 
     /** Release the page write latch. */
-    inline void WUnlatch() { rwlatch_.WUnlock(); }
+    inline void WUnlatch() {
+        version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        rwlatch_.unlock();
+    }
 
     /** Acquire the page read latch. */
-    inline void RLatch() { rwlatch_.RLock(); }
+    inline void RLatch() { rwlatch_.lock_shared(); }
 
     /** Release the page read latch. */
-    inline void RUnlatch() { rwlatch_.RUnlock(); }
+    inline void RUnlatch() { rwlatch_.unlock_shared(); }
+
+    /**
+     * Run read on the page without taking the latch, and keep the result only if no writer held the write latch in
+     * the meantime. After OPTIMISTIC_READ_RETRIES conflicts, read runs under the read latch instead.
+     *
+     * The caller must hold a pin and must not hold the write latch. read may see a half written page: it must bound
+     * check whatever offsets it follows, and must not act on what it read before the validation.
+     * @param[out] version if not null, the version the result is valid for, see ValidateVersion
+     * @return what the validated run of read returned
+     */
+    template <class F>
+    bool ReadOptimistic(F &&read, uint64_t *version = nullptr) {
+        for (uint32_t i = 0; i < OPTIMISTIC_READ_RETRIES; i++) {
+            uint64_t start = version_.load(std::memory_order_acquire);
+            if (start % 2 == 0) {
+                bool res = read();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version_.load(std::memory_order_relaxed) == start) {
+                    if (version != nullptr) *version = start;
+                    return res;
+                }
+            }
+            std::this_thread::yield();
+        }
+        RLatch();
+        bool res = read();
+        if (version != nullptr) *version = version_.load(std::memory_order_relaxed);
+        RUnlatch();
+        return res;
+    }
+
+    /** @return true if no writer latched the page since ReadOptimistic returned version */
+    inline bool ValidateVersion(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == version;
+    }
 
     /** @return the page LSN. */
     inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
@@ -65,19 +120,26 @@ protected:
     static constexpr size_t OFFSET_LSN = 4;
 
 private:
+    /** Frame descriptor of a buffer pool, data points into the pool's frame arena. */
+    explicit Page(char *data) : data_(data) {}
+
     /** Zeroes out the data that is held within the page. */
     inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
     /** The actual data that is stored within a page. */
-    char data_[PAGE_SIZE]{};
+    char *data_;
     /** The ID of this page. */
     page_id_t page_id_ = INVALID_PAGE_ID;
     /** The pin count of this page. */
     int pin_count_ = 0;
     /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
     bool is_dirty_ = false;
+    /** True if data_ was allocated by this page rather than handed out by a frame arena. */
+    bool owns_data_ = false;
     /** Page latch. */
-    ReaderWriterLatch rwlatch_;
+    std::shared_mutex rwlatch_;
+    /** Bumped when the write latch is taken and when it is released, for optimistic readers. */
+    std::atomic<uint64_t> version_{0};
 };
 
 #endif  // MINISQL_PAGE_H
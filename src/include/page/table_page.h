@@ -15,9 +15,14 @@
  *  ----------------------------------------------------------------
  *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
  *  ----------------------------------------------------------------
+ *
+ *  Deletes and updates leave holes between the inserted tuples. They are reclaimed by Compact(), which runs when an
+ *  insert or update does not fit into the free space but fits once the holes are added. A slot of size 0 is empty
+ *  and reused by the next insert, empty slots at the end of the slot array are dropped.
  **/
 
 #include <cstring>
+#include <functional>
 
 #include "common/macros.h"
 #include "common/rowid.h"
@@ -58,10 +63,41 @@ class TablePage : public Page {
 
   bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
 
+  /**
+   * Same as GetTuple, but reads the page without its latch, see Page::ReadOptimistic. The caller must hold a pin and
+   * must not hold the write latch.
+   */
+  bool GetTupleOptimistic(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /** @return bytes left for new tuples and their slots, counting the holes a compaction would reclaim */
+  uint32_t GetFreeSpaceRemaining();
+
+  /**
+   * Slide the tuples together at the end of the page, so that the holes left by deletes and updates join the free
+   * space. Tuples keep their slots, so the RowIds of live and deleted tuples stay valid.
+   */
+  void Compact();
+
+  /**
+   * Apply the deletes of the tuples marked deleted that can_apply accepts, then compact the page.
+   * @param[out] live_tuples tuples not marked deleted
+   * @param[out] dead_tuples tuples still marked deleted afterwards
+   * @return bytes reclaimed
+   */
+  uint32_t Vacuum(const std::function<bool(const RowId &)> &can_apply, uint32_t *live_tuples, uint32_t *dead_tuples);
+
+  /** @return true if the page has no tuples, not even deleted ones */
+  bool IsEmpty() { return GetTupleCount() == 0; }
+
+  /** @return true if the slot holds a tuple marked deleted whose delete is not applied yet */
+  bool IsMarkedDeleted(uint32_t slot_num) {
+    return slot_num < GetTupleCount() && (GetTupleSize(slot_num) & DELETE_MASK) != 0;
+  }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -69,14 +105,15 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
   }
 
+  /** @return bytes between the slot array and the first tuple, usable without a compaction */
+  uint32_t GetContiguousFreeSpace() {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
   uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
@@ -103,7 +140,6 @@ class TablePage : public Page {
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
   static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
-  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
@@ -112,6 +148,7 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
 
  public:
+  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
 };
 
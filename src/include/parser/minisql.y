@@ -12,7 +12,7 @@
 }
 
 %token <syntax_node> CREATE DROP SELECT INSERT DELETE UPDATE
-%token <syntax_node> TRXBEGIN TRXCOMMIT TRXROLLBACK QUIT EXECFILE SHOW USE USING
+%token <syntax_node> TRXBEGIN TRXCOMMIT TRXROLLBACK QUIT EXECFILE SHOW USE USING VACUUM FULL
 %token <syntax_node> DATABASE DATABASES TABLE TABLES INDEX INDEXES
 %token <syntax_node> ON FROM WHERE INTO SET VALUES PRIMARY KEY UNIQUE
 %token <syntax_node> CHAR INT FLOAT AND OR NOT IS FLAGNULL
@@ -26,8 +26,8 @@
 %type <syntax_node> sql_trx_begin sql_trx_commit sql_trx_rollback
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
-%type <syntax_node> sql_insert sql_delete sql_update update_values update_value
-%type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_insert insert_tuples sql_delete sql_update update_values update_value
+%type <syntax_node> sql_quit sql_exec_file sql_show_status sql_set_variable sql_vacuum
 
 %%
 
@@ -49,6 +49,9 @@ sql:
   | sql_create_index { $$ = $1; }
   | sql_drop_index { $$ = $1; }
   | sql_show_indexes { $$ = $1; }
+  | sql_show_status { $$ = $1; }
+  | sql_set_variable { $$ = $1; }
+  | sql_vacuum { $$ = $1; }
   | sql_select { $$ = $1; }
   | sql_insert { $$ = $1; }
   | sql_delete { $$ = $1; }
@@ -65,6 +68,11 @@ sql_create_database:
     $$ = CreateSyntaxNode(kNodeCreateDB, NULL);
     SyntaxNodeAddChildren($$, $3);
   }
+  | CREATE DATABASE IDENTIFIER USING IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeCreateDB, NULL);
+    SyntaxNodeAddChildren($$, $3);
+    SyntaxNodeAddSibling($3, $5);
+  }
   ;
 
 sql_drop_database:
@@ -101,6 +109,14 @@ sql_create_table:
     SyntaxNodeAddChildren($$, $3);
     SyntaxNodeAddChildren($$, list_node);
   }
+  | CREATE TABLE IDENTIFIER '(' column_definition_list ')' USING IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeCreateTable, NULL);
+    pSyntaxNode list_node = CreateSyntaxNode(kNodeColumnDefinitionList, NULL);
+    SyntaxNodeAddChildren(list_node, $5);
+    SyntaxNodeAddChildren($$, $3);
+    SyntaxNodeAddChildren($$, list_node);
+    SyntaxNodeAddChildren($$, $8);
+  }
   ;
 
 column_list:
@@ -195,6 +211,34 @@ sql_show_indexes:
   }
   ;
 
+/* "status" and "reset" are not keywords, the execute engine checks the identifiers */
+sql_show_status:
+  SHOW IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeShowStatus, NULL);
+    SyntaxNodeAddChildren($$, $2);
+  }
+  | SHOW IDENTIFIER IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeShowStatus, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddSibling($2, $3);
+  }
+  ;
+
+/* the variable name is checked by the execute engine */
+sql_set_variable:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSetVariable, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddSibling($2, $4);
+  }
+  ;
+
+sql_vacuum:
+  VACUUM FULL {
+    $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+  }
+  ;
+
 sql_select:
   SELECT select_columns FROM IDENTIFIER {
     $$ = CreateSyntaxNode(kNodeSelect, NULL);
@@ -289,12 +333,22 @@ operator:
   ;
 
 sql_insert:
-  INSERT INTO IDENTIFIER VALUES '(' column_values ')' {
+  INSERT INTO IDENTIFIER VALUES insert_tuples {
     $$ = CreateSyntaxNode(kNodeInsert, NULL);
     SyntaxNodeAddChildren($$, $3);
-    pSyntaxNode col_val_node = CreateSyntaxNode(kNodeColumnValues, NULL);
-    SyntaxNodeAddChildren(col_val_node, $6);
-    SyntaxNodeAddChildren($$, col_val_node);
+    SyntaxNodeAddChildren($$, $5);
+  }
+  ;
+
+insert_tuples:
+  '(' column_values ')' ',' insert_tuples {
+    $$ = CreateSyntaxNode(kNodeColumnValues, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddSibling($$, $5);
+  }
+  | '(' column_values ')' {
+    $$ = CreateSyntaxNode(kNodeColumnValues, NULL);
+    SyntaxNodeAddChildren($$, $2);
   }
   ;
 
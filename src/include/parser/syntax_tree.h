@@ -43,7 +43,10 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin recovery command */
   kNodeTrxCommit,            /** commit recovery command */
-  kNodeTrxRollback           /** rollback recovery command */
+  kNodeTrxRollback,          /** rollback recovery command */
+  kNodeShowStatus,           /** show status command */
+  kNodeSetVariable,          /** set system variable command */
+  kNodeVacuum                /** vacuum full command */
 } SyntaxNodeType;
 
 /**
@@ -0,0 +1,100 @@
+#ifndef MINISQL_ASYNC_IO_H
+#define MINISQL_ASYNC_IO_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * One positional read or write handed to an AsyncIo backend. A vectored request moves the bytes at offset_ from or
+ * to the buffers in iovs_ in turn, buf_ is unused then.
+ */
+struct IoRequest {
+  enum class Op { kRead, kWrite };
+
+  Op op_{Op::kRead};
+  int fd_{-1};
+  char *buf_{nullptr};
+  size_t len_{0};  // the total over iovs_ for vectored requests
+  size_t offset_{0};
+  std::vector<struct iovec> iovs_;
+  /** Runs on the completion thread with the bytes transferred, or -errno, before waiters wake up. */
+  std::function<void(ssize_t)> on_complete_;
+
+  // set by the backend
+  std::mutex latch_;
+  std::condition_variable cv_;
+  bool done_{false};
+  ssize_t result_{0};
+  struct iovec iov_ {};
+};
+
+/**
+ * Completion handle of an asynchronous read or write. Handles are cheap to copy, all copies refer to the same I/O.
+ * An empty handle stands for an I/O that completed right away.
+ */
+class IoHandle {
+ public:
+  IoHandle() = default;
+
+  explicit IoHandle(std::shared_ptr<IoRequest> request) : request_(std::move(request)) {}
+
+  /** @return true if the I/O has completed */
+  bool IsDone() const;
+
+  /**
+   * Block until the I/O has completed.
+   * @return false if the I/O failed, a read that ran into the end of the file did not fail
+   */
+  bool Wait();
+
+ private:
+  std::shared_ptr<IoRequest> request_;
+};
+
+/**
+ * AsyncIo runs positional reads and writes in the background. A read or write always moves the whole buffer,
+ * unless it hits the end of the file or an error.
+ *
+ * Create prefers io_uring, set up through raw syscalls so no library is needed. Where the kernel does not offer it,
+ * e.g. because a seccomp filter blocks it, a pool of threads doing pread and pwrite takes over.
+ */
+class AsyncIo {
+ public:
+  enum class Backend { kAuto, kUring, kThreadPool };
+
+  virtual ~AsyncIo() = default;
+
+  /**
+   * @param backend kAuto picks io_uring if available, kUring fails with nullptr if it is not
+   * @param queue_depth I/Os a uring backend keeps in flight, threads of the thread pool backend are capped by
+   * ASYNC_IO_THREADS
+   */
+  static std::unique_ptr<AsyncIo> Create(Backend backend = Backend::kAuto, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH);
+
+  /** Start the I/O described by the request, the request must not be touched until it completes. */
+  virtual IoHandle Submit(std::shared_ptr<IoRequest> request) = 0;
+
+  /** @return "io_uring" or "threads" */
+  virtual const char *Name() const = 0;
+
+ protected:
+  /** Run the completion callback and wake up the waiters. */
+  static void Complete(IoRequest *request, ssize_t result);
+
+  /** Finish a request synchronously from the given position on, used for short transfers. */
+  static ssize_t TransferRest(IoRequest *request, size_t done);
+
+ private:
+  static ssize_t TransferRestVectored(IoRequest *request, size_t done);
+};
+
+#endif  // MINISQL_ASYNC_IO_H
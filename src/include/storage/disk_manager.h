@@ -2,27 +2,64 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <bitset>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "common/aligned_buffer.h"
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/async_io.h"
+#include "storage/io_stats.h"
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
  *
+ * Pages are read and written with positional I/O on one file descriptor, so reads and writes of data pages need no
+ * lock and can run in parallel. Writes only reach the OS, Sync makes them durable.
+ *
+ * The meta page and the free page bitmaps of all extents are kept in memory, so allocating and freeing pages needs no
+ * I/O. Changed ones are written back by Sync and Close. On open the used page counts are recounted from the bitmaps.
+ *
+ * A database created in direct I/O mode bypasses the OS page cache, so its pages are cached once, in the buffer
+ * pool. The mode is stored in the meta page. Buffers should then be aligned to PAGE_SIZE, see AlignedBuffer, other
+ * buffers are copied through an aligned one.
+ *
+ * Tables and indexes can be stored in segment files of their own, next to the database file, so dropping one only
+ * unlinks its file. The high SEGMENT_ID_BITS of a page id name the segment, segment 0 is the database file itself.
+ * Objects created once all segments are in use are stored in the database file.
+ * Each segment file has the layout below and is opened on first use. Pages of a dropped segment read as zeros.
+ *
+ * A segment can be created compressed. Its pages are compressed with LzCodec on write and stored in slots of
+ * COMPRESSED_SECTOR_SIZE sectors in a data file next to the segment file, "<segment file>.z", so scans read fewer
+ * bytes. Page slots are relocated when a page outgrows its slot. The map from page to slot is kept in memory and
+ * written back with the bitmaps, into the page slots of the segment file that a compressed segment does not use.
+ * Compressed segments always use buffered I/O.
+ *
+ * Files are not extended a page at a time by the writes past their end. When pages are allocated beyond the space
+ * reserved so far, the file is grown with fallocate by its own size, between FILE_GROWTH_MIN_PAGES and
+ * FILE_GROWTH_MAX_PAGES. The number of reserved pages is kept in the meta page. Shrink gives the space of free pages
+ * back again.
+ *
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
  */
 class DiskManager {
 public:
-    explicit DiskManager(const std::string &db_file);
+    /**
+     * @param direct_io open a new database file with O_DIRECT, an existing file keeps the mode it was created with
+     */
+    explicit DiskManager(const std::string &db_file, bool direct_io = false)
+        : DiskManager(db_file, direct_io ? DiskFileMetaPage::FLAG_DIRECT_IO : 0, nullptr) {}
 
     ~DiskManager() {
         if (!closed) {
@@ -42,12 +79,72 @@ public:
      */
     void WritePage(page_id_t logical_page_id, const char *page_data);
 
+    /**
+     * Start reading a page in the background. page_data must stay valid until the returned handle completes.
+     * The I/O is charged to the owner of the calling thread.
+     */
+    IoHandle ReadPageAsync(page_id_t logical_page_id, char *page_data);
+
+    /**
+     * Read adjacent pages with one I/O in the background, page i of the run into pages[i]. The pages must lie in one
+     * extent, see AllocatePages. In direct I/O mode the buffers must be aligned.
+     */
+    IoHandle ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages);
+
+    /**
+     * Start writing a page in the background. page_data must not change until the returned handle completes.
+     */
+    IoHandle WritePageAsync(page_id_t logical_page_id, const char *page_data);
+
+    /**
+     * Write adjacent pages with one vectored I/O in the background, pages[i] to page i of the run. The pages must lie
+     * in one extent and must not change until the returned handle completes. In direct I/O mode the buffers must be
+     * aligned. Pages of a compressed segment each go to a slot of their own.
+     */
+    IoHandle WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages);
+
+    /**
+     * @return the backend running asynchronous I/O, "io_uring" or "threads"
+     */
+    const char *GetAsyncIoBackend();
+
     /**
      * Get next free page from disk
      * @return logical page id of allocated page
      */
     page_id_t AllocatePage();
 
+    /**
+     * Allocate count pages that are adjacent in the file, so they can be read with one sequential I/O.
+     * All pages of a run lie in one extent.
+     * @return logical page id of the first page, INVALID_PAGE_ID if count is 0, larger than an extent or no run
+     * of that length is free
+     */
+    page_id_t AllocatePages(uint32_t count, segment_id_t segment_id = 0);
+
+    /**
+     * Create an empty segment file.
+     * @param compressed store the pages of the segment compressed
+     * @return the id of the new segment, 0 (the database file) if all segment ids are in use
+     */
+    segment_id_t CreateSegment(bool compressed = false);
+
+    /**
+     * Unlink the file of a segment and free its space. The file stays open until Close for I/O still in flight,
+     * its id is not handed out again before that.
+     * @return false for segment 0 or a segment that does not exist
+     */
+    bool DropSegment(segment_id_t segment_id);
+
+    /**
+     * Give back the disk space of free pages, in the database file and all segment files, see VACUUM FULL. Extents
+     * at the end without a page in use are removed and the files are truncated after the last page in use. The
+     * space of free pages and free sectors inside a file is released by punching holes. Pages in use are not moved,
+     * so their ids stay valid, but no page I/O may run at the same time, see DBStorageEngine::Shrink.
+     * @return the number of bytes of disk space released
+     */
+    size_t Shrink();
+
     /**
      * Free this page and reset bit map
      */
@@ -59,7 +156,23 @@ public:
     bool IsPageFree(page_id_t logical_page_id);
 
     /**
-     * Shut down the disk manager and close all the file resources.
+     * @return true if the file is read and written with O_DIRECT
+     */
+    bool IsDirectIo() const { return direct_io_; }
+
+    /**
+     * @return true if the pages of this file are stored compressed
+     */
+    bool IsCompressed() const { return compressed_; }
+
+    /**
+     * Write back the changed meta and bitmap pages and make all pages written so far durable, in the database file
+     * and all open segment files.
+     */
+    void Sync();
+
+    /**
+     * Shut down the disk manager and close all the file resources. Syncs the file first.
      */
     void Close();
 
@@ -69,13 +182,229 @@ public:
      */
     char *GetMetaData() { return meta_data_; }
 
+    /**
+     * @return all physical I/O done so far, including the meta and bitmap pages
+     */
+    IoStats GetIoStats() const;
+
+    /**
+     * @return the physical I/O charged to each owner, keyed by IoOwner::Key
+     */
+    std::unordered_map<uint64_t, IoStats> GetOwnerIoStats();
+
     static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+    static constexpr segment_id_t MAX_SEGMENTS = 1u << SEGMENT_ID_BITS;
+    static constexpr int SEGMENT_PAGE_BITS = 31 - SEGMENT_ID_BITS;
+
+    static segment_id_t SegmentOf(page_id_t page_id) { return static_cast<uint32_t>(page_id) >> SEGMENT_PAGE_BITS; }
+
+    static page_id_t LocalPageId(page_id_t page_id) { return page_id & ((1 << SEGMENT_PAGE_BITS) - 1); }
+
+    static page_id_t MakePageId(segment_id_t segment_id, page_id_t local_page_id) {
+        return static_cast<page_id_t>(segment_id << SEGMENT_PAGE_BITS) | local_page_id;
+    }
+
+    static std::string SegmentFileName(const std::string &db_file, segment_id_t segment_id) {
+        return db_file + ".seg" + std::to_string(segment_id);
+    }
+
+    /**
+     * @return the file the buffer pool saves its working set to on shutdown, see BufferPoolManager::Prewarm
+     */
+    static std::string WorkingSetFileName(const std::string &db_file) { return db_file + ".prewarm"; }
+
+    /**
+     * Remove a database file, all its segment files and its saved working set
+     */
+    static void RemoveFiles(const std::string &db_file);
 
 private:
     /**
-     * Helper function to get disk file size
+     * A page slot of a compressed file, in sectors of the data file. length_ is 0 for a page never written and
+     * PAGE_SIZE for a page stored uncompressed.
+     */
+    struct PageSlot {
+        uint32_t sector_;
+        uint16_t length_;
+        uint16_t sectors_;
+    };
+    static_assert(sizeof(PageSlot) == 8, "Page slots are stored in slot map pages as they are.");
+
+    static constexpr uint32_t SLOT_MAP_ENTRIES = PAGE_SIZE / sizeof(PageSlot);
+    static constexpr uint32_t SLOT_MAP_PAGES = BITMAP_SIZE / SLOT_MAP_ENTRIES;  // per extent
+    static constexpr uint16_t MAX_SLOT_SECTORS = PAGE_SIZE / COMPRESSED_SECTOR_SIZE;
+
+    /**
+     * @param flags DiskFileMetaPage flags given to a new file, an existing file keeps its own
+     * @param parent the disk manager of the database file when opening one of its segment files, which then shares
+     * the asynchronous I/O backend and the I/O statistics of the parent
+     */
+    DiskManager(const std::string &db_file, uint32_t flags, DiskManager *parent);
+
+    /**
+     * @return the open segment file, nullptr if the segment does not exist
      */
-    int GetFileSize(const std::string &file_name);
+    DiskManager *GetSegment(segment_id_t segment_id);
+
+    /**
+     * Open a segment file, the caller holds segment_latch_
+     * @param create create the file if it does not exist
+     * @param compressed create the file compressed
+     */
+    DiskManager *OpenSegment(segment_id_t segment_id, bool create, bool compressed = false);
+
+    /**
+     * Open the data file of a compressed file
+     */
+    void OpenDataFile();
+
+    /**
+     * Read the slot maps of all extents and find the free sectors between the slots, the caller holds db_io_latch_
+     */
+    void LoadSlotMap();
+
+    /**
+     * Write back the slot map pages changed since the last call, the caller holds db_io_latch_
+     */
+    void FlushSlotMap();
+
+    static page_id_t SlotMapPhysicalId(uint32_t map_page) {
+        return MapPageId(map_page / SLOT_MAP_PAGES * BITMAP_SIZE + map_page % SLOT_MAP_PAGES);
+    }
+
+    /**
+     * @return the slot of a page, an empty one if the page has never been written
+     */
+    PageSlot GetSlot(page_id_t logical_page_id);
+
+    /**
+     * Find a slot for a page about to be written with the given compressed length. The page keeps its slot if it
+     * fits, otherwise it is moved.
+     */
+    PageSlot PlaceSlot(page_id_t logical_page_id, uint16_t length);
+
+    /**
+     * Give back the slot of a freed page
+     */
+    void ReleaseSlot(page_id_t logical_page_id);
+
+    uint32_t AllocateSectors(uint16_t count);
+
+    void FreeSectors(uint32_t sector, uint32_t count);
+
+    /**
+     * Free sectors the slot map on disk may still refer to, they are handed out again once the map is synced
+     */
+    void RetireSectors(uint32_t sector, uint32_t count) { retired_sectors_.emplace_back(sector, count); }
+
+    /**
+     * Compress a page into out, which holds PAGE_SIZE bytes
+     * @return the compressed length, PAGE_SIZE if the page is stored uncompressed
+     */
+    static uint16_t EncodePage(const char *page_data, char *out);
+
+    /**
+     * Decompress the data of a slot into a page, a page that cannot be decompressed reads as zeros
+     * @param available bytes of the slot actually read
+     */
+    void DecodeSlot(const PageSlot &slot, const char *data, size_t available, char *page_data);
+
+    void ReadCompressedPage(page_id_t logical_page_id, char *page_data);
+
+    void WriteCompressedPage(page_id_t logical_page_id, const char *page_data);
+
+    /**
+     * Read adjacent pages whose slots follow each other in the data file with one I/O, other runs synchronously
+     */
+    IoHandle ReadCompressedPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages);
+
+    IoHandle WriteCompressedPageAsync(page_id_t logical_page_id, const char *page_data);
+
+    /**
+     * pread until len bytes are read, the end of the file is reached or an error occurs
+     * @return the number of bytes read
+     */
+    size_t ReadAt(int fd, char *buf, size_t len, size_t offset);
+
+    /**
+     * pwrite all len bytes
+     * @return false on an I/O error
+     */
+    bool WriteAt(int fd, const char *buf, size_t len, size_t offset);
+
+    /**
+     * Write back the changed meta and bitmap pages and fsync this file only
+     */
+    void SyncFile();
+
+    /**
+     * Shrink this file only, see Shrink
+     */
+    size_t ShrinkFile();
+
+    /**
+     * Release the disk space of a byte range, which reads as zeros afterwards
+     */
+    void PunchHole(int fd, size_t offset, size_t len);
+
+    /**
+     * @return the disk space taken by the files of this disk manager
+     */
+    size_t GetAllocatedBytes() const;
+
+    /**
+     * Make sure the file has space up to the given page reserved, the caller holds db_io_latch_
+     */
+    void ReserveSpace(page_id_t logical_page_id);
+
+    /**
+     * Helper function to get disk file size, only used on open. Later the size is tracked in file_size_.
+     */
+    static size_t GetFileSize(int fd);
+
+    /**
+     * Switch the open file to O_DIRECT, stays with buffered I/O if the file system does not support it
+     */
+    void EnableDirectIo();
+
+    /**
+     * Read the bitmaps of all extents and bring the used page counts in line with them
+     */
+    void LoadBitmaps();
+
+    /**
+     * Write back the meta page and the bitmaps changed since the last call, the caller holds db_io_latch_
+     */
+    void FlushBitmaps();
+
+    /**
+     * @return the lowest extent with a free page, the number of extents if all are full
+     */
+    uint32_t FindExtentWithSpace() const;
+
+    /**
+     * Append an extent with an empty bitmap
+     * @return the id of the new extent
+     */
+    uint32_t AddExtent();
+
+    /**
+     * Count pages just allocated in (count > 0) or freed from (count < 0) an extent
+     */
+    void RecordAllocation(uint32_t extent_id, int32_t count);
+
+    /**
+     * Record whether an extent has a free page after its used page count changed
+     */
+    void UpdateExtentSpace(uint32_t extent_id);
+
+    DiskFileMetaPage *GetMeta() { return reinterpret_cast<DiskFileMetaPage *>(meta_data_); }
+
+    BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id) {
+        return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmaps_[extent_id].Data());
+    }
+
+    static page_id_t BitmapPhysicalId(uint32_t extent_id) { return extent_id * (BITMAP_SIZE + 1) + 1; }
 
     /**
      * Read physical page from disk
@@ -87,19 +416,72 @@ private:
      */
     void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+    /**
+     * Add one physical read or write to the totals and to the owner of the current thread
+     */
+    void RecordIo(const IoStats &stats, IoOwner owner = IoOwnerScope::Current());
+
+    /**
+     * @return the asynchronous I/O backend, created on first use
+     */
+    AsyncIo *GetAsyncIo();
+
+    static uint64_t ElapsedNs(std::chrono::steady_clock::time_point start);
+
     /**
      * Map logical page id to physical page id
      */
-    page_id_t MapPageId(page_id_t logical_page_id);
+    static page_id_t MapPageId(page_id_t logical_page_id);
 
 private:
-    // stream to write db file
-    std::fstream db_io_;
+    // db file, read and written with pread and pwrite only
+    int fd_{-1};
     std::string file_name_;
-    // with multiple buffer pool instances, need to protect file access
+    // end of the last page written, pages beyond it read as zeros
+    std::atomic<size_t> file_size_{0};
+    // protects the meta page and the bitmap pages
     std::recursive_mutex db_io_latch_;
+    std::once_flag async_io_once_;
+    std::unique_ptr<AsyncIo> async_io_;
     bool closed{false};
-    char meta_data_[PAGE_SIZE];
+    bool direct_io_{false};
+    // false once fallocate turned out not to be supported, protected by db_io_latch_
+    bool preallocate_{true};
+    // the database file's disk manager if this one manages a segment file
+    DiskManager *parent_{nullptr};
+    // the segment file has been unlinked, protected by db_io_latch_
+    bool dropped_{false};
+    // segments_ and segment_files_ are only changed under segment_latch_, segments_ is read without it
+    std::mutex segment_latch_;
+    std::atomic<DiskManager *> segments_[MAX_SEGMENTS]{};
+    std::vector<std::unique_ptr<DiskManager>> segment_files_;
+    // dropped in this session, their ids are not reused while the files are still open
+    std::bitset<MAX_SEGMENTS> segment_retired_;
+    // the meta page and the bitmaps are protected by db_io_latch_
+    alignas(PAGE_SIZE) char meta_data_[PAGE_SIZE];
+    bool meta_dirty_{false};
+    std::vector<AlignedBuffer> bitmaps_;
+    std::vector<bool> bitmap_dirty_;
+    // bit i % 64 of word i / 64 is set while extent i has a free page
+    std::vector<uint64_t> extents_with_space_;
+
+    // data file of a compressed file, holding the page slots
+    bool compressed_{false};
+    int data_fd_{-1};
+    // the slot of each page and the free sectors of the data file are protected by db_io_latch_
+    std::vector<PageSlot> slots_;
+    std::vector<bool> slot_map_dirty_;
+    std::vector<uint32_t> free_sectors_[MAX_SLOT_SECTORS + 1];  // free slots by their number of sectors
+    uint32_t data_end_{0};                                      // sectors in use up to here
+    std::vector<std::pair<uint32_t, uint32_t>> retired_sectors_;  // freed since the slot map was last synced
+
+    std::atomic<uint64_t> pages_read_{0};
+    std::atomic<uint64_t> pages_written_{0};
+    std::atomic<uint64_t> bytes_read_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+    std::atomic<uint64_t> io_time_ns_{0};
+    std::mutex stats_latch_;
+    std::unordered_map<uint64_t, IoStats> owner_stats_;  // protected by stats_latch_
 };
 
 #endif
\ No newline at end of file
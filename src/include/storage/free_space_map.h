@@ -0,0 +1,97 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/extent_allocator.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * Approximate free space of every page of a table heap, so that an insert goes straight to a page with room instead
+ * of trying the pages of the heap one after the other. The free space of a page is kept as a category of
+ * CATEGORY_BYTES, rounded down, so a page is never promised more room than it has.
+ *
+ * The map is held in memory and written through to a chain of FreeSpaceMapPage, whose root is kept in the table's
+ * metadata. A map without a root lives in memory only, it is rebuilt from the heap pages when the heap is opened.
+ * The map pages are allocated one at a time in the heap's segment file, apart from the heap's extents so that those
+ * stay runs of adjacent heap pages.
+ *
+ * The heap pages are listed in the order they were added to the heap, which is their order in the heap's page chain.
+ * A page removed from the heap leaves an entry of INVALID_PAGE_ID behind, so that the other entries keep their place.
+ * Callers must not hold the latch of a heap page while calling into the map.
+ */
+class FreeSpaceMap {
+ public:
+  static constexpr uint32_t CATEGORY_BYTES = PAGE_SIZE / 256;
+
+  /**
+   * @param segment_id the segment file of the heap, 0 for the database file
+   */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, segment_id_t segment_id)
+      : buffer_pool_manager_(buffer_pool_manager), allocator_(buffer_pool_manager, 1, segment_id) {}
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  /**
+   * Start an empty map on disk.
+   * @return false if no page could be allocated, the map is kept in memory only then
+   */
+  bool Create();
+
+  /** Read the map whose first page is root_page_id. */
+  void Load(page_id_t root_page_id);
+
+  /** Record a page just appended to the heap. */
+  void AddPage(page_id_t page_id, uint32_t free_space);
+
+  /** Record the free space of a heap page after an insert, update or delete. Unknown pages are ignored. */
+  void Update(page_id_t page_id, uint32_t free_space);
+
+  /** Forget a page unlinked from the heap, it must not be the last one. Unknown pages are ignored. */
+  void RemovePage(page_id_t page_id);
+
+  /**
+   * @param size bytes the insert needs, including its slot
+   * @param skip pages not to return, e.g. the ones other inserts are filling
+   * @return a heap page that had at least size bytes free when last recorded, INVALID_PAGE_ID if none has
+   */
+  page_id_t FindPage(uint32_t size, const std::vector<page_id_t> &skip = {});
+
+  /** @return the heap page added last, the end of the heap's page chain */
+  page_id_t GetLastPageId();
+
+  /** @return the number of heap pages listed */
+  size_t GetPageCount();
+
+  /** @return the first page of the map on disk, INVALID_PAGE_ID for a map in memory only */
+  page_id_t GetRootPageId() const { return root_page_id_; }
+
+  /** Delete the pages of the map on disk, the map is empty afterwards. */
+  void Free();
+
+ private:
+  static uint8_t ToCategory(uint32_t free_space) {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_space / CATEGORY_BYTES, UINT8_MAX));
+  }
+
+  /** Append an entry in memory, INVALID_PAGE_ID for a removed page, the caller holds latch_. */
+  void Append(page_id_t page_id, uint8_t category);
+
+  BufferPoolManager *buffer_pool_manager_;
+  ExtentAllocator allocator_;
+  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::mutex latch_;
+  // everything below is protected by latch_, entry i is slot i % CAPACITY of map page i / CAPACITY
+  std::vector<page_id_t> page_ids_;
+  std::vector<uint8_t> categories_;
+  std::unordered_map<page_id_t, uint32_t> entries_;  // heap page id to its entry
+  std::vector<page_id_t> map_pages_;                 // the chain of map pages, empty for a map in memory only
+  std::vector<uint8_t> max_categories_;              // the largest category of each map page's entries
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
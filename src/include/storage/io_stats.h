@@ -0,0 +1,72 @@
+#ifndef MINISQL_IO_STATS_H
+#define MINISQL_IO_STATS_H
+
+#include <cstdint>
+
+/**
+ * The table or index the I/O of the current thread is done for.
+ */
+struct IoOwner {
+  enum class Kind : uint32_t { kNone, kTable, kIndex };
+
+  static IoOwner Table(uint32_t table_id) { return {Kind::kTable, table_id}; }
+
+  static IoOwner Index(uint32_t index_id) { return {Kind::kIndex, index_id}; }
+
+  static IoOwner FromKey(uint64_t key) { return {static_cast<Kind>(key >> 32), static_cast<uint32_t>(key)}; }
+
+  /** @return a single integer identifying the owner, used to key per-owner counters */
+  uint64_t Key() const { return (static_cast<uint64_t>(kind_) << 32) | id_; }
+
+  Kind kind_{Kind::kNone};
+  uint32_t id_{0};
+};
+
+/**
+ * Disk I/O done by the disk manager, in total or for one owner.
+ */
+struct IoStats {
+  IoStats &operator+=(const IoStats &that) {
+    pages_read_ += that.pages_read_;
+    pages_written_ += that.pages_written_;
+    bytes_read_ += that.bytes_read_;
+    bytes_written_ += that.bytes_written_;
+    io_time_ns_ += that.io_time_ns_;
+    return *this;
+  }
+
+  /** @return the I/O done since that snapshot was taken */
+  IoStats operator-(const IoStats &that) const {
+    return {pages_read_ - that.pages_read_, pages_written_ - that.pages_written_, bytes_read_ - that.bytes_read_,
+            bytes_written_ - that.bytes_written_, io_time_ns_ - that.io_time_ns_};
+  }
+
+  uint64_t pages_read_{0};
+  uint64_t pages_written_{0};
+  uint64_t bytes_read_{0};
+  uint64_t bytes_written_{0};
+  uint64_t io_time_ns_{0};
+};
+
+/**
+ * Charges the buffer pool and disk activity of the current thread to an owner while the scope is alive.
+ * Scopes nest, the innermost owner wins. Work done by background threads is not charged to anyone.
+ */
+class IoOwnerScope {
+ public:
+  explicit IoOwnerScope(IoOwner owner) : prev_(current_) { current_ = owner; }
+
+  IoOwnerScope(const IoOwnerScope &) = delete;
+
+  IoOwnerScope &operator=(const IoOwnerScope &) = delete;
+
+  ~IoOwnerScope() { current_ = prev_; }
+
+  static IoOwner Current() { return current_; }
+
+ private:
+  IoOwner prev_;
+  static inline thread_local IoOwner current_{};
+};
+
+#endif  // MINISQL_IO_STATS_H
@@ -1,36 +1,89 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/extent_allocator.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
+#include "storage/io_stats.h"
 #include "storage/table_iterator.h"
 
+/**
+ * Dead tuples of a table heap and the space vacuuming gave back, see TableHeap::Vacuum. The tuple counts are taken by
+ * each vacuum and kept up to date by inserts and deletes in between. A heap opened from disk counts from 0 until its
+ * first vacuum.
+ */
+struct VacuumStats {
+  uint64_t live_tuples_{0};
+  uint64_t dead_tuples_{0};      // tuples marked deleted, their space is not reused yet
+  uint64_t reclaimed_bytes_{0};  // tuple and slot bytes given back to the pages by all vacuums
+  uint64_t freed_pages_{0};      // empty pages given back to the disk manager
+  uint64_t vacuums_{0};
+
+  double GetDeadTupleRatio() const {
+    uint64_t tuples = live_tuples_ + dead_tuples_;
+    return tuples == 0 ? 0.0 : static_cast<double>(dead_tuples_) / tuples;
+  }
+};
+
 class TableHeap {
   friend class TableIterator;
 
  public:
+  /**
+   * @param extent_size adjacent pages the heap reserves at a time, so that scans read the file sequentially
+   * @param segment_id the segment file holding the heap's pages, see BufferPoolManager::CreateSegment
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
-                           LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
+                           LockManager *lock_manager, uint32_t extent_size = TABLE_HEAP_EXTENT_SIZE,
+                           segment_id_t segment_id = 0) {
+    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager, extent_size, segment_id);
   }
 
+  /**
+   * @param free_space_map_page_id the root of the heap's free space map, see GetFreeSpaceMapPageId. Without one the
+   * map is rebuilt in memory from the heap pages before the first change to the heap.
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           uint32_t extent_size = TABLE_HEAP_EXTENT_SIZE,
+                           page_id_t free_space_map_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager, extent_size,
+                         free_space_map_page_id);
   }
 
   ~TableHeap() {}
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table, into the page the calling thread's insert point is filling, a page the free space
+   * map finds room in, or a new page appended to the heap. If the tuple is too large (>= page_size), return false.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
+   * @param[in] strategy Access strategy for the pages read or created, e.g. a bulk write ring for bulk loads
    * @return true iff the insert is successful
    */
-  bool InsertTuple(Row &row, Txn *txn);
+  bool InsertTuple(Row &row, Txn *txn, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Insert many tuples at once. Each page is latched once for as many tuples as fit into it, the pages appended for
+   * the rest are linked into the page chain in one pass.
+   * @param[in/out] rows Tuples to insert in this order, the rid of each inserted tuple is wrapped in its row
+   * @param[in] txn The recovery performing the insert
+   * @param[out] rids If not null, the rids of the inserted tuples are appended to it
+   * @param[in] strategy Access strategy for the pages read or created, a bulk write ring keeps the new pages from
+   * pushing the working set out of the buffer pool
+   * @return true iff all tuples were inserted. Nothing is inserted if one of them is too large for a page.
+   */
+  bool InsertTuples(std::vector<Row> &rows, Txn *txn, std::vector<RowId> *rids = nullptr,
+                    BufferAccessStrategy *strategy = nullptr);
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -72,26 +125,33 @@ class TableHeap {
   bool GetTuple(Row *row, Txn *txn);
 
   void FreeTableHeap() {
+    if (DropSegment()) {
+      return;
+    }
     auto next_page_id = first_page_id_;
     while (next_page_id != INVALID_PAGE_ID) {
       auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
+      PageGuard guard = buffer_pool_manager_->FetchPageBasic(old_page_id);
+      assert(guard.IsValid());
+      next_page_id = reinterpret_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+      guard.Drop();
       buffer_pool_manager_->DeletePage(old_page_id);
     }
+    free_space_map_.Free();
+    extent_allocator_.Release();
   }
 
   /**
-   * Free table heap and release storage in disk file
+   * Free table heap and release storage in disk file. A heap in a segment file of its own is dropped by removing
+   * the file.
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param strategy Access strategy for the pages the scan reads in, e.g. a bulk read ring for full table passes
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   /**
    * @return the end iterator of this table
@@ -103,11 +163,58 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return adjacent pages the heap reserves at a time
+   */
+  inline uint32_t GetExtentSize() const { return extent_allocator_.GetExtentSize(); }
+
+  /**
+   * @return the segment file holding the heap's pages, 0 for the database file
+   */
+  inline segment_id_t GetSegmentId() const { return extent_allocator_.GetSegmentId(); }
+
+  /**
+   * @return the first page of the heap's free space map, to be kept in the table's metadata. INVALID_PAGE_ID if the
+   * map is kept in memory only.
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_.GetRootPageId(); }
+
+  /**
+   * Spread the inserts of concurrent threads over count pages, so that they do not all wait for the latch of the same
+   * page. Threads are assigned to the insert points round robin. By default there is one insert point per core, up to
+   * MAX_TABLE_INSERT_POINTS. Call it before the heap is shared between threads.
+   */
+  void SetInsertPointCount(uint32_t count) { insert_pages_ = MakeInsertPoints(count); }
+
+  inline uint32_t GetInsertPointCount() const { return insert_pages_.size(); }
+
+  /**
+   * Charge the buffer pool and disk activity of this heap to the table, shown by SHOW STATUS.
+   */
+  void SetTableId(table_id_t table_id) { io_owner_ = IoOwner::Table(table_id); }
+
   /**
    * @return if the table is empty
    */
   bool IsEmpty(Txn *txn) { return Begin(txn) == End(); }
 
+  /**
+   * Apply the deletes of the tuples marked deleted that no rollback needs anymore, compact the pages and give the
+   * pages left empty back to the disk manager. It runs alongside the other operations on the heap, but empty pages
+   * are only unlinked from the page chain while no insert or scan is using the heap, the others wait for the next
+   * vacuum. The first and the last page are kept.
+   * @return bytes reclaimed
+   */
+  size_t Vacuum();
+
+  /**
+   * @return true if enough of the heap's tuples are marked deleted for a vacuum to pay off, see
+   * VACUUM_MIN_DEAD_TUPLES and VACUUM_DEAD_TUPLE_RATIO, or if the heap was opened and not vacuumed yet
+   */
+  bool NeedsVacuum() const;
+
+  VacuumStats GetVacuumStats() const;
+
  private:
   /**
    * create table heap and initialize first page
@@ -124,33 +231,113 @@ class TableHeap {
                          Schema *schema,
                          Txn *txn,
                          LogManager *log_manager,
-                         LockManager *lock_manager)
+                         LockManager *lock_manager,
+                         uint32_t extent_size,
+                         segment_id_t segment_id)
             : buffer_pool_manager_(buffer_pool_manager),
               schema_(schema),
               log_manager_(log_manager),
-              lock_manager_(lock_manager) {
-        // 1) 分配新页
+              lock_manager_(lock_manager),
+              extent_allocator_(buffer_pool_manager, extent_size, segment_id),
+              free_space_map_(buffer_pool_manager, segment_id) {
+        // 1) 分配新页, the first page of the first extent
         page_id_t pid;
-        Page *raw = buffer_pool_manager_->NewPage(pid);
-        auto *table_page = reinterpret_cast<TablePage *>(raw);
+        PageGuard guard = extent_allocator_.NewPageGuarded(pid);
+        auto *table_page = reinterpret_cast<TablePage *>(guard.GetPage());
 
         // 2) 初始化该页
         table_page->Init(pid, INVALID_PAGE_ID, log_manager_, txn);
+        uint32_t free_space = table_page->GetFreeSpaceRemaining();
 
-        // 3) 写回并 unpin
-        buffer_pool_manager_->UnpinPage(pid, /*is_dirty=*/true);
+        // 3) 标脏，guard 析构时 unpin
+        guard.SetDirty();
+        guard.Drop();
 
-        // 4) 记录首页
+        // 4) 记录首页, and start the free space map with it
         first_page_id_ = pid;
+        free_space_map_.Create();
+        free_space_map_.AddPage(pid, free_space);
+        free_space_map_ready_ = true;
     }
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, uint32_t extent_size,
+                     page_id_t free_space_map_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager),
+        extent_allocator_(buffer_pool_manager, extent_size,
+                          first_page_id == INVALID_PAGE_ID ? 0 : DiskManager::SegmentOf(first_page_id)),
+        free_space_map_(buffer_pool_manager, extent_allocator_.GetSegmentId()) {
+    if (free_space_map_page_id != INVALID_PAGE_ID) {
+      free_space_map_.Load(free_space_map_page_id);
+      free_space_map_ready_ = true;
+    }
+    // the tuples of the heap are only counted by its first vacuum
+    tuple_counts_known_ = false;
+  }
+
+  /**
+   * @return the free space map, rebuilt in memory from the heap pages first if the heap was opened without one
+   */
+  FreeSpaceMap &GetFreeSpaceMap();
+
+  /**
+   * @param count insert points, 0 for one per core up to MAX_TABLE_INSERT_POINTS
+   * @return insert points that are not filling a page yet
+   */
+  static std::vector<std::atomic<page_id_t>> MakeInsertPoints(uint32_t count = 0);
+
+  /** @return the page the other insert points are filling, for the free space map to skip */
+  std::vector<page_id_t> GetOtherInsertPages(const std::atomic<page_id_t> &insert_page) const;
+
+  /**
+   * Inserts and scans keep page ids of the heap between latching its pages, they hold the page chain meanwhile so
+   * that Vacuum() does not free those pages under them. Entering waits while a vacuum is freeing pages.
+   */
+  void EnterPageChain();
+
+  void LeavePageChain() { page_chain_users_.fetch_sub(1); }
+
+  class PageChainUser {
+   public:
+    explicit PageChainUser(TableHeap *table_heap) : table_heap_(table_heap) { table_heap_->EnterPageChain(); }
+
+    ~PageChainUser() { table_heap_->LeavePageChain(); }
+
+    DISALLOW_COPY_AND_MOVE(PageChainUser);
+
+   private:
+    TableHeap *table_heap_;
+  };
+
+  /**
+   * Unlink the empty pages from the page chain and the free space map, the caller holds append_latch_ and no thread
+   * holds the page chain.
+   * @return the pages unlinked
+   */
+  std::vector<page_id_t> UnlinkEmptyPages(const std::vector<page_id_t> &page_ids);
+
+  /** @return true if the unlinked page was given back to the disk manager, false if it is still in use */
+  bool FreeUnlinkedPage(page_id_t page_id);
+
+  /** The delete of the tuple was applied or rolled back, drop it from the pending deletes and from the txn. */
+  void ForgetDelete(const RowId &rid, Txn *txn);
+
+  /**
+   * Drop the whole heap at once if it has a segment file of its own
+   * @return false if the heap lives in the database file
+   */
+  bool DropSegment() {
+    if (GetSegmentId() == 0) {
+      return false;
+    }
+    extent_allocator_.Release();
+    buffer_pool_manager_->DropSegment(GetSegmentId());
+    return true;
+  }
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -158,6 +345,27 @@ class TableHeap {
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  IoOwner io_owner_;
+  ExtentAllocator extent_allocator_;
+  FreeSpaceMap free_space_map_;
+  std::atomic<bool> free_space_map_ready_{false};
+  std::mutex append_latch_;  // serializes appending pages to the page chain and rebuilding the free space map
+  // the page each insert point is filling, the free space map is only told about it once it is full
+  std::vector<std::atomic<page_id_t>> insert_pages_{MakeInsertPoints()};
+  std::atomic<uint32_t> page_chain_users_{0};
+  std::atomic<bool> freeing_pages_{false};
+  std::mutex pending_deletes_latch_;  // taken after a page latch, never before
+  // tuples marked deleted whose delete may still be rolled back: the ones deleted by a transaction until it commits or
+  // aborts, and the old tuples of updates that move their tuple
+  std::unordered_set<RowId> pending_deletes_;
+  std::mutex vacuum_latch_;                // one vacuum at a time
+  std::vector<page_id_t> unlinked_pages_;  // unlinked but not freed yet because they were in use, under vacuum_latch_
+  std::atomic<int64_t> live_tuples_{0};
+  std::atomic<int64_t> dead_tuples_{0};
+  std::atomic<uint64_t> reclaimed_bytes_{0};
+  std::atomic<uint64_t> freed_pages_{0};
+  std::atomic<uint64_t> vacuums_{0};
+  std::atomic<bool> tuple_counts_known_{true};
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,6 +1,9 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
@@ -10,7 +13,8 @@ class TableHeap;
 class TableIterator {
 public:
  // you may define your own constructor based on your member variables
- explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn);
+ explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                        std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
  TableIterator(const TableIterator &other);
 
@@ -37,6 +41,17 @@ private:
     Txn *txn_;               // 事务上下文
 
     Row cur_row_;            // 存放当前行内容
+    std::shared_ptr<BufferAccessStrategy> strategy_;  // 扫描读入页面时使用的访问策略
+
+    /**
+     * Keep up to TABLE_READ_AHEAD_PAGES pages after the current one in flight. The heap is a linked list, so the
+     * window is extended one page at a time, whenever the last requested page has been read in.
+     */
+    void ReadAhead(page_id_t page_id);
+
+    page_id_t cur_page_id_{INVALID_PAGE_ID};        // page of the last ReadAhead call
+    page_id_t read_ahead_frontier_{INVALID_PAGE_ID};  // last page handed to the prefetcher
+    uint32_t pages_ahead_{0};                       // pages between the current page and the frontier
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
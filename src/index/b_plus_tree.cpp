@@ -1,6 +1,9 @@
 #include "index/b_plus_tree.h"
 
+#include <cstring>
 #include <string>
+#include <thread>
+#include <utility>
 
 #include "glog/logging.h"
 #include "index/basic_comparator.h"
@@ -8,21 +11,64 @@
 #include "page/index_roots_page.h"
 #include "page/b_plus_tree_leaf_page.h"
 #include "page/header_page.h"  // 包含 HeaderPage 的定义
+#include "storage/io_stats.h"
 
 /**
  * TODO: Student Implement
  */
 
+namespace {
+
+/**
+ * Held by Insert and Remove for the whole operation. Members are destroyed in reverse order, so the page latches are
+ * released before the structure version turns even again and the next writer gets in.
+ */
+class TreeWriteScope {
+ public:
+  TreeWriteScope(std::mutex &writer_latch, std::atomic<uint64_t> &structure_version)
+      : writer_guard_(writer_latch), version_bump_(structure_version) {}
+
+ private:
+  struct VersionBump {
+    explicit VersionBump(std::atomic<uint64_t> &version) : version_(version) { version_++; }
+    ~VersionBump() { version_++; }
+    std::atomic<uint64_t> &version_;
+  };
+
+  std::lock_guard<std::mutex> writer_guard_;
+  VersionBump version_bump_;
+  PageWriteScope page_scope_;
+};
+
+// a snapshot of a tree page, taken by an optimistic read
+struct alignas(8) NodeCopy {
+  char data_[PAGE_SIZE];
+};
+
+// copy the page without latching it, the copy is consistent and valid for the returned page version
+uint64_t Snapshot(const PageGuard &guard, NodeCopy *copy) {
+  uint64_t version;
+  guard.GetPage()->ReadOptimistic(
+      [&]() {
+        memcpy(copy->data_, guard.GetData(), PAGE_SIZE);
+        return true;
+      },
+      &version);
+  return version;
+}
+
+}  // namespace
 
 
 BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
-                     int leaf_max_size, int internal_max_size)
+                     int leaf_max_size, int internal_max_size, uint32_t extent_size, segment_id_t segment_id)
         : root_page_id_(INVALID_PAGE_ID),
           index_id_(index_id),
           buffer_pool_manager_(buffer_pool_manager),
           processor_(KM),
           leaf_max_size_(leaf_max_size),
-          internal_max_size_(internal_max_size){
+          internal_max_size_(internal_max_size),
+          extent_allocator_(buffer_pool_manager, extent_size, segment_id) {
     if (leaf_max_size > 0) {
         leaf_max_size_ = leaf_max_size;
     } else {
@@ -40,39 +86,38 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
     }
 
 // —— 初始化或加载 header page ——
-    Page *hdr = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-    if (hdr == nullptr) {
+    PageGuard hdr = buffer_pool_manager_->FetchPageBasic(INDEX_ROOTS_PAGE_ID);
+    if (!hdr.IsValid()) {
         // header page 不存在，第一次创建
         page_id_t pid;
-        hdr = buffer_pool_manager_->NewPage(pid);
-        CHECK(hdr != nullptr && pid == INDEX_ROOTS_PAGE_ID);
-        auto *header = reinterpret_cast<HeaderPage *>(hdr->GetData());
-        header->Init();
-        buffer_pool_manager_->UnpinPage(pid, /*is_dirty=*/true);
+        hdr = buffer_pool_manager_->NewPageGuarded(pid);
+        CHECK(hdr.IsValid() && pid == INDEX_ROOTS_PAGE_ID);
+        hdr.SetDirty();
+        reinterpret_cast<HeaderPage *>(hdr.GetPage())->Init();
         root_page_id_ = INVALID_PAGE_ID;
     } else {
         // header page 已存在，读取之前写入的 root_page_id
-        auto *header = reinterpret_cast<HeaderPage *>(hdr->GetData());
+        auto *header = reinterpret_cast<HeaderPage *>(hdr.GetPage());
         page_id_t loaded_root = INVALID_PAGE_ID;
         if (header->GetRootId(std::to_string(index_id_), &loaded_root)) {
             root_page_id_ = loaded_root;
         } else {
             root_page_id_ = INVALID_PAGE_ID;
         }
-        buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, /*is_dirty=*/false);
     }
 }
 
 void BPlusTree::Destroy(page_id_t current_page_id) {
+    IoOwnerScope owner_scope(IoOwner::Index(index_id_));
     if (current_page_id == INVALID_PAGE_ID) {
         return;
     }
     // 1. Fetch 并 pin 当前页面
-    auto *page = buffer_pool_manager_->FetchPage(current_page_id);
-    if (page == nullptr) {
+    PageGuard guard = buffer_pool_manager_->FetchPageBasic(current_page_id);
+    if (!guard.IsValid()) {
         return;
     }
-    auto *tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    auto *tree_page = guard.As<BPlusTreePage>();
     if (tree_page->IsLeafPage()) {
         // --- 叶子页：删除堆上分配的 GenericKey* ---
         auto *leaf = reinterpret_cast<LeafPage *>(tree_page);
@@ -91,10 +136,20 @@ void BPlusTree::Destroy(page_id_t current_page_id) {
         }
     }
     // 2. 删除当前页：先 unpin，再 delete
-    buffer_pool_manager_->UnpinPage(current_page_id, /*is_dirty=*/false);
+    guard.Drop();
     buffer_pool_manager_->DeletePage(current_page_id);
 }
 
+bool BPlusTree::DropSegment() {
+    segment_id_t segment_id = extent_allocator_.GetSegmentId();
+    if (segment_id == 0) {
+        return false;
+    }
+    extent_allocator_.Release();
+    buffer_pool_manager_->DropSegment(segment_id);
+    root_page_id_ = INVALID_PAGE_ID;
+    return true;
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -113,6 +168,7 @@ bool BPlusTree::IsEmpty() const {
  * @return : true means key exists
  */
 bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) {
+    IoOwnerScope owner_scope(IoOwner::Index(index_id_));
     // cout << "Enter GetValue" << endl;
     // 1. 如果树为空，直接返回 false
     if (IsEmpty()) {
@@ -120,31 +176,38 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn
         return false;
     }
 
-    // 2. 定位到包含目标 key 的叶子页并 pin
-    Page *page = FindLeafPage(key);
-    // cout << "FindLeafPage: " << page->GetPageId() << endl;
-    if (page == nullptr) {
-        // 没有找到对应的页（极少出现，防御性编程）
-        return false;
-    }
-
-    // 3. 将原始 Page* 数据区转换为叶子页类型
-    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    // A writer may move the key to another leaf while we descend, so a miss only counts if no writer was active.
+    // After too many misses like that, wait for the writers instead.
+    for (uint32_t attempt = 0;; attempt++) {
+        std::unique_lock<std::mutex> writers(writer_latch_, std::defer_lock);
+        if (attempt == OPTIMISTIC_READ_RETRIES) {
+            writers.lock();
+        }
+        uint64_t structure_version = structure_version_.load();
 
-    // 4. 在叶子页中查找 key
-    RowId value;
-    bool found = leaf->Lookup(key, value, processor_);
+        // 2. 定位到包含目标 key 的叶子页并 pin
+        PageGuard guard = FindLeafPage(key);
+        if (!guard.IsValid()) {
+            return false;
+        }
 
-    // 5. 如果找到，就把 RowId 加入结果列表
-    if (found) {
-        result.push_back(value);
+        // 3. 在叶子页的快照中查找 key
+        NodeCopy copy;
+        Snapshot(guard, &copy);
+        auto *leaf = reinterpret_cast<LeafPage *>(copy.data_);
+        RowId value;
+        bool found = leaf->IsLeafPage() && leaf->Lookup(key, value, processor_);
+
+        // 4. 如果找到，就把 RowId 加入结果列表
+        if (found) {
+            result.push_back(value);
+            return true;
+        }
+        if (writers.owns_lock() || (structure_version % 2 == 0 && structure_version_.load() == structure_version)) {
+            return false;
+        }
+        std::this_thread::yield();
     }
-
-    // 6. unpin 叶子页（查找时 pin，使用后必须 unpin；此处不做修改所以 is_dirty=false）
-    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), /*is_dirty=*/false);
-
-    // 7. 返回是否命中
-    return found;
 }
 
 /*****************************************************************************
@@ -191,22 +254,25 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn
 //}
 
 bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *txn) {
+    IoOwnerScope owner_scope(IoOwner::Index(index_id_));
+    TreeWriteScope write_scope(writer_latch_, structure_version_);
     if (IsEmpty()) {
         // cout << "Start new tree" << endl;
         StartNewTree(key, value);
         return true;
     }
     // 1 次 pin
-    Page *page = FindLeafPage(key);
-    if (page == nullptr) return false;
-    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
-
-    // 统一让 InsertIntoLeaf 去做插入和可能的 split/new_leaf unpin
-    bool ok = InsertIntoLeaf(leaf, key, value, txn);
+    PageGuard guard = FindLeafPage(key);
+    if (!guard.IsValid()) return false;
+    auto *leaf = guard.As<LeafPage>();
+    RowId existing;
+    if (leaf->Lookup(key, existing, processor_)) {
+        return false;
+    }
 
-    // **这里** 对最初 pin 的 leaf 做配对 unpin
-    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), /*is_dirty=*/ok);
-    return ok;
+    // 统一让 InsertIntoLeaf 去做插入和可能的 split，标脏时会拿到叶子页的写锁
+    guard.SetDirty();
+    return InsertIntoLeaf(leaf, key, value, txn);
 }
 
 
@@ -219,13 +285,13 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *txn) {
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
     // 1) 正确分配一页并拿到它的 page_id
     page_id_t new_root_id;
-    Page *page = buffer_pool_manager_->NewPage(new_root_id);
-    if (page == nullptr) {
+    PageGuard guard = extent_allocator_.NewPageGuarded(new_root_id);
+    if (!guard.IsValid()) {
         throw std::runtime_error("Out of memory");
     }
 
     // 2) 拿到数据区，初始化叶子节点
-    auto *leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
+    auto *leaf_page = guard.AsMut<LeafPage>();
     leaf_page->Init(new_root_id,
                     INVALID_PAGE_ID,
                     processor_.GetKeySize(),
@@ -239,7 +305,7 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
     // cout << "Update root page id: " << root_page_id_ << endl;
 
 
-    buffer_pool_manager_->UnpinPage(new_root_id, /*is_dirty=*/true);
+    guard.Drop();
 
     // 5) 再写到 header page（insert_record = true）
     UpdateRootPageId(/*insert_record=*/true);
@@ -313,14 +379,13 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
 
 bool BPlusTree::InsertIntoLeaf(LeafPage *leaf, GenericKey *key,
                                const RowId &value, Txn *txn) {
-    // —— 已经 pin 了 leaf，不要再 FindLeafPage ——
+    // —— 已经 pin 了 leaf，不要再 FindLeafPage；leaf 的 pin 由调用者的 guard 负责 ——
 
     // 1. 检查重复
     RowId tmp;
     if (leaf->Lookup(key, tmp, processor_)) {
-        // duplicate：直接 unpin leaf 并返回 false
+        // duplicate：直接返回 false
         // cout << "Duplicate key!!!" << endl;
-        buffer_pool_manager_->UnpinPage(leaf->GetPageId(), /*is_dirty=*/false);
         return false;
     }
 
@@ -329,7 +394,8 @@ bool BPlusTree::InsertIntoLeaf(LeafPage *leaf, GenericKey *key,
 
     // 3. 分裂
     if (status == -1) {
-        LeafPage *new_leaf = Split(leaf, txn);  // new_leaf 被 pin
+        PageGuard new_guard = Split(leaf, txn);  // new_leaf 被 pin，离开作用域时 unpin
+        auto *new_leaf = new_guard.AsMut<LeafPage>();
         GenericKey *promote = new_leaf->KeyAt(0);
         InsertIntoParent(leaf, promote, new_leaf, txn);
         // 决定最终往哪页插
@@ -337,11 +403,9 @@ bool BPlusTree::InsertIntoLeaf(LeafPage *leaf, GenericKey *key,
             leaf = new_leaf;
         }
         leaf->Insert(key, value, processor_);
-        // **配对 unpin new_leaf**
-        buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), /*is_dirty=*/true);
     }
 
-    // **不在这里 unpin 原 leaf**，留给 Insert() 统一处理
+    // **不在这里 unpin 原 leaf**，留给 Insert() 的 guard 处理
     return true;
 }
 
@@ -354,16 +418,16 @@ bool BPlusTree::InsertIntoLeaf(LeafPage *leaf, GenericKey *key,
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
  */
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
+PageGuard BPlusTree::Split(InternalPage *node, Txn *transaction) {
     // 1. 向 BufferPoolManager 请求一页新页面（已 pin）
     page_id_t new_page_id;
-    Page *page = buffer_pool_manager_->NewPage(new_page_id);
-    if (page == nullptr) {
+    PageGuard guard = extent_allocator_.NewPageGuarded(new_page_id);
+    if (!guard.IsValid()) {
         throw std::bad_alloc();  // 内存不足
     }
 
     // 2. 初始化新内部页：继承 parent_id、key_size，使用 internal_max_size_
-    auto *new_internal = reinterpret_cast<InternalPage *>(page->GetData());
+    auto *new_internal = guard.AsMut<InternalPage>();
     new_internal->Init(new_page_id,
                        node->GetParentPageId(),
                        node->GetKeySize(),
@@ -372,19 +436,19 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
     // 3. 将 node 的后半部分条目搬到 new_internal（含 child parent_id 更新）
     node->MoveHalfTo(new_internal, buffer_pool_manager_);
 
-    // 4. 返回新页（保持 pin，由调用者在合适时机 unpin 并标记脏页）
-    return new_internal;
+    // 4. 返回新页（保持 pin，已标记脏页，由调用者的 guard unpin）
+    return guard;
 }
 
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
+PageGuard BPlusTree::Split(LeafPage *node, Txn *transaction) {
     // 1. 申请新页（已 pin）
     // cout << "Split LeafPage: " << node->GetPageId() << endl;
     page_id_t new_page_id;
-    Page *page = buffer_pool_manager_->NewPage(new_page_id);
-    if (page == nullptr) {
+    PageGuard guard = extent_allocator_.NewPageGuarded(new_page_id);
+    if (!guard.IsValid()) {
         throw std::bad_alloc();
     }
-    auto *new_leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    auto *new_leaf = guard.AsMut<LeafPage>();
 
     // 2. 初始化新叶子页
     new_leaf->Init(new_page_id,
@@ -402,8 +466,8 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
     node->MoveHalfTo(new_leaf);
     // cout << "MoveHalfTo: " << node->GetPageId() << endl;
 
-    // 5. 返回新页（保持 pin，由调用者后面 unpin & 标记脏页）
-    return new_leaf;
+    // 5. 返回新页（保持 pin，已标记脏页，由调用者的 guard unpin）
+    return guard;
 }
 
 /*
@@ -426,9 +490,9 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
         // a. 申请新页（已 pin）
         // cout << "Create new root page" << endl;
         page_id_t new_root_id;
-        Page *p = buffer_pool_manager_->NewPage(new_root_id);
-        if (p == nullptr) throw std::bad_alloc();
-        auto *root = reinterpret_cast<InternalPage *>(p->GetData());
+        PageGuard root_guard = extent_allocator_.NewPageGuarded(new_root_id);
+        if (!root_guard.IsValid()) throw std::bad_alloc();
+        auto *root = root_guard.AsMut<InternalPage>();
 
         // b. 初始化为内部页，parent = INVALID
         root->Init(new_root_id,
@@ -445,9 +509,7 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
         new_node->SetParentPageId(new_root_id);
         // cout << "SetParentPageId: old_node " << old_node->GetPageId() << " new_node " << new_node->GetPageId() << endl;
 
-        // e. 释放子树页 pin，标记为脏
-        buffer_pool_manager_->UnpinPage(old_page_id, /*is_dirty=*/true);
-        buffer_pool_manager_->UnpinPage(new_page_id, /*is_dirty=*/true);
+        // e. 子树页的 pin 由调用者的 guard 负责
 
         // f. 更新树的根指针 & 写 header
         root_page_id_ = new_root_id;
@@ -456,17 +518,14 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
         UpdateRootPageId(/*insert_record=*/true);
         // cout << "Update header page" << endl;
 
-        // g. 释放新根页 pin
-        buffer_pool_manager_->UnpinPage(new_root_id, /*is_dirty=*/true);
-
         return;
     }
 
     // 2) 非根节点：找到父节点并 pin
     page_id_t parent_page_id = old_node->GetParentPageId();
-    Page *p = buffer_pool_manager_->FetchPage(parent_page_id);
-    if (p == nullptr) throw std::runtime_error("Failed to fetch parent page");
-    auto *parent = reinterpret_cast<InternalPage *>(p->GetData());
+    PageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(parent_page_id);
+    if (!parent_guard.IsValid()) throw std::runtime_error("Failed to fetch parent page");
+    auto *parent = parent_guard.AsMut<InternalPage>();
 
     // 3) 在 parent 中，old_page_id 之后插入 <key, new_page_id>
     int new_size = parent->InsertNodeAfter(old_page_id, key, new_page_id);
@@ -476,22 +535,15 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
     // 4) 如果 parent 溢出，split 并递归上溢
     if (new_size > internal_max_size_) {
         // a. split parent（返回已 pin 的新内部页）
-        InternalPage *new_internal = Split(parent, transaction);
+        PageGuard new_internal_guard = Split(parent, transaction);
+        auto *new_internal = new_internal_guard.AsMut<InternalPage>();
         // 推上去的分隔 key 就是 new_internal->KeyAt(0)
         GenericKey *up_key = new_internal->KeyAt(0);
 
-        // b. 先 unpin 原父页
-        buffer_pool_manager_->UnpinPage(parent_page_id, /*is_dirty=*/true);
-
-        // c. 递归：把 up_key 和 new_internal 插入上一层
+        // b. 递归：把 up_key 和 new_internal 插入上一层
         InsertIntoParent(parent, up_key, new_internal, transaction);
-
-        // d. 释放新内部页 pin
-        buffer_pool_manager_->UnpinPage(new_internal->GetPageId(), /*is_dirty=*/true);
-    } else {
-        // 5) 没有溢出，直接 unpin 父页并标记脏
-        buffer_pool_manager_->UnpinPage(parent_page_id, /*is_dirty=*/true);
     }
+    // 5) 父页和新内部页的 pin 由 guard 释放
 }
 
 /*****************************************************************************
@@ -505,27 +557,31 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  * necessary.
  */
 void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
-    cout << "Key to remove: " << key << endl;
+    IoOwnerScope owner_scope(IoOwner::Index(index_id_));
+    TreeWriteScope write_scope(writer_latch_, structure_version_);
     // 1. 空树直接返回
     if (IsEmpty()) {
         return;
     }
 
     // 2. 定位到叶子页并 pin
-    Page *page = FindLeafPage(key);
-    cout << "FindLeafPage: " << page->GetPageId() << endl;
-    if (page == nullptr) {
+    PageGuard guard = FindLeafPage(key);
+    if (!guard.IsValid()) {
         return;
     }
-    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    auto *leaf = guard.As<LeafPage>();
     page_id_t leaf_page_id = leaf->GetPageId();
+    RowId existing;
+    if (!leaf->Lookup(key, existing, processor_)) {
+        return;
+    }
+    guard.SetDirty();
 
     // 3. 在叶子页中删除记录
     int deleted_cnt = leaf->RemoveAndDeleteRecord(key, processor_);
     if (deleted_cnt <= 0) {
         // key 不存在，无需修改
         // cout << "Key not found in leaf page: " << leaf_page_id << endl;
-        buffer_pool_manager_->UnpinPage(leaf_page_id, /*is_dirty=*/false);
         return;
     }
     // cout << "Deleted  a record from leaf page: " << leaf_page_id << endl;
@@ -533,31 +589,24 @@ void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
     // 4. 如果叶子页是根节点
     if (leaf->IsRootPage()) {
         if (leaf->GetSize() == 0) {
-            // 整棵树删除完毕
-            buffer_pool_manager_->UnpinPage(leaf_page_id, /*is_dirty=*/false);
-            buffer_pool_manager_->DeletePage(leaf_page_id);
+            // 整棵树删除完毕，先改根再删页，读者据此发现旧根已失效
             root_page_id_ = INVALID_PAGE_ID;
+            guard.Drop();
+            buffer_pool_manager_->DeletePage(leaf_page_id);
             // 从 header 中移除记录
             UpdateRootPageId(/*insert_record=*/0);
-        } else {
-            // 根叶子页还剩元素，只需标脏
-            buffer_pool_manager_->UnpinPage(leaf_page_id, /*is_dirty=*/true);
         }
+        // 根叶子页还剩元素，guard 标脏后 unpin
         return;
     }
 
     // 5. 非根叶子页：检测下溢
-    int min_size = leaf->GetMinSize();
-    bool deleted = false;
-    if (leaf->GetSize() < min_size) {
+    // 如果通过合并真正删除了该页，CoalesceOrRedistribute 会先让 guard 放掉 pin 再 DeletePage，
+    // 否则 guard 析构时 unpin。
+    if (leaf->GetSize() < leaf->GetMinSize()) {
         // 合并或重分配
-        deleted = CoalesceOrRedistribute<LeafPage>(leaf, transaction);
+        CoalesceOrRedistribute<LeafPage>(guard, transaction);
     }
-
-    // 6. unpin & 标脏
-    // 如果通过合并真正删除了该页，CoalesceOrRedistribute 内部会做 DeletePage 操作，
-    // 此处只需 unpin 可能残留的页即可。
-    buffer_pool_manager_->UnpinPage(leaf_page_id, /*is_dirty=*/true);
 }
 
 /* todo
@@ -568,57 +617,49 @@ void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
  * deletion happens
  */
 template <typename N>
-bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
+bool BPlusTree::CoalesceOrRedistribute(PageGuard &node_guard, Txn *transaction) {
+    auto *node = node_guard.AsMut<N>();
     // 1. 如果是根节点，调用 AdjustRoot 并返回其结果
     if (node->IsRootPage()) {
-        return AdjustRoot(node);
+        return AdjustRoot(node_guard);
     }
 
     // 2. Fetch 父节点
-    page_id_t parent_id = node->GetParentPageId();
-    Page *parent_page = buffer_pool_manager_->FetchPage(parent_id);
-    auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+    PageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+    auto *parent = parent_guard.AsMut<InternalPage>();
 
     // 3. 找到 node 在 parent 中的下标
     int index = parent->ValueIndex(node->GetPageId());
 
     // 4. Fetch 兄弟节点（左或右），并 pin
-    N *sibling = nullptr;
-    Page *sibling_page = nullptr;
-    if (index == 0) {
-        // 没有左兄弟，拿右兄弟
-        page_id_t sid = parent->ValueAt(1);
-        sibling_page = buffer_pool_manager_->FetchPage(sid);
-        sibling = reinterpret_cast<N *>(sibling_page->GetData());
-    } else {
-        // 否则拿左兄弟
-        page_id_t sid = parent->ValueAt(index - 1);
-        sibling_page = buffer_pool_manager_->FetchPage(sid);
-        sibling = reinterpret_cast<N *>(sibling_page->GetData());
-    }
+    // 没有左兄弟，拿右兄弟；否则拿左兄弟
+    page_id_t sid = index == 0 ? parent->ValueAt(1) : parent->ValueAt(index - 1);
+    PageGuard sibling_guard = buffer_pool_manager_->FetchPageBasic(sid);
+    auto *sibling = sibling_guard.AsMut<N>();
 
     // 5. 决定合并还是重分配
     int combined_size = sibling->GetSize() + node->GetSize();
     if (combined_size <= node->GetMaxSize()) {
-        // 合并：会在 Coalesce 内部删除 node 或 sibling、更新 parent
+        // 合并：Coalesce 把右边的页搬空并更新 parent，这里放掉它的 pin 后再删除
         bool parent_underflow = Coalesce(sibling, node, parent, index, transaction);
-        buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
+        PageGuard &emptied_guard = index == 0 ? sibling_guard : node_guard;
+        page_id_t emptied_page_id = emptied_guard.PageId();
+        emptied_guard.Drop();
+        buffer_pool_manager_->DeletePage(emptied_page_id);
         if (parent_underflow) {
-            return CoalesceOrRedistribute<InternalPage>(parent, transaction);
+            CoalesceOrRedistribute<InternalPage>(parent_guard, transaction);
         }
-        return false;
+        return index != 0;
     } else {
         // 重分配：会在 Redistribute 内部更新 parent 的分隔 key
         Redistribute(sibling, node, index);
-        buffer_pool_manager_->UnpinPage(sibling->GetPageId(), /*is_dirty=*/true);
-        buffer_pool_manager_->UnpinPage(parent_id, /*is_dirty=*/true);
         return false;
     }
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
+ * Move all the key & value pairs from one page to its sibling page, the caller
+ * deletes the emptied page once it has released its pin. Parent page must be adjusted to
  * take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
@@ -634,15 +675,12 @@ bool BPlusTree::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage
         // node 是第0个 child，neighbor_node 是右兄弟
         // 把右兄弟的数据搬到 node（左页）
         neighbor_node->MoveAllTo(node);
-        // 删除右兄弟所在页
-        buffer_pool_manager_->DeletePage(neighbor_node->GetPageId());
         // parent 中移除第1个 key+pointer
         parent->Remove(1);
     } else {
         // neighbor_node 是左兄弟，node 是右页
         // 把 node 的数据搬到左兄弟
         node->MoveAllTo(neighbor_node);
-        buffer_pool_manager_->DeletePage(node->GetPageId());
         // parent 中移除对应于 node 的 entry
         parent->Remove(index);
     }
@@ -658,14 +696,12 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
         GenericKey *sep_key = parent->KeyAt(1);
         // 把右兄弟的数据 + sep_key 搬到 node（左页）
         neighbor_node->MoveAllTo(node, sep_key, buffer_pool_manager_);
-        buffer_pool_manager_->DeletePage(neighbor_node->GetPageId());
         parent->Remove(1);
     } else {
         // neighbor_node 是左兄弟，node 是右页
         GenericKey *sep_key = parent->KeyAt(index);
         // 把 node 的数据 + sep_key 搬到左兄弟
         node->MoveAllTo(neighbor_node, sep_key, buffer_pool_manager_);
-        buffer_pool_manager_->DeletePage(node->GetPageId());
         parent->Remove(index);
     }
     // 返回父页是否下溢，需要上层继续合并/重分配
@@ -683,9 +719,8 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
  */
 void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
     // 1) 取父节点
-    page_id_t parent_id = node->GetParentPageId();
-    Page *parent_page = buffer_pool_manager_->FetchPage(parent_id);
-    auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+    PageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+    auto *parent = parent_guard.AsMut<InternalPage>();
 
     if (index == 0) {
         // node 是最左叶子，只能从右兄弟借第一个元素
@@ -698,15 +733,11 @@ void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index)
         // 更新 parent 分隔键：parent->KeyAt(index) 对应 separator between child(index-1)&child(index)
         parent->SetKeyAt(index, node->KeyAt(0));
     }
-
-    // 2) unpin 父页并标记脏
-    buffer_pool_manager_->UnpinPage(parent_id, /*is_dirty=*/true);
 }
 void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
     // 1) 取父节点
-    page_id_t parent_id = node->GetParentPageId();
-    Page *parent_page = buffer_pool_manager_->FetchPage(parent_id);
-    auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+    PageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+    auto *parent = parent_guard.AsMut<InternalPage>();
 
     if (index == 0) {
         // node 是最左内部节点，只能从右兄弟借第一个 entry
@@ -721,9 +752,6 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
         // 更新 parent 分隔键
         parent->SetKeyAt(index, node->KeyAt(1));
     }
-
-    // 2) unpin 父页并标记脏
-    buffer_pool_manager_->UnpinPage(parent_id, /*is_dirty=*/true);
 }
 /*
  * Update root page if necessary
@@ -735,7 +763,8 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
  * @return : true means root page should be deleted, false means no deletion
  * happened
  */
-bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
+bool BPlusTree::AdjustRoot(PageGuard &root_guard) {
+    auto *old_root_node = root_guard.As<BPlusTreePage>();
     page_id_t old_root_id = old_root_node->GetPageId();
 
     // --- 情况 1: 根是叶子页 ---
@@ -743,10 +772,10 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
         auto *leaf = reinterpret_cast<LeafPage *>(old_root_node);
         // 如果删除后叶子页空了，就删掉根
         if (leaf->GetSize() == 0) {
-            // 删除根页
-            buffer_pool_manager_->DeletePage(old_root_id);
-            // 更新树为空
+            // 更新树为空，再删除根页
             root_page_id_ = INVALID_PAGE_ID;
+            root_guard.Drop();
+            buffer_pool_manager_->DeletePage(old_root_id);
             // 同步到 header page
             UpdateRootPageId(/*insert_record=*/0);
             return true;  // 根已被删除
@@ -761,18 +790,16 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
     if (root_internal->GetSize() == 1) {
         // 拿到唯一的 child page id
         page_id_t child_id = root_internal->RemoveAndReturnOnlyChild();
-        // 删除旧根
-        buffer_pool_manager_->DeletePage(old_root_id);
-        // 设置新的 root_page_id_
+        // 设置新的 root_page_id_，再删除旧根
         root_page_id_ = child_id;
+        root_guard.Drop();
+        buffer_pool_manager_->DeletePage(old_root_id);
         // cout << "Update root page id: " << root_page_id_ << endl;
         // 更新新的根在 header page
         UpdateRootPageId(/*insert_record=*/0);
         // 把新根的 parent_id 设为 INVALID
-        Page *child_page = buffer_pool_manager_->FetchPage(child_id);
-        auto *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-        child_node->SetParentPageId(INVALID_PAGE_ID);
-        buffer_pool_manager_->UnpinPage(child_id, /*is_dirty=*/true);
+        PageGuard child_guard = buffer_pool_manager_->FetchPageBasic(child_id);
+        child_guard.AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
         return true;  // 根已被替换
     }
 
@@ -789,20 +816,16 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin() {
+    IoOwnerScope owner_scope(IoOwner::Index(index_id_));
     // 1. 找到最左叶子页并 pin
-    Page *page = FindLeafPage(nullptr, INVALID_PAGE_ID, /*leftMost=*/true);
-    if (page == nullptr) {
+    PageGuard guard = FindLeafPage(nullptr, INVALID_PAGE_ID, /*leftMost=*/true);
+    if (!guard.IsValid()) {
         // 空树，返回 end iterator
-        return IndexIterator(INVALID_PAGE_ID, buffer_pool_manager_, 0);
+        return IndexIterator();
     }
-    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
-    page_id_t pid = leaf->GetPageId();
-
-    // 2. unpin 刚才 pin 的页，让 iterator 自行 fetch
-    buffer_pool_manager_->UnpinPage(pid, /*is_dirty=*/false);
 
-    // 3. 由页 id、buffer pool 和起始索引 0 构造 iterator
-    return IndexIterator(pid, buffer_pool_manager_, /*index=*/0);
+    // 2. 把叶子页的 guard 交给 iterator，不必再 fetch 一次
+    return IndexIterator(std::move(guard), buffer_pool_manager_, /*index=*/0);
 }
 
 
@@ -812,23 +835,19 @@ IndexIterator BPlusTree::Begin() {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin(const GenericKey *key) {
+    IoOwnerScope owner_scope(IoOwner::Index(index_id_));
     // 1. 定位到包含 key 的叶子页并 pin
-    Page *page = FindLeafPage(key, INVALID_PAGE_ID, /*leftMost=*/false);
-    if (page == nullptr) {
+    PageGuard guard = FindLeafPage(key, INVALID_PAGE_ID, /*leftMost=*/false);
+    if (!guard.IsValid()) {
         // 如果没找到，返回 end iterator
-        return IndexIterator(INVALID_PAGE_ID, buffer_pool_manager_, 0);
+        return IndexIterator();
     }
-    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
-    page_id_t pid = leaf->GetPageId();
 
     // 2. 在叶子页内找到从哪里开始迭代
-    int idx = leaf->KeyIndex(key, processor_);
+    int idx = guard.As<LeafPage>()->KeyIndex(key, processor_);
 
-    // 3. unpin 该页，后续 iterator 会自行 re-pin
-    buffer_pool_manager_->UnpinPage(pid, /*is_dirty=*/false);
-
-    // 4. 构造并返回 iterator
-    return IndexIterator(pid, buffer_pool_manager_, idx);
+    // 3. 把叶子页的 guard 交给 iterator
+    return IndexIterator(std::move(guard), buffer_pool_manager_, idx);
 }
 
 
@@ -851,42 +870,89 @@ IndexIterator BPlusTree::End() {
  * the left most leaf page
  * Note: the leaf page is pinned, you need to unpin it after use.
  */
-Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
-    // 1. 如果整棵树为空，直接返回 nullptr
-    if (root_page_id_ == INVALID_PAGE_ID) {
-        return nullptr;
+PageGuard BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
+    // writers only read pages their own scope may have latched, and nobody else changes the tree meanwhile
+    if (PageWriteScope::IsActive()) {
+        return FindLeafPageLatched(key, page_id, leftMost);
     }
 
-    // 2. 确定起点 page_id：若用户未指定，则从 root_page_id_ 开始
-    page_id_t cur_page_id = (page_id == INVALID_PAGE_ID ? root_page_id_ : page_id);
-    Page *page = buffer_pool_manager_->FetchPage(cur_page_id);
-    if (page == nullptr) {
-        return nullptr;
+    // 每层先把节点拷贝成快照，校验版本后再解释快照；pin 住子页后再确认父页没变，否则从头再来
+    NodeCopy copy;
+    auto *node = reinterpret_cast<BPlusTreePage *>(copy.data_);
+    while (true) {
+        // 1. 如果整棵树为空，直接返回空 guard
+        page_id_t root_page_id = root_page_id_;
+        if (root_page_id == INVALID_PAGE_ID) {
+            return PageGuard();
+        }
+
+        // 2. 确定起点 page_id：若用户未指定，则从根开始
+        page_id_t cur_page_id = (page_id == INVALID_PAGE_ID ? root_page_id : page_id);
+        PageGuard guard = buffer_pool_manager_->FetchPageBasic(cur_page_id);
+        if (!guard.IsValid()) {
+            return guard;
+        }
+        uint64_t version = Snapshot(guard, &copy);
+        // the root was replaced between reading root_page_id_ and pinning it, writers update root_page_id_ before
+        // they free the old root
+        if (page_id == INVALID_PAGE_ID && (!node->IsRootPage() || root_page_id_ != root_page_id)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // 3. 反复向下，直到到达叶子页
+        bool restart = false;
+        while (!node->IsLeafPage()) {
+            auto *internal = reinterpret_cast<InternalPage *>(node);
+            if (internal->GetSize() < 1) {
+                // an old root emptied by AdjustRoot
+                restart = true;
+                break;
+            }
+            page_id_t next_page_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, processor_);
+            PageGuard child = buffer_pool_manager_->FetchPageBasic(next_page_id);
+            if (!guard.GetPage()->ValidateVersion(version)) {
+                // the parent changed, the child may have been split, merged or freed
+                restart = true;
+                break;
+            }
+            if (!child.IsValid()) {
+                return child;
+            }
+            guard = std::move(child);
+            version = Snapshot(guard, &copy);
+        }
+        if (restart) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // 4. 此时 guard 持有叶子页的 pin，由调用者的 guard 释放
+        return guard;
     }
+}
 
-    // 3. 反复向下，直到到达叶子页
-    BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+PageGuard BPlusTree::FindLeafPageLatched(const GenericKey *key, page_id_t page_id, bool leftMost) {
+    if (root_page_id_ == INVALID_PAGE_ID) {
+        return PageGuard();
+    }
+    page_id_t cur_page_id = (page_id == INVALID_PAGE_ID ? root_page_id_.load() : page_id);
+    PageGuard guard = buffer_pool_manager_->FetchPageBasic(cur_page_id);
+    if (!guard.IsValid()) {
+        return guard;
+    }
+    auto *node = guard.As<BPlusTreePage>();
     while (!node->IsLeafPage()) {
         auto *internal = reinterpret_cast<InternalPage *>(node);
-        page_id_t next_page_id;
-        if (leftMost) {
-            // 若要求最左叶子，始终沿第 0 个 child 指针下钻
-            next_page_id = internal->ValueAt(0);
-        } else {
-            // 否则根据 key 的大小，调用 InternalPage::Lookup 找到应该下钻的 child 下标
-            next_page_id = internal->Lookup(key, processor_);
-        }
-        // 将当前内部页 unpin 后，再读取下一个 child
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), /*is_dirty=*/false);
-        page = buffer_pool_manager_->FetchPage(next_page_id);
-        if (page == nullptr) {
-            return nullptr;
+        page_id_t next_page_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, processor_);
+        // 读取下一个 child，赋值给 guard 时会 unpin 当前内部页
+        guard = buffer_pool_manager_->FetchPageBasic(next_page_id);
+        if (!guard.IsValid()) {
+            return guard;
         }
-        node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+        node = guard.As<BPlusTreePage>();
     }
-
-    // 4. 此时 page 指向叶子页，并且仍处于 pin 状态。unpin 在调用者处完成
-    return page;
+    return guard;
 }
 
 /*
@@ -902,17 +968,16 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
 
 void BPlusTree::UpdateRootPageId(int insert_record) {
     // 1. 从 buffer pool 中拿到 header page，并 pin
-    Page *page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-    if (page == nullptr) {
+    // 2. 互斥写锁，防止并发修改
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(INDEX_ROOTS_PAGE_ID);
+    if (!guard.IsValid()) {
         LOG(FATAL) << "Cannot fetch INDEX_ROOTS_PAGE_ID page";
         return;
     }
 
-    // 2. 互斥写锁，防止并发修改
-    page->WLatch();
-
     // 3. 拿到 HeaderPage 对象
-    auto *header = reinterpret_cast<HeaderPage *>(page->GetData());
+    auto *header = reinterpret_cast<HeaderPage *>(guard.GetPage());
+    guard.SetDirty();
     header->Init();
 
     const std::string index_name = std::to_string(index_id_);
@@ -928,12 +993,7 @@ void BPlusTree::UpdateRootPageId(int insert_record) {
         LOG(ERROR) << (insert_record ? "InsertRecord" : "UpdateRecord")
                    << " failed for index " << index_name;
     }
-
-    // 5. 解写锁
-    page->WUnlatch();
-
-    // 6. unpin 并标记为脏页，让 buffer pool 持久化到 disk
-    buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, /*is_dirty=*/true);
+    // 5. guard 析构时解写锁、unpin 并标记为脏页，让 buffer pool 持久化到 disk
 }
 
 /**
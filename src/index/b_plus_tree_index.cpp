@@ -6,7 +6,9 @@
 BPlusTreeIndex::BPlusTreeIndex(index_id_t        index_id,
                                IndexSchema      *key_schema,
                                size_t            key_size,
-                               BufferPoolManager *buffer_pool_manager)
+                               BufferPoolManager *buffer_pool_manager,
+                               uint32_t          extent_size,
+                               segment_id_t      segment_id)
         : Index(index_id, key_schema),
           processor_(key_schema, key_size),
         // 直接在这里计算并传入 leaf_max_size 和 internal_max_size
@@ -19,7 +21,9 @@ BPlusTreeIndex::BPlusTreeIndex(index_id_t        index_id,
                   ),
                   /* internal_max_size = */ static_cast<int>(
                           (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (key_size + sizeof(page_id_t))
-                  )
+                  ),
+                  extent_size,
+                  segment_id
           ) {
     // 其余初始化保持不变
 }
@@ -119,6 +123,9 @@ dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn,
 }
 
 dberr_t BPlusTreeIndex::Destroy() {
+  if (container_.DropSegment()) {
+    return DB_SUCCESS;
+  }
   container_.Destroy();
   return DB_SUCCESS;
 }
@@ -1,5 +1,7 @@
 #include "index/index_iterator.h"
 
+#include <utility>
+
 #include "index/basic_comparator.h"
 #include "index/generic_key.h"
 
@@ -12,16 +14,20 @@
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
     if (page_id != INVALID_PAGE_ID) {
-        auto *frame = buffer_pool_manager->FetchPage(page_id);
-        page = reinterpret_cast<LeafPage *>(frame->GetData());
+        page_guard = buffer_pool_manager->FetchPageBasic(page_id);
+        page = page_guard.As<LeafPage>();
     }
-  page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
 }
 
-IndexIterator::~IndexIterator() {
-  if (current_page_id != INVALID_PAGE_ID)
-    buffer_pool_manager->UnpinPage(current_page_id, false);
-}
+IndexIterator::IndexIterator(PageGuard leaf_guard, BufferPoolManager *bpm, int index)
+    : current_page_id(leaf_guard.PageId()),
+      page(leaf_guard.As<LeafPage>()),
+      item_index(index),
+      buffer_pool_manager(bpm),
+      page_guard(std::move(leaf_guard)) {}
+
+// page_guard 析构时 unpin 当前叶子页
+IndexIterator::~IndexIterator() = default;
 
 /**
  * TODO: Student Implement
@@ -47,7 +53,7 @@ IndexIterator &IndexIterator::operator++() {
     if (page != nullptr) {
         next_page_id = page->GetNextPageId();
         // unpin 掉当前页
-        buffer_pool_manager->UnpinPage(current_page_id, /*is_dirty=*/false);
+        page_guard.Drop();
     }
 
     if (next_page_id == INVALID_PAGE_ID) {
@@ -58,8 +64,8 @@ IndexIterator &IndexIterator::operator++() {
     } else {
         // fetch & pin 下一页
         current_page_id = next_page_id;
-        Page *p = buffer_pool_manager->FetchPage(current_page_id);
-        page = reinterpret_cast<LeafPage *>(p->GetData());
+        page_guard = buffer_pool_manager->FetchPageBasic(current_page_id);
+        page = page_guard.As<LeafPage>();
         item_index = 0;
     }
 
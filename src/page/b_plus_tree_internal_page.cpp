@@ -186,9 +186,8 @@ void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool
         // 拿到拷贝后的 child_page_id
         page_id_t child = ValueAt(dest_idx);
         // 更新 child 页的 parent_page_id
-        Page *child_page = buffer_pool_manager->FetchPage(child);
-        reinterpret_cast<BPlusTreePage *>(child_page)->SetParentPageId(GetPageId());
-        buffer_pool_manager->UnpinPage(child, /*is_dirty=*/true);
+        PageGuard child_guard = buffer_pool_manager->FetchPageBasic(child);
+        child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
     }
 
     // 更新本页大小
@@ -253,9 +252,8 @@ void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, Bu
 
     // 5） 更新 recipient 中 middle key child 的 parent_page_id
     page_id_t child = recipient->ValueAt(recipient->GetSize() - 1);
-    Page *child_page = buffer_pool_manager->FetchPage(child);
-    reinterpret_cast<BPlusTreePage *>(child_page)->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(child, /*is_dirty=*/true);
+    PageGuard child_guard = buffer_pool_manager->FetchPageBasic(child);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(recipient->GetPageId());
 }
 
 /*****************************************************************************
@@ -284,9 +282,8 @@ void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_
     Remove(0);
     // 6) 更新 recipient 中 middle key child 的 parent_page_id
     page_id_t child = recipient->ValueAt(recipient->GetSize() - 1);
-    Page *child_page = buffer_pool_manager->FetchPage(child);
-    reinterpret_cast<BPlusTreePage *>(child_page)->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(child, /*is_dirty=*/true);
+    PageGuard child_guard = buffer_pool_manager->FetchPageBasic(child);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(recipient->GetPageId());
 }
 
 /* Append an entry at the end.
@@ -303,9 +300,8 @@ void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPo
     IncreaseSize(1);
 
     // 3) 更新 child 页的 parent_page_id
-    Page *child_page = buffer_pool_manager->FetchPage(value);
-    reinterpret_cast<BPlusTreePage *>(child_page)->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(value, /*is_dirty=*/true);
+    PageGuard child_guard = buffer_pool_manager->FetchPageBasic(value);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 }
 
 /*
@@ -347,15 +343,13 @@ void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle
     Remove(last_idx);
 
     // 8) 更新 recipient 中新添加的 pair 的 child 的 parent_page_id
-    Page *child_page_pair = buffer_pool_manager->FetchPage(last_value);
-    reinterpret_cast<BPlusTreePage *>(child_page_pair)->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(last_value, /*is_dirty=*/true);
+    PageGuard child_guard_pair = buffer_pool_manager->FetchPageBasic(last_value);
+    child_guard_pair.AsMut<BPlusTreePage>()->SetParentPageId(recipient->GetPageId());
 
     // 9) 更新 recipient 中 middle key child 的 parent_page_id
     page_id_t child = recipient->ValueAt(recipient->GetSize() - 1);
-    Page *child_page_middle = buffer_pool_manager->FetchPage(child);
-    reinterpret_cast<BPlusTreePage *>(child_page_middle)->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(child, /*is_dirty=*/true);
+    PageGuard child_guard_middle = buffer_pool_manager->FetchPageBasic(child);
+    child_guard_middle.AsMut<BPlusTreePage>()->SetParentPageId(recipient->GetPageId());
 }
 
 /* Append an entry at the beginning.
@@ -376,7 +370,6 @@ void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffe
     IncreaseSize(1);
 
     // 4) Update parent page id for the child
-    Page *child_page = buffer_pool_manager->FetchPage(value);
-    reinterpret_cast<BPlusTreePage *>(child_page)->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(value, /*is_dirty=*/true);
+    PageGuard child_guard = buffer_pool_manager->FetchPageBasic(value);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "page/bitmap_page.h"
 
+#include <cstring>
+
 #include "glog/logging.h"
 
 /**
@@ -14,6 +16,14 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
         return false;
     }
 
+    // next_free_page_ is only a hint, fall back to a search from the start
+    if (next_free_page_ >= max_size || !IsPageFreeLow(next_free_page_ / 8, next_free_page_ % 8)) {
+        next_free_page_ = FindPage(0, true);
+        if (next_free_page_ >= max_size) {
+            return false;
+        }
+    }
+
     page_allocated_++;
     page_offset = next_free_page_;
 
@@ -22,17 +32,38 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
 
     bytes[byte_idx] |= (1 << bit_idx);
 
-    for (uint32_t i = page_offset; i < max_size; i++) {
-        if (IsPageFree(i)){
-            next_free_page_ = i;
-            break;
-        }
-    }
+    next_free_page_ = FindPage(page_offset + 1, true);
 
     return true;
 
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePages(uint32_t count, uint32_t &page_offset) {
+    uint32_t max_size = GetMaxSupportedSize();
+    if (count == 0 || count > max_size - page_allocated_) {
+        return false;
+    }
+    // every free run ends at the next allocated page
+    uint32_t start = FindPage(0, true);
+    while (start + count <= max_size) {
+        uint32_t end = FindPage(start, false);
+        if (end - start >= count) {
+            for (uint32_t i = start; i < start + count; i++) {
+                bytes[i / 8] |= (1 << (i % 8));
+            }
+            page_allocated_ += count;
+            page_offset = start;
+            if (next_free_page_ >= start && next_free_page_ < start + count) {
+                next_free_page_ = FindPage(start + count, true);
+            }
+            return true;
+        }
+        start = FindPage(end, true);
+    }
+    return false;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -78,6 +109,38 @@ bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const {
 
 }
 
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::CountAllocatedPages() const {
+    uint32_t count = 0;
+    for (size_t i = 0; i < MAX_WORDS; i++) {
+        count += __builtin_popcountll(LoadWord(i));
+    }
+    return count;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindPage(uint32_t start, bool free) const {
+    for (size_t i = start / 64; i < MAX_WORDS; i++) {
+        uint64_t bits = free ? ~LoadWord(i) : LoadWord(i);
+        // skip the pages before start in the first word
+        if (i == start / 64) {
+            bits &= ~0ULL << (start % 64);
+        }
+        if (bits != 0) {
+            return i * 64 + __builtin_ctzll(bits);
+        }
+    }
+    return GetMaxSupportedSize();
+}
+
+template <size_t PageSize>
+uint64_t BitmapPage<PageSize>::LoadWord(size_t word_index) const {
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "byte i of the bitmap must be byte i % 8 of a word");
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+    return word;
+}
+
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const {
     if (byte_index >= MAX_CHARS || bit_index >= 8){
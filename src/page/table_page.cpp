@@ -1,5 +1,10 @@
 #include "page/table_page.h"
 
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
 // TODO: Update interface implementation if apply recovery
 
 //void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn) {
@@ -23,9 +28,8 @@ void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr,
     SetPrevPageId(prev_id);
     SetNextPageId(INVALID_PAGE_ID);
 
-    // 4. 初始化 FreeSpacePointer 到页头之后
-    //    PAGE_SIZE - SIZE_TABLE_PAGE_HEADER = 可用写入区域起点
-    SetFreeSpacePointer(PAGE_SIZE - SIZE_TABLE_PAGE_HEADER);
+    // 4. 初始化 FreeSpacePointer 到页尾, tuples grow down from the end of the page towards the slot array
+    SetFreeSpacePointer(PAGE_SIZE);
 
     // 5. 初始化 TupleCount
     SetTupleCount(0);
@@ -37,8 +41,11 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn,
     // 1. 序列化前先算大小
     uint32_t serialized_size = row.GetSerializedSize(schema);
     ASSERT(serialized_size > 0, "Can not have empty row.");
-    if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
-        return false;
+    if (GetContiguousFreeSpace() < serialized_size + SIZE_TUPLE) {
+        if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+            return false;
+        }
+        Compact();
     }
 
     // 2. 找到一个空 slot 或准备新空间
@@ -100,28 +107,38 @@ bool TablePage::UpdateTuple(Row &new_row, Row *old_row, Schema *schema, Txn *txn
     return false;
   }
   // If there is not enough space to update, we need to update via delete followed by an insert (not enough space).
-  if (GetFreeSpaceRemaining() + tuple_size < serialized_size) {
+  if (serialized_size > tuple_size && GetFreeSpaceRemaining() + tuple_size < serialized_size) {
     return false;
   }
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t __attribute__((unused)) read_bytes = old_row->DeserializeFrom(GetData() + tuple_offset, schema);
   ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
-  memmove(GetData() + free_space_pointer + tuple_size - serialized_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size - serialized_size);
-  new_row.SerializeTo(GetData() + tuple_offset + tuple_size - serialized_size, schema);
-  SetTupleSize(slot_num, serialized_size);
-
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_row.GetSerializedSize(schema));
+  ASSERT(tuple_offset >= GetFreeSpacePointer(), "Offset should appear after current free space position.");
+  // A tuple that does not grow is rewritten in place, the bytes it gave up are a hole before it unless it is the
+  // first tuple.
+  if (serialized_size <= tuple_size) {
+    uint32_t new_offset = tuple_offset + tuple_size - serialized_size;
+    new_row.SerializeTo(GetData() + new_offset, schema);
+    if (tuple_offset == GetFreeSpacePointer()) {
+      SetFreeSpacePointer(new_offset);
     }
+    SetTupleOffsetAtSlot(slot_num, new_offset);
+    SetTupleSize(slot_num, serialized_size);
+    return true;
+  }
+  // A tuple that grows moves in front of the first tuple, its old bytes become a hole. If the free space is too
+  // small, the old bytes are given up first so that the compaction reclaims them too.
+  if (GetContiguousFreeSpace() < serialized_size) {
+    SetTupleSize(slot_num, 0);
+    SetTupleOffsetAtSlot(slot_num, 0);
+    Compact();
   }
+  uint32_t new_offset = GetFreeSpacePointer() - serialized_size;
+  new_row.SerializeTo(GetData() + new_offset, schema);
+  SetFreeSpacePointer(new_offset);
+  SetTupleOffsetAtSlot(slot_num, new_offset);
+  SetTupleSize(slot_num, serialized_size);
   return true;
 }
 
@@ -136,22 +153,79 @@ void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager)
     tuple_size = UnsetDeletedFlag(tuple_size);
   }
 
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
+  ASSERT(tuple_offset >= GetFreeSpacePointer(), "Free space appears before tuples.");
 
-  memmove(GetData() + free_space_pointer + tuple_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size);
+  // The tuple's bytes become a hole, reclaimed by the next compaction, unless it is the first tuple.
+  if (tuple_offset == GetFreeSpacePointer()) {
+    SetFreeSpacePointer(tuple_offset + tuple_size);
+  }
   SetTupleSize(slot_num, 0);
   SetTupleOffsetAtSlot(slot_num, 0);
 
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) != 0 && tuple_offset_i < tuple_offset) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
+  // Drop the empty slots at the end.
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  SetTupleCount(tuple_count);
+}
+
+uint32_t TablePage::GetFreeSpaceRemaining() {
+  uint32_t tuple_bytes = 0;
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    tuple_bytes += UnsetDeletedFlag(GetTupleSize(i));
+  }
+  return PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount() - tuple_bytes;
+}
+
+void TablePage::Compact() {
+  // Move the tuples from the last one in the page to the first, each one is moved towards the end of the page and
+  // never overwrites a tuple not moved yet.
+  std::vector<std::pair<uint32_t, uint32_t>> tuples;  // offset and slot of every tuple, deleted ones included
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    if (GetTupleSize(i) != 0) {
+      tuples.emplace_back(GetTupleOffsetAtSlot(i), i);
+    }
+  }
+  std::sort(tuples.begin(), tuples.end(), std::greater<>());
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (auto &[tuple_offset, slot_num] : tuples) {
+    uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot_num));
+    free_space_pointer -= tuple_size;
+    if (free_space_pointer != tuple_offset) {
+      memmove(GetData() + free_space_pointer, GetData() + tuple_offset, tuple_size);
+      SetTupleOffsetAtSlot(slot_num, free_space_pointer);
+    }
+  }
+  SetFreeSpacePointer(free_space_pointer);
+}
+
+uint32_t TablePage::Vacuum(const std::function<bool(const RowId &)> &can_apply, uint32_t *live_tuples,
+                           uint32_t *dead_tuples) {
+  uint32_t free_space = GetFreeSpaceRemaining();
+  *live_tuples = 0;
+  *dead_tuples = 0;
+  // from the last slot to the first, ApplyDelete only drops empty slots after the current one
+  for (uint32_t i = GetTupleCount(); i-- > 0;) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (tuple_size == 0) {
+      continue;
+    }
+    if (!IsDeleted(tuple_size)) {
+      (*live_tuples)++;
+      continue;
+    }
+    RowId rid(GetTablePageId(), i);
+    if (can_apply(rid)) {
+      ApplyDelete(rid, nullptr, nullptr);
+    } else {
+      (*dead_tuples)++;
     }
   }
+  if (GetContiguousFreeSpace() < GetFreeSpaceRemaining()) {
+    Compact();
+  }
+  return GetFreeSpaceRemaining() - free_space;
 }
 
 void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
@@ -188,6 +262,36 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   return true;
 }
 
+bool TablePage::GetTupleOptimistic(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager) {
+  ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
+  uint32_t slot_num = row->GetRowId().GetSlotNum();
+  // Copy the tuple out first, a writer may be changing the page, so check every offset before following it.
+  char tuple[PAGE_SIZE];
+  uint32_t tuple_size = 0;
+  bool copied = ReadOptimistic([&]() {
+    if (slot_num >= (PAGE_SIZE - SIZE_TABLE_PAGE_HEADER) / SIZE_TUPLE || slot_num >= GetTupleCount()) {
+      return false;
+    }
+    tuple_size = GetTupleSize(slot_num);
+    if (IsDeleted(tuple_size) || tuple_size > PAGE_SIZE) {
+      return false;
+    }
+    uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+    if (tuple_offset > PAGE_SIZE - tuple_size) {
+      return false;
+    }
+    memcpy(tuple, GetData() + tuple_offset, tuple_size);
+    return true;
+  });
+  if (!copied) {
+    return false;
+  }
+  // The copy is consistent now.
+  uint32_t __attribute__((unused)) read_bytes = row->DeserializeFrom(tuple, schema);
+  ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+  return true;
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -171,6 +171,12 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowStatus:
+      return "kNodeShowStatus";
+    case kNodeSetVariable:
+      return "kNodeSetVariable";
+    case kNodeVacuum:
+      return "kNodeVacuum";
     default:
       return "error type";
   }
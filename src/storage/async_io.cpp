@@ -0,0 +1,362 @@
+#include "storage/async_io.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+
+bool IoHandle::IsDone() const {
+  if (request_ == nullptr) {
+    return true;
+  }
+  std::scoped_lock<std::mutex> lock(request_->latch_);
+  return request_->done_;
+}
+
+bool IoHandle::Wait() {
+  if (request_ == nullptr) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(request_->latch_);
+  request_->cv_.wait(lock, [this]() { return request_->done_; });
+  return request_->result_ >= 0;
+}
+
+void AsyncIo::Complete(IoRequest *request, ssize_t result) {
+  if (request->on_complete_) {
+    request->on_complete_(result);
+  }
+  std::scoped_lock<std::mutex> lock(request->latch_);
+  request->result_ = result;
+  request->done_ = true;
+  request->cv_.notify_all();
+}
+
+ssize_t AsyncIo::TransferRest(IoRequest *request, size_t done) {
+  if (!request->iovs_.empty()) {
+    return TransferRestVectored(request, done);
+  }
+  while (done < request->len_) {
+    ssize_t n = request->op_ == IoRequest::Op::kRead
+                    ? pread(request->fd_, request->buf_ + done, request->len_ - done, request->offset_ + done)
+                    : pwrite(request->fd_, request->buf_ + done, request->len_ - done, request->offset_ + done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) return -errno;
+    // end of file
+    if (n == 0) break;
+    done += n;
+  }
+  return static_cast<ssize_t>(done);
+}
+
+ssize_t AsyncIo::TransferRestVectored(IoRequest *request, size_t done) {
+  std::vector<struct iovec> iovs = request->iovs_;
+  size_t first = 0;
+  size_t skip = done;
+  while (done < request->len_) {
+    // drop the bytes already moved from the front of the list
+    while (skip >= iovs[first].iov_len) {
+      skip -= iovs[first].iov_len;
+      first++;
+    }
+    iovs[first].iov_base = static_cast<char *>(iovs[first].iov_base) + skip;
+    iovs[first].iov_len -= skip;
+    int count = static_cast<int>(std::min<size_t>(iovs.size() - first, IOV_MAX));
+    ssize_t n = request->op_ == IoRequest::Op::kRead
+                    ? preadv(request->fd_, iovs.data() + first, count, request->offset_ + done)
+                    : pwritev(request->fd_, iovs.data() + first, count, request->offset_ + done);
+    if (n < 0 && errno == EINTR) {
+      skip = 0;
+      continue;
+    }
+    if (n < 0) return -errno;
+    // end of file
+    if (n == 0) break;
+    done += n;
+    skip = n;
+  }
+  return static_cast<ssize_t>(done);
+}
+
+namespace {
+
+/**
+ * Worker threads doing blocking pread and pwrite. The threads are started with the first request.
+ */
+class ThreadPoolIo : public AsyncIo {
+ public:
+  explicit ThreadPoolIo(size_t num_threads) : num_threads_(std::max<size_t>(num_threads, 1)) {}
+
+  ~ThreadPoolIo() override {
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  IoHandle Submit(std::shared_ptr<IoRequest> request) override {
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      if (workers_.empty()) {
+        for (size_t i = 0; i < num_threads_; i++) {
+          workers_.emplace_back([this]() { Work(); });
+        }
+      }
+      queue_.push_back(request);
+    }
+    cv_.notify_one();
+    return IoHandle(std::move(request));
+  }
+
+  const char *Name() const override { return "threads"; }
+
+ private:
+  // the queue is drained before the workers stop
+  void Work() {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+      cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) break;
+      auto request = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      Complete(request.get(), TransferRest(request.get(), 0));
+      lock.lock();
+    }
+  }
+
+  size_t num_threads_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<IoRequest>> queue_;
+  std::vector<std::thread> workers_;
+  bool stop_{false};
+};
+
+int UringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int UringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+/**
+ * io_uring driven through raw syscalls. Submitters fill the submission queue under a latch, one reaper thread
+ * consumes the completion queue. Short transfers are finished synchronously by the reaper.
+ */
+class UringIo : public AsyncIo {
+ public:
+  static std::unique_ptr<UringIo> Create(size_t queue_depth) {
+    auto uring = std::unique_ptr<UringIo>(new UringIo());
+    return uring->Init(static_cast<unsigned>(std::max<size_t>(queue_depth, 2))) ? std::move(uring) : nullptr;
+  }
+
+  ~UringIo() override {
+    if (reaper_.joinable()) {
+      {
+        std::unique_lock<std::mutex> lock(latch_);
+        stop_ = true;
+        // wake the reaper, the reserved slot is always free for this
+        PushSqe(IORING_OP_NOP, nullptr);
+      }
+      reaper_.join();
+    }
+    if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+  }
+
+  IoHandle Submit(std::shared_ptr<IoRequest> request) override {
+    std::unique_lock<std::mutex> lock(latch_);
+    slot_cv_.wait(lock, [this]() { return in_flight_.size() < capacity_; });
+    IoRequest *raw = request.get();
+    if (raw->iovs_.empty()) {
+      raw->iov_.iov_base = raw->buf_;
+      raw->iov_.iov_len = raw->len_;
+    }
+    in_flight_.emplace(raw, request);
+    if (!PushSqe(raw->op_ == IoRequest::Op::kRead ? IORING_OP_READV : IORING_OP_WRITEV, raw)) {
+      // the reaper will never see the request, it is done synchronously instead
+      in_flight_.erase(raw);
+      lock.unlock();
+      slot_cv_.notify_one();
+      Complete(raw, TransferRest(raw, 0));
+    }
+    return IoHandle(std::move(request));
+  }
+
+  const char *Name() const override { return "io_uring"; }
+
+ private:
+  UringIo() = default;
+
+  bool Init(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = UringSetup(entries, &params);
+    if (ring_fd_ < 0) {
+      return false;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                  ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+    auto *sq = static_cast<char *>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    // one slot stays free for the wake-up on shutdown
+    capacity_ = params.sq_entries - 1;
+    reaper_ = std::thread([this]() { Reap(); });
+    return true;
+  }
+
+  // The caller holds latch_ and made sure a slot is free. The kernel consumes the entry before UringEnter returns.
+  // @return false if the kernel refused the entry, it is taken back out of the submission queue then
+  bool PushSqe(uint8_t opcode, IoRequest *request) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    if (request != nullptr) {
+      sqe->fd = request->fd_;
+      if (request->iovs_.empty()) {
+        sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+        sqe->len = 1;
+      } else {
+        sqe->addr = reinterpret_cast<uint64_t>(request->iovs_.data());
+        sqe->len = request->iovs_.size();
+      }
+      sqe->off = request->offset_;
+    }
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    int rc;
+    do {
+      rc = UringEnter(ring_fd_, 1, 0, 0);
+    } while (rc < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+    if (rc < 0) {
+      LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+      // nothing was consumed, a later submission must not pass the entry on to the kernel
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      return false;
+    }
+    return true;
+  }
+
+  void Reap() {
+    while (true) {
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        {
+          std::scoped_lock<std::mutex> lock(latch_);
+          if (stop_ && in_flight_.empty()) break;
+        }
+        int rc = UringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+          LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+        }
+        continue;
+      }
+      io_uring_cqe cqe = cqes_[head & cq_mask_];
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      auto *raw = reinterpret_cast<IoRequest *>(cqe.user_data);
+      if (raw == nullptr) continue;
+
+      std::shared_ptr<IoRequest> request;
+      {
+        std::scoped_lock<std::mutex> lock(latch_);
+        auto it = in_flight_.find(raw);
+        request = std::move(it->second);
+        in_flight_.erase(it);
+      }
+      slot_cv_.notify_one();
+      ssize_t result = cqe.res;
+      if (result > 0 && static_cast<size_t>(result) < raw->len_) {
+        result = TransferRest(raw, result);
+      }
+      Complete(raw, result);
+    }
+  }
+
+  int ring_fd_{-1};
+  void *sq_ring_{MAP_FAILED};
+  void *cq_ring_{MAP_FAILED};
+  void *sqes_{MAP_FAILED};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+
+  std::mutex latch_;
+  std::condition_variable slot_cv_;
+  size_t capacity_{0};
+  // keeps submitted requests alive until the reaper completes them
+  std::unordered_map<IoRequest *, std::shared_ptr<IoRequest>> in_flight_;
+  bool stop_{false};
+  std::thread reaper_;
+};
+
+}  // namespace
+
+std::unique_ptr<AsyncIo> AsyncIo::Create(Backend backend, size_t queue_depth) {
+  if (backend != Backend::kThreadPool) {
+    if (auto uring = UringIo::Create(queue_depth)) {
+      return uring;
+    }
+    if (backend == Backend::kUring) {
+      return nullptr;
+    }
+    LOG(WARNING) << "io_uring is not available, falling back to a thread pool";
+  }
+  return std::make_unique<ThreadPoolIo>(std::min<size_t>(queue_depth, ASYNC_IO_THREADS));
+}
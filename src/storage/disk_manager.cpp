@@ -1,115 +1,790 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
 #include <filesystem>
 #include <stdexcept>
 
+#include "common/lz_codec.h"
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, uint32_t flags, DiskManager *parent)
+    : file_name_(db_file), parent_(parent) {
     std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    // directory or file does not exist
-    if (!db_io_.is_open()) {
-        db_io_.clear();
-        // create a new file
-        std::filesystem::path p = db_file;
-        if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-        db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-        db_io_.close();
-        // reopen with original mode
-        db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-        if (!db_io_.is_open()) {
-            throw std::exception();
-        }
+    // directory does not exist
+    std::filesystem::path p = db_file;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+    fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::exception();
     }
+    file_size_ = GetFileSize(fd_);
+    bool created = file_size_ == 0;
     ReadPhysicalPage(META_PAGE_ID, meta_data_);
+    // the mode is chosen once, when the database is created
+    auto *disk_meta = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    // the used page counts of the extents beyond MAX_EXTENTS would be read as the flags, and their page ids as ids of
+    // segment files
+    if (disk_meta->num_extents_ > MAX_EXTENTS) {
+        LOG(ERROR) << db_file << " has " << disk_meta->num_extents_ << " extents, more than the " << MAX_EXTENTS
+                   << " supported";
+        close(fd_);
+        throw std::exception();
+    }
+    if (created && flags != 0) {
+        disk_meta->SetFlags(disk_meta->GetFlags() | flags);
+        WritePhysicalPage(META_PAGE_ID, meta_data_);
+    }
+    if ((disk_meta->GetFlags() & DiskFileMetaPage::FLAG_DIRECT_IO) != 0) {
+        EnableDirectIo();
+    }
+    if ((disk_meta->GetFlags() & DiskFileMetaPage::FLAG_COMPRESSED) != 0) {
+        OpenDataFile();
+    }
+    LoadBitmaps();
+}
+
+void DiskManager::OpenDataFile() {
+    data_fd_ = open((file_name_ + ".z").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (data_fd_ < 0) {
+        throw std::exception();
+    }
+    compressed_ = true;
+}
+
+void DiskManager::LoadBitmaps() {
+    DiskFileMetaPage *disk_meta = GetMeta();
+    uint32_t allocated_pages = 0;
+    for (uint32_t i = 0; i < disk_meta->num_extents_; i++) {
+        bitmaps_.emplace_back();
+        bitmap_dirty_.push_back(false);
+        ReadPhysicalPage(BitmapPhysicalId(i), bitmaps_[i].Data());
+        // the bitmaps are the truth, the counts may be stale after a crash between two writes
+        uint32_t used = GetBitmap(i)->CountAllocatedPages();
+        if (used != disk_meta->extent_used_page_[i]) {
+            LOG(WARNING) << "Extent " << i << " of " << file_name_ << " has " << used << " pages in use, not "
+                         << disk_meta->extent_used_page_[i];
+            disk_meta->extent_used_page_[i] = used;
+            meta_dirty_ = true;
+        }
+        allocated_pages += used;
+        UpdateExtentSpace(i);
+    }
+    if (allocated_pages != disk_meta->num_allocated_pages_) {
+        disk_meta->num_allocated_pages_ = allocated_pages;
+        meta_dirty_ = true;
+    }
+    if (compressed_) {
+        LoadSlotMap();
+    }
+}
+
+void DiskManager::LoadSlotMap() {
+    uint32_t map_pages = bitmaps_.size() * SLOT_MAP_PAGES;
+    slots_.resize(bitmaps_.size() * BITMAP_SIZE);
+    slot_map_dirty_.assign(map_pages, false);
+    for (uint32_t i = 0; i < map_pages; i++) {
+        ReadPhysicalPage(SlotMapPhysicalId(i), reinterpret_cast<char *>(&slots_[i * SLOT_MAP_ENTRIES]));
+    }
+    // the sectors not covered by a slot are free
+    std::vector<std::pair<uint32_t, uint32_t>> used;
+    for (auto &slot : slots_) {
+        if (slot.length_ == 0) {
+            continue;
+        }
+        if (slot.sectors_ == 0 || slot.sectors_ > MAX_SLOT_SECTORS ||
+            slot.length_ > slot.sectors_ * COMPRESSED_SECTOR_SIZE) {
+            LOG(WARNING) << "Invalid page slot in " << file_name_ << ", the page reads as zeros";
+            slot = {};
+            continue;
+        }
+        used.emplace_back(slot.sector_, slot.sectors_);
+    }
+    std::sort(used.begin(), used.end());
+    data_end_ = 0;
+    for (auto &[sector, count] : used) {
+        if (sector > data_end_) {
+            FreeSectors(data_end_, sector - data_end_);
+        }
+        data_end_ = std::max(data_end_, sector + count);
+    }
+}
+
+void DiskManager::FlushSlotMap() {
+    for (uint32_t i = 0; i < slot_map_dirty_.size(); i++) {
+        if (slot_map_dirty_[i]) {
+            WritePhysicalPage(SlotMapPhysicalId(i), reinterpret_cast<const char *>(&slots_[i * SLOT_MAP_ENTRIES]));
+            slot_map_dirty_[i] = false;
+        }
+    }
+}
+
+void DiskManager::FlushBitmaps() {
+    for (uint32_t i = 0; i < bitmaps_.size(); i++) {
+        if (bitmap_dirty_[i]) {
+            WritePhysicalPage(BitmapPhysicalId(i), bitmaps_[i].Data());
+            bitmap_dirty_[i] = false;
+        }
+    }
+    if (meta_dirty_) {
+        WritePhysicalPage(META_PAGE_ID, meta_data_);
+        meta_dirty_ = false;
+    }
+    if (compressed_) {
+        FlushSlotMap();
+    }
+}
+
+uint32_t DiskManager::FindExtentWithSpace() const {
+    for (size_t i = 0; i < extents_with_space_.size(); i++) {
+        if (extents_with_space_[i] != 0) {
+            return i * 64 + __builtin_ctzll(extents_with_space_[i]);
+        }
+    }
+    return bitmaps_.size();
+}
+
+void DiskManager::UpdateExtentSpace(uint32_t extent_id) {
+    if (extent_id / 64 >= extents_with_space_.size()) {
+        extents_with_space_.resize(extent_id / 64 + 1, 0);
+    }
+    uint64_t bit = 1ULL << (extent_id % 64);
+    if (GetMeta()->extent_used_page_[extent_id] < BITMAP_SIZE) {
+        extents_with_space_[extent_id / 64] |= bit;
+    } else {
+        extents_with_space_[extent_id / 64] &= ~bit;
+    }
+}
+
+void DiskManager::EnableDirectIo() {
+    int flags = fcntl(fd_, F_GETFL);
+    if (flags < 0 || fcntl(fd_, F_SETFL, flags | O_DIRECT) != 0) {
+        LOG(WARNING) << "O_DIRECT is not supported for " << file_name_ << ", using buffered I/O: " << strerror(errno);
+        return;
+    }
+    direct_io_ = true;
+}
+
+void DiskManager::Sync() {
+    SyncFile();
+    for (auto &slot : segments_) {
+        DiskManager *segment = slot.load(std::memory_order_acquire);
+        if (segment != nullptr) {
+            segment->SyncFile();
+        }
+    }
+}
+
+void DiskManager::SyncFile() {
+    std::vector<std::pair<uint32_t, uint32_t>> retired;
+    {
+        std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+        if (dropped_) {
+            return;
+        }
+        FlushBitmaps();
+        // the slot map just written no longer refers to these
+        retired.swap(retired_sectors_);
+    }
+    if (fsync(fd_) != 0 || (compressed_ && fsync(data_fd_) != 0)) {
+        LOG(ERROR) << "I/O error while syncing " << file_name_ << ": " << strerror(errno);
+        std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+        retired_sectors_.insert(retired_sectors_.end(), retired.begin(), retired.end());
+        return;
+    }
+    if (!retired.empty()) {
+        std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+        for (auto &[sector, count] : retired) {
+            FreeSectors(sector, count);
+        }
+    }
 }
 
 void DiskManager::Close() {
     std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-    WritePhysicalPage(META_PAGE_ID, meta_data_);
     if (!closed) {
-        db_io_.close();
+        // completes the I/O still in flight, also that of the segment files
+        async_io_.reset();
+        {
+            std::scoped_lock<std::mutex> segment_lock(segment_latch_);
+            for (auto &segment : segment_files_) {
+                segment->Close();
+            }
+        }
+        meta_dirty_ = true;
+        SyncFile();
+        close(fd_);
+        if (compressed_) {
+            close(data_fd_);
+        }
         closed = true;
     }
 }
 
+size_t DiskManager::Shrink() {
+    size_t released = ShrinkFile();
+    std::scoped_lock<std::mutex> lock(segment_latch_);
+    for (segment_id_t segment_id = 1; segment_id < MAX_SEGMENTS; segment_id++) {
+        DiskManager *segment = OpenSegment(segment_id, false);
+        if (segment != nullptr) {
+            released += segment->ShrinkFile();
+        }
+    }
+    return released;
+}
+
+size_t DiskManager::ShrinkFile() {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    if (dropped_) {
+        return 0;
+    }
+    size_t before = GetAllocatedBytes();
+    DiskFileMetaPage *disk_meta = GetMeta();
+    while (disk_meta->num_extents_ > 0 && disk_meta->extent_used_page_[disk_meta->num_extents_ - 1] == 0) {
+        uint32_t extent_id = --disk_meta->num_extents_;
+        bitmaps_.pop_back();
+        bitmap_dirty_.pop_back();
+        extents_with_space_[extent_id / 64] &= ~(1ULL << (extent_id % 64));
+        if (compressed_) {
+            slots_.resize(extent_id * BITMAP_SIZE);
+            slot_map_dirty_.resize(extent_id * SLOT_MAP_PAGES);
+        }
+        meta_dirty_ = true;
+    }
+    // the pages and sectors are only released once no durable map refers to them any more
+    FlushBitmaps();
+    if (fsync(fd_) != 0 || (compressed_ && fsync(data_fd_) != 0)) {
+        LOG(ERROR) << "I/O error while syncing " << file_name_ << ": " << strerror(errno);
+        return 0;
+    }
+
+    uint32_t end = 1;
+    if (compressed_) {
+        for (auto &[sector, count] : retired_sectors_) {
+            FreeSectors(sector, count);
+        }
+        retired_sectors_.clear();
+        // free sectors in the middle of the data file are punched out, the ones at its end cut off
+        uint32_t used_end = 0;
+        for (auto &slot : slots_) {
+            if (slot.length_ != 0) {
+                used_end = std::max(used_end, slot.sector_ + slot.sectors_);
+            }
+        }
+        for (uint16_t count = 1; count <= MAX_SLOT_SECTORS; count++) {
+            auto &sectors = free_sectors_[count];
+            for (uint32_t sector : sectors) {
+                if (sector < used_end) {
+                    PunchHole(data_fd_, static_cast<size_t>(sector) * COMPRESSED_SECTOR_SIZE,
+                              static_cast<size_t>(count) * COMPRESSED_SECTOR_SIZE);
+                }
+            }
+            sectors.erase(std::remove_if(sectors.begin(), sectors.end(),
+                                         [used_end](uint32_t sector) { return sector >= used_end; }),
+                          sectors.end());
+        }
+        data_end_ = used_end;
+        if (ftruncate(data_fd_, static_cast<off_t>(used_end) * COMPRESSED_SECTOR_SIZE) != 0) {
+            LOG(WARNING) << "Failed to truncate " << file_name_ << ".z: " << strerror(errno);
+        }
+        if (disk_meta->num_extents_ > 0) {
+            end = SlotMapPhysicalId((disk_meta->num_extents_ - 1) * SLOT_MAP_PAGES + SLOT_MAP_PAGES - 1) + 1;
+        }
+    } else {
+        // runs of free pages inside the file are punched out, the file ends with its last page in use
+        for (uint32_t extent_id = 0; extent_id < disk_meta->num_extents_; extent_id++) {
+            BitmapPage<PAGE_SIZE> *bitmap = GetBitmap(extent_id);
+            uint32_t run_start = 0;
+            for (uint32_t offset = 0; offset <= BITMAP_SIZE; offset++) {
+                if (offset < BITMAP_SIZE && bitmap->IsPageFree(offset)) {
+                    continue;
+                }
+                if (offset > run_start) {
+                    PunchHole(fd_, static_cast<size_t>(MapPageId(extent_id * BITMAP_SIZE + run_start)) * PAGE_SIZE,
+                              static_cast<size_t>(offset - run_start) * PAGE_SIZE);
+                }
+                if (offset < BITMAP_SIZE) {
+                    end = MapPageId(extent_id * BITMAP_SIZE + offset) + 1;
+                }
+                run_start = offset + 1;
+            }
+        }
+    }
+    if (ftruncate(fd_, static_cast<off_t>(end) * PAGE_SIZE) != 0) {
+        LOG(WARNING) << "Failed to truncate " << file_name_ << ": " << strerror(errno);
+    }
+    file_size_ = std::min<size_t>(file_size_, static_cast<size_t>(end) * PAGE_SIZE);
+    // pages allocated again grow the file in chunks from its new end
+    disk_meta->SetPreallocatedPages(compressed_ ? 0 : end);
+    meta_dirty_ = true;
+    FlushBitmaps();
+    if (fsync(fd_) != 0) {
+        LOG(ERROR) << "I/O error while syncing " << file_name_ << ": " << strerror(errno);
+    }
+    size_t after = GetAllocatedBytes();
+    return before > after ? before - after : 0;
+}
+
+void DiskManager::PunchHole(int fd, size_t offset, size_t len) {
+    int mode = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+    if (fallocate(fd, mode, static_cast<off_t>(offset), static_cast<off_t>(len)) != 0) {
+        LOG(WARNING) << "Failed to release free space of " << file_name_ << ": " << strerror(errno);
+    }
+}
+
+size_t DiskManager::GetAllocatedBytes() const {
+    struct stat stat_buf;
+    size_t bytes = fstat(fd_, &stat_buf) == 0 ? stat_buf.st_blocks * 512 : 0;
+    if (compressed_ && fstat(data_fd_, &stat_buf) == 0) {
+        bytes += stat_buf.st_blocks * 512;
+    }
+    return bytes;
+}
+
+void DiskManager::RemoveFiles(const std::string &db_file) {
+    remove(db_file.c_str());
+    remove(WorkingSetFileName(db_file).c_str());
+    for (segment_id_t segment_id = 1; segment_id < MAX_SEGMENTS; segment_id++) {
+        remove(SegmentFileName(db_file, segment_id).c_str());
+        remove((SegmentFileName(db_file, segment_id) + ".z").c_str());
+    }
+}
+
+DiskManager *DiskManager::GetSegment(segment_id_t segment_id) {
+    DiskManager *segment = segments_[segment_id].load(std::memory_order_acquire);
+    if (segment != nullptr) {
+        return segment;
+    }
+    std::scoped_lock<std::mutex> lock(segment_latch_);
+    return OpenSegment(segment_id, false);
+}
+
+DiskManager *DiskManager::OpenSegment(segment_id_t segment_id, bool create, bool compressed) {
+    DiskManager *segment = segments_[segment_id].load(std::memory_order_relaxed);
+    if (segment != nullptr || segment_retired_[segment_id]) {
+        return segment;
+    }
+    std::string segment_file = SegmentFileName(file_name_, segment_id);
+    if (!create && !std::filesystem::exists(segment_file)) {
+        return nullptr;
+    }
+    // a new segment file is created in the mode of the database file, compressed ones use buffered I/O
+    uint32_t flags = compressed ? DiskFileMetaPage::FLAG_COMPRESSED : direct_io_ ? DiskFileMetaPage::FLAG_DIRECT_IO : 0;
+    segment_files_.emplace_back(new DiskManager(segment_file, flags, this));
+    segment = segment_files_.back().get();
+    segments_[segment_id].store(segment, std::memory_order_release);
+    return segment;
+}
+
+segment_id_t DiskManager::CreateSegment(bool compressed) {
+    std::scoped_lock<std::mutex> lock(segment_latch_);
+    for (segment_id_t segment_id = 1; segment_id < MAX_SEGMENTS; segment_id++) {
+        if (segments_[segment_id].load(std::memory_order_relaxed) == nullptr && !segment_retired_[segment_id] &&
+            !std::filesystem::exists(SegmentFileName(file_name_, segment_id))) {
+            OpenSegment(segment_id, true, compressed);
+            return segment_id;
+        }
+    }
+    LOG(WARNING) << "All " << MAX_SEGMENTS - 1 << " segments of " << file_name_
+                 << " are in use, the new object is stored in the database file";
+    return 0;
+}
+
+bool DiskManager::DropSegment(segment_id_t segment_id) {
+    if (segment_id == 0 || segment_id >= MAX_SEGMENTS) {
+        return false;
+    }
+    std::scoped_lock<std::mutex> lock(segment_latch_);
+    DiskManager *segment = OpenSegment(segment_id, false);
+    if (segment == nullptr) {
+        return false;
+    }
+    segments_[segment_id].store(nullptr, std::memory_order_release);
+    segment_retired_[segment_id] = true;
+    std::scoped_lock<std::recursive_mutex> segment_lock(segment->db_io_latch_);
+    segment->dropped_ = true;
+    if (unlink(segment->file_name_.c_str()) != 0) {
+        LOG(ERROR) << "Failed to remove " << segment->file_name_ << ": " << strerror(errno);
+    }
+    // the space of an unlinked file is only given back once it is closed, truncate it to free the space now
+    if (ftruncate(segment->fd_, 0) != 0) {
+        LOG(WARNING) << "Failed to truncate " << segment->file_name_ << ": " << strerror(errno);
+    }
+    if (segment->compressed_ &&
+        (unlink((segment->file_name_ + ".z").c_str()) != 0 || ftruncate(segment->data_fd_, 0) != 0)) {
+        LOG(WARNING) << "Failed to remove the data file of " << segment->file_name_ << ": " << strerror(errno);
+    }
+    return true;
+}
+
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
     ASSERT(logical_page_id >= 0, "Invalid page id.");
+    if (SegmentOf(logical_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(logical_page_id));
+        if (segment == nullptr) {
+            memset(page_data, 0, PAGE_SIZE);
+            return;
+        }
+        return segment->ReadPage(LocalPageId(logical_page_id), page_data);
+    }
+    if (compressed_) {
+        return ReadCompressedPage(logical_page_id, page_data);
+    }
     ReadPhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
     ASSERT(logical_page_id >= 0, "Invalid page id.");
+    if (SegmentOf(logical_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(logical_page_id));
+        if (segment != nullptr) {
+            segment->WritePage(LocalPageId(logical_page_id), page_data);
+        }
+        return;
+    }
+    if (compressed_) {
+        return WriteCompressedPage(logical_page_id, page_data);
+    }
     WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
+AsyncIo *DiskManager::GetAsyncIo() {
+    if (parent_ != nullptr) {
+        return parent_->GetAsyncIo();
+    }
+    std::call_once(async_io_once_, [this]() { async_io_ = AsyncIo::Create(); });
+    return async_io_.get();
+}
+
+const char *DiskManager::GetAsyncIoBackend() {
+    return GetAsyncIo()->Name();
+}
+
+IoHandle DiskManager::ReadPageAsync(page_id_t logical_page_id, char *page_data) {
+    ASSERT(logical_page_id >= 0, "Invalid page id.");
+    if (SegmentOf(logical_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(logical_page_id));
+        if (segment == nullptr) {
+            memset(page_data, 0, PAGE_SIZE);
+            return IoHandle();
+        }
+        return segment->ReadPageAsync(LocalPageId(logical_page_id), page_data);
+    }
+    if (compressed_) {
+        return ReadCompressedPagesAsync(logical_page_id, {page_data});
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+    IoOwner owner = IoOwnerScope::Current();
+    // nothing to wait for beyond the end of the file
+    if (offset >= file_size_.load(std::memory_order_acquire)) {
+        memset(page_data, 0, PAGE_SIZE);
+        RecordIo({1, 0, 0, 0, ElapsedNs(start)}, owner);
+        return IoHandle();
+    }
+    // direct I/O needs an aligned buffer, read into a copy otherwise
+    std::shared_ptr<AlignedBuffer> bounce;
+    if (direct_io_ && !AlignedBuffer::IsAligned(page_data)) {
+        bounce = std::make_shared<AlignedBuffer>();
+    }
+    auto request = std::make_shared<IoRequest>();
+    request->op_ = IoRequest::Op::kRead;
+    request->fd_ = fd_;
+    request->buf_ = bounce != nullptr ? bounce->Data() : page_data;
+    request->len_ = PAGE_SIZE;
+    request->offset_ = offset;
+    request->on_complete_ = [this, page_data, bounce, start, owner](ssize_t result) {
+        size_t read_count = result > 0 ? result : 0;
+        if (result < 0) {
+            LOG(ERROR) << "I/O error while reading " << file_name_ << ": " << strerror(-result);
+        }
+        if (bounce != nullptr) {
+            memcpy(page_data, bounce->Data(), read_count);
+        }
+        if (read_count < PAGE_SIZE) {
+            memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+        }
+        RecordIo({1, 0, read_count, 0, ElapsedNs(start)}, owner);
+    };
+    return GetAsyncIo()->Submit(std::move(request));
+}
+
+IoHandle DiskManager::ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) {
+    ASSERT(first_page_id >= 0 && !pages.empty(), "Invalid page run.");
+    ASSERT(first_page_id / BITMAP_SIZE == (first_page_id + pages.size() - 1) / BITMAP_SIZE,
+           "A page run must not cross extents.");
+    if (SegmentOf(first_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(first_page_id));
+        if (segment == nullptr) {
+            for (char *page_data : pages) {
+                memset(page_data, 0, PAGE_SIZE);
+            }
+            return IoHandle();
+        }
+        return segment->ReadPagesAsync(LocalPageId(first_page_id), pages);
+    }
+    if (compressed_) {
+        return ReadCompressedPagesAsync(first_page_id, pages);
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = static_cast<size_t>(MapPageId(first_page_id)) * PAGE_SIZE;
+    IoOwner owner = IoOwnerScope::Current();
+    auto request = std::make_shared<IoRequest>();
+    request->op_ = IoRequest::Op::kRead;
+    request->fd_ = fd_;
+    request->len_ = pages.size() * PAGE_SIZE;
+    request->offset_ = offset;
+    for (char *page_data : pages) {
+        ASSERT(!direct_io_ || AlignedBuffer::IsAligned(page_data), "Direct I/O needs aligned buffers.");
+        request->iovs_.push_back({page_data, PAGE_SIZE});
+    }
+    request->on_complete_ = [this, pages, start, owner](ssize_t result) {
+        size_t read_count = result > 0 ? result : 0;
+        if (result < 0) {
+            LOG(ERROR) << "I/O error while reading " << file_name_ << ": " << strerror(-result);
+        }
+        // pages beyond the end of the file read as zeros
+        for (size_t i = 0; i < pages.size(); i++) {
+            size_t page_read = std::min<size_t>(PAGE_SIZE, read_count - std::min(read_count, i * PAGE_SIZE));
+            memset(pages[i] + page_read, 0, PAGE_SIZE - page_read);
+        }
+        RecordIo({pages.size(), 0, read_count, 0, ElapsedNs(start)}, owner);
+    };
+    return GetAsyncIo()->Submit(std::move(request));
+}
+
+IoHandle DiskManager::WritePageAsync(page_id_t logical_page_id, const char *page_data) {
+    ASSERT(logical_page_id >= 0, "Invalid page id.");
+    if (SegmentOf(logical_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(logical_page_id));
+        if (segment == nullptr) {
+            return IoHandle();
+        }
+        return segment->WritePageAsync(LocalPageId(logical_page_id), page_data);
+    }
+    if (compressed_) {
+        return WriteCompressedPageAsync(logical_page_id, page_data);
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+    IoOwner owner = IoOwnerScope::Current();
+    std::shared_ptr<AlignedBuffer> bounce;
+    if (direct_io_ && !AlignedBuffer::IsAligned(page_data)) {
+        bounce = std::make_shared<AlignedBuffer>();
+        memcpy(bounce->Data(), page_data, PAGE_SIZE);
+    }
+    auto request = std::make_shared<IoRequest>();
+    request->op_ = IoRequest::Op::kWrite;
+    request->fd_ = fd_;
+    request->buf_ = bounce != nullptr ? bounce->Data() : const_cast<char *>(page_data);
+    request->len_ = PAGE_SIZE;
+    request->offset_ = offset;
+    request->on_complete_ = [this, offset, bounce, start, owner](ssize_t result) {
+        if (result < 0) {
+            LOG(ERROR) << "I/O error while writing " << file_name_ << ": " << strerror(-result);
+            return;
+        }
+        size_t end = offset + PAGE_SIZE;
+        size_t size = file_size_.load(std::memory_order_relaxed);
+        while (size < end && !file_size_.compare_exchange_weak(size, end, std::memory_order_release)) {
+        }
+        RecordIo({0, 1, 0, PAGE_SIZE, ElapsedNs(start)}, owner);
+    };
+    return GetAsyncIo()->Submit(std::move(request));
+}
+
+IoHandle DiskManager::WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) {
+    ASSERT(first_page_id >= 0 && !pages.empty(), "Invalid page run.");
+    ASSERT(first_page_id / BITMAP_SIZE == (first_page_id + pages.size() - 1) / BITMAP_SIZE,
+           "A page run must not cross extents.");
+    if (SegmentOf(first_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(first_page_id));
+        if (segment == nullptr) {
+            return IoHandle();
+        }
+        return segment->WritePagesAsync(LocalPageId(first_page_id), pages);
+    }
+    if (compressed_) {
+        // the slots of adjacent pages need not be adjacent, all but the last write are waited for here
+        std::vector<IoHandle> writes;
+        for (size_t i = 0; i < pages.size(); i++) {
+            writes.emplace_back(WriteCompressedPageAsync(first_page_id + i, pages[i]));
+        }
+        for (size_t i = 0; i + 1 < writes.size(); i++) {
+            writes[i].Wait();
+        }
+        return writes.back();
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = static_cast<size_t>(MapPageId(first_page_id)) * PAGE_SIZE;
+    size_t len = pages.size() * PAGE_SIZE;
+    IoOwner owner = IoOwnerScope::Current();
+    auto request = std::make_shared<IoRequest>();
+    request->op_ = IoRequest::Op::kWrite;
+    request->fd_ = fd_;
+    request->len_ = len;
+    request->offset_ = offset;
+    for (const char *page_data : pages) {
+        ASSERT(!direct_io_ || AlignedBuffer::IsAligned(page_data), "Direct I/O needs aligned buffers.");
+        request->iovs_.push_back({const_cast<char *>(page_data), PAGE_SIZE});
+    }
+    request->on_complete_ = [this, offset, len, start, owner](ssize_t result) {
+        if (result < 0) {
+            LOG(ERROR) << "I/O error while writing " << file_name_ << ": " << strerror(-result);
+            return;
+        }
+        size_t end = offset + len;
+        size_t size = file_size_.load(std::memory_order_relaxed);
+        while (size < end && !file_size_.compare_exchange_weak(size, end, std::memory_order_release)) {
+        }
+        RecordIo({0, len / PAGE_SIZE, 0, len, ElapsedNs(start)}, owner);
+    };
+    return GetAsyncIo()->Submit(std::move(request));
+}
+
 /**
  * TODO: Student Implement
  */
 page_id_t DiskManager::AllocatePage() {
-    ReadPhysicalPage(0, meta_data_);
-    DiskFileMetaPage * disk_meta = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    DiskFileMetaPage * disk_meta = GetMeta();
 
     ASSERT (disk_meta->num_allocated_pages_ < MAX_VALID_PAGE_ID, "Database Is Full!");
 
-    char * cur_bitmap_data = new char[PAGE_SIZE];
-    BitmapPage<PAGE_SIZE> * cur_bitmap_pointer = nullptr;
-    uint32_t avail_extent;
+    uint32_t avail_extent = FindExtentWithSpace();
+    if (avail_extent == disk_meta->num_extents_) {
+        AddExtent();
+    }
 
-    if (disk_meta->num_allocated_pages_ == disk_meta->num_extents_ * BITMAP_SIZE) {
-        avail_extent = disk_meta->num_extents_;
-        disk_meta->extent_used_page_[disk_meta->num_extents_]++;
-        disk_meta->num_extents_++;
+    uint32_t page_offset;
+    [[maybe_unused]] bool allocated = GetBitmap(avail_extent)->AllocatePage(page_offset);
+    ASSERT(allocated, "Page Allocating Failed in Bitmap!");
+    RecordAllocation(avail_extent, 1);
+    ReserveSpace(avail_extent * BITMAP_SIZE + page_offset);
+    return avail_extent * BITMAP_SIZE + page_offset;
+}
+
+page_id_t DiskManager::AllocatePages(uint32_t count, segment_id_t segment_id) {
+    if (segment_id != 0) {
+        DiskManager *segment = segment_id < MAX_SEGMENTS ? GetSegment(segment_id) : nullptr;
+        page_id_t local_page_id = segment != nullptr ? segment->AllocatePages(count) : INVALID_PAGE_ID;
+        return local_page_id == INVALID_PAGE_ID ? INVALID_PAGE_ID : MakePageId(segment_id, local_page_id);
     }
-    else {
-        avail_extent = [&]() -> uint32_t {
-            for (uint32_t i = 0; i < disk_meta->num_extents_; i++){
-                if (disk_meta->extent_used_page_[i] < BITMAP_SIZE)
-                    return i;
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    DiskFileMetaPage *disk_meta = GetMeta();
+    if (count == 0 || count > BITMAP_SIZE || disk_meta->num_allocated_pages_ + count > MAX_VALID_PAGE_ID) {
+        return INVALID_PAGE_ID;
+    }
+    uint32_t page_offset;
+    // the lowest extent with a long enough run, only extents with enough free pages are looked at
+    for (size_t i = 0; i < extents_with_space_.size(); i++) {
+        for (uint64_t bits = extents_with_space_[i]; bits != 0; bits &= bits - 1) {
+            uint32_t extent_id = i * 64 + __builtin_ctzll(bits);
+            if (BITMAP_SIZE - disk_meta->extent_used_page_[extent_id] >= count &&
+                GetBitmap(extent_id)->AllocatePages(count, page_offset)) {
+                RecordAllocation(extent_id, count);
+                ReserveSpace(extent_id * BITMAP_SIZE + page_offset + count - 1);
+                return extent_id * BITMAP_SIZE + page_offset;
             }
-            return disk_meta->num_extents_;
-        }();
-        disk_meta->extent_used_page_[avail_extent]++;
+        }
+    }
+    if (disk_meta->num_extents_ >= MAX_EXTENTS) {
+        return INVALID_PAGE_ID;
     }
+    uint32_t extent_id = AddExtent();
+    [[maybe_unused]] bool allocated = GetBitmap(extent_id)->AllocatePages(count, page_offset);
+    ASSERT(allocated, "Page Allocating Failed in Bitmap!");
+    RecordAllocation(extent_id, count);
+    ReserveSpace(extent_id * BITMAP_SIZE + page_offset + count - 1);
+    return extent_id * BITMAP_SIZE + page_offset;
+}
 
-    ReadPhysicalPage(avail_extent * (BITMAP_SIZE + 1) + 1, cur_bitmap_data);
-    disk_meta->num_allocated_pages_++;
-    cur_bitmap_pointer = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(cur_bitmap_data);
+uint32_t DiskManager::AddExtent() {
+    DiskFileMetaPage *disk_meta = GetMeta();
+    uint32_t extent_id = disk_meta->num_extents_;
+    bitmaps_.emplace_back();
+    memset(bitmaps_.back().Data(), 0, PAGE_SIZE);
+    bitmap_dirty_.push_back(true);
+    disk_meta->extent_used_page_[extent_id] = 0;
+    disk_meta->num_extents_++;
+    meta_dirty_ = true;
+    UpdateExtentSpace(extent_id);
+    if (compressed_) {
+        slots_.resize(slots_.size() + BITMAP_SIZE);
+        slot_map_dirty_.resize(slot_map_dirty_.size() + SLOT_MAP_PAGES, false);
+    }
+    return extent_id;
+}
 
-    uint32_t page_offset;
-    ASSERT(cur_bitmap_pointer->AllocatePage(page_offset), "Page Allocating Failed in Bitmap!");
-    WritePhysicalPage(0, meta_data_);
-    WritePhysicalPage(avail_extent * (BITMAP_SIZE + 1) + 1, cur_bitmap_data);
-    delete[] cur_bitmap_data;
-    return (disk_meta->num_extents_ - 1) * BITMAP_SIZE + page_offset;
+void DiskManager::RecordAllocation(uint32_t extent_id, int32_t count) {
+    DiskFileMetaPage *disk_meta = GetMeta();
+    disk_meta->extent_used_page_[extent_id] += count;
+    disk_meta->num_allocated_pages_ += count;
+    bitmap_dirty_[extent_id] = true;
+    meta_dirty_ = true;
+    UpdateExtentSpace(extent_id);
+}
+
+void DiskManager::ReserveSpace(page_id_t logical_page_id) {
+    // the segment file of a compressed segment only holds the bitmaps and the slot maps
+    if (!preallocate_ || compressed_) {
+        return;
+    }
+    DiskFileMetaPage *disk_meta = GetMeta();
+    uint32_t end = MapPageId(logical_page_id) + 1;
+    uint32_t reserved = disk_meta->GetPreallocatedPages();
+    if (end <= reserved) {
+        return;
+    }
+    // growing by the size of the file so far needs a number of calls logarithmic in the file size
+    uint32_t new_end = std::max(end, reserved + std::clamp(reserved, FILE_GROWTH_MIN_PAGES, FILE_GROWTH_MAX_PAGES));
+    off_t offset = static_cast<off_t>(reserved) * PAGE_SIZE;
+    if (fallocate(fd_, 0, offset, static_cast<off_t>(new_end) * PAGE_SIZE - offset) != 0) {
+        if (errno == EOPNOTSUPP || errno == ENOSYS) {
+            LOG(WARNING) << "fallocate is not supported for " << file_name_ << ", the file grows page by page";
+            preallocate_ = false;
+        } else {
+            LOG(WARNING) << "Failed to preallocate " << file_name_ << ": " << strerror(errno);
+        }
+        return;
+    }
+    disk_meta->SetPreallocatedPages(new_end);
+    meta_dirty_ = true;
 }
 
 /**
  * TODO: Student Implement
  */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
-    ReadPhysicalPage(0, meta_data_);
-    DiskFileMetaPage * disk_meta = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-
-    ASSERT(logical_page_id >=0 && logical_page_id < disk_meta->num_allocated_pages_, "No Such Page!");
+    if (logical_page_id >= 0 && SegmentOf(logical_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(logical_page_id));
+        if (segment != nullptr) {
+            segment->DeAllocatePage(LocalPageId(logical_page_id));
+        }
+        return;
+    }
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    DiskFileMetaPage * disk_meta = GetMeta();
 
-    char * cur_bitmap_data = new char[PAGE_SIZE];
-    BitmapPage<PAGE_SIZE> * cur_bitmap_pointer = nullptr;
+    // ids are not dense once pages have been freed, any id inside an allocated extent may be in use
+    ASSERT(logical_page_id >= 0 && static_cast<uint32_t>(logical_page_id) < disk_meta->num_extents_ * BITMAP_SIZE,
+           "No Such Page!");
 
     uint32_t page_offset = logical_page_id % BITMAP_SIZE;
-    uint32_t bitmap_physcial_id = logical_page_id / BITMAP_SIZE;
-    ReadPhysicalPage(MapPageId(logical_page_id) - page_offset - 1, cur_bitmap_data);
-    cur_bitmap_pointer = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(cur_bitmap_data);
-    ASSERT(cur_bitmap_pointer->DeAllocatePage(page_offset), "DeAllocate Failed!");
-    disk_meta->num_allocated_pages_--;
-    disk_meta->extent_used_page_[bitmap_physcial_id]--;
-    WritePhysicalPage(0, meta_data_);
-    WritePhysicalPage(MapPageId(logical_page_id) - page_offset - 1, cur_bitmap_data);
-    delete[] cur_bitmap_data;
+    uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+    [[maybe_unused]] bool freed = GetBitmap(extent_id)->DeAllocatePage(page_offset);
+    ASSERT(freed, "DeAllocate Failed!");
+    RecordAllocation(extent_id, -1);
+    if (compressed_) {
+        ReleaseSlot(logical_page_id);
+    }
 }
 
 /**
@@ -117,19 +792,18 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
     ASSERT(logical_page_id >= 0, "Invalid page id.");
+    if (SegmentOf(logical_page_id) != 0) {
+        DiskManager *segment = GetSegment(SegmentOf(logical_page_id));
+        return segment == nullptr || segment->IsPageFree(LocalPageId(logical_page_id));
+    }
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
 
-    page_id_t physcial_page_id = MapPageId(logical_page_id);
-    page_id_t bitmap_physcial_id = physcial_page_id - logical_page_id % BITMAP_SIZE - 1;
-    page_id_t page_offset = physcial_page_id - bitmap_physcial_id - 1;
-
-    //char * bitmap_data = nullptr;
-    // ← 在这里分配 PAGE_SIZE 大小的缓冲区
-    auto *bitmap_data = new char[PAGE_SIZE];
-
-    ReadPhysicalPage(bitmap_physcial_id, bitmap_data);
-    BitmapPage<PAGE_SIZE> * bitmap_pointer = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_data);
-
-    return bitmap_pointer->IsPageFree(page_offset);
+    uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+    // pages of extents not allocated yet
+    if (extent_id >= bitmaps_.size()) {
+        return true;
+    }
+    return GetBitmap(extent_id)->IsPageFree(logical_page_id % BITMAP_SIZE);
 }
 
 /**
@@ -139,45 +813,288 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
     return logical_page_id + logical_page_id / BITMAP_SIZE + 2;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+size_t DiskManager::GetFileSize(int fd) {
     struct stat stat_buf;
-    int rc = stat(file_name.c_str(), &stat_buf);
-    return rc == 0 ? stat_buf.st_size : -1;
+    int rc = fstat(fd, &stat_buf);
+    return rc == 0 ? stat_buf.st_size : 0;
+}
+
+IoStats DiskManager::GetIoStats() const {
+    return {pages_read_.load(), pages_written_.load(), bytes_read_.load(), bytes_written_.load(), io_time_ns_.load()};
+}
+
+std::unordered_map<uint64_t, IoStats> DiskManager::GetOwnerIoStats() {
+    std::scoped_lock<std::mutex> lock(stats_latch_);
+    return owner_stats_;
 }
 
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-    int offset = physical_page_id * PAGE_SIZE;
+    if (direct_io_ && !AlignedBuffer::IsAligned(page_data)) {
+        AlignedBuffer bounce;
+        ReadPhysicalPage(physical_page_id, bounce.Data());
+        memcpy(page_data, bounce.Data(), PAGE_SIZE);
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t read_count = 0;
+    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
     // check if read beyond file length
-    if (offset >= GetFileSize(file_name_)) {
+    if (offset < file_size_.load(std::memory_order_acquire)) {
+        read_count = ReadAt(fd_, page_data, PAGE_SIZE, offset);
+    }
+    // if file ends before reading PAGE_SIZE
+    if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
         LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-        memset(page_data, 0, PAGE_SIZE);
-    } else {
-        // set read cursor to offset
-        db_io_.seekp(offset);
-        db_io_.read(page_data, PAGE_SIZE);
-        // if file ends before reading PAGE_SIZE
-        int read_count = db_io_.gcount();
-        if (read_count < PAGE_SIZE) {
-#ifdef ENABLE_BPM_DEBUG
-            LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-            memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-        }
+        memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
+    // pages beyond the end of the file cost nothing but are still handed out
+    IoStats stats{1, 0, read_count, 0, ElapsedNs(start)};
+    RecordIo(stats);
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+    if (direct_io_ && !AlignedBuffer::IsAligned(page_data)) {
+        AlignedBuffer bounce;
+        memcpy(bounce.Data(), page_data, PAGE_SIZE);
+        WritePhysicalPage(physical_page_id, bounce.Data());
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
     size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-    // set write cursor to offset
-    db_io_.seekp(offset);
-    db_io_.write(page_data, PAGE_SIZE);
-    // check for I/O error
-    if (db_io_.bad()) {
-        LOG(ERROR) << "I/O error while writing";
+    if (!WriteAt(fd_, page_data, PAGE_SIZE, offset)) {
+        return;
+    }
+    // readers may only look at the page once it is complete
+    size_t end = offset + PAGE_SIZE;
+    size_t size = file_size_.load(std::memory_order_relaxed);
+    while (size < end && !file_size_.compare_exchange_weak(size, end, std::memory_order_release)) {
+    }
+    IoStats stats{0, 1, 0, PAGE_SIZE, ElapsedNs(start)};
+    RecordIo(stats);
+}
+
+size_t DiskManager::ReadAt(int fd, char *buf, size_t len, size_t offset) {
+    size_t read_count = 0;
+    while (read_count < len) {
+        ssize_t n = pread(fd, buf + read_count, len - read_count, offset + read_count);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            LOG(ERROR) << "I/O error while reading " << file_name_ << ": " << strerror(errno);
+        }
+        if (n <= 0) break;
+        read_count += n;
+    }
+    return read_count;
+}
+
+bool DiskManager::WriteAt(int fd, const char *buf, size_t len, size_t offset) {
+    size_t written = 0;
+    while (written < len) {
+        ssize_t n = pwrite(fd, buf + written, len - written, offset + written);
+        if (n < 0 && errno == EINTR) continue;
+        // check for I/O error
+        if (n < 0) {
+            LOG(ERROR) << "I/O error while writing " << file_name_ << ": " << strerror(errno);
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+DiskManager::PageSlot DiskManager::GetSlot(page_id_t logical_page_id) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    return static_cast<size_t>(logical_page_id) < slots_.size() ? slots_[logical_page_id] : PageSlot{};
+}
+
+DiskManager::PageSlot DiskManager::PlaceSlot(page_id_t logical_page_id, uint16_t length) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    ASSERT(static_cast<size_t>(logical_page_id) < slots_.size(), "Page of an extent not allocated.");
+    auto sectors = static_cast<uint16_t>((length + COMPRESSED_SECTOR_SIZE - 1) / COMPRESSED_SECTOR_SIZE);
+    PageSlot &slot = slots_[logical_page_id];
+    // the old sectors are only reused once the slot map on disk stops pointing at them, otherwise a crash before the
+    // next sync would leave this page's old slot holding another page's data
+    if (slot.length_ == 0 || slot.sectors_ < sectors) {
+        if (slot.length_ != 0) {
+            RetireSectors(slot.sector_, slot.sectors_);
+        }
+        slot.sector_ = AllocateSectors(sectors);
+    } else if (slot.sectors_ > sectors) {
+        RetireSectors(slot.sector_ + sectors, slot.sectors_ - sectors);
+    }
+    slot.sectors_ = sectors;
+    slot.length_ = length;
+    slot_map_dirty_[logical_page_id / SLOT_MAP_ENTRIES] = true;
+    return slot;
+}
+
+void DiskManager::ReleaseSlot(page_id_t logical_page_id) {
+    PageSlot &slot = slots_[logical_page_id];
+    if (slot.length_ != 0) {
+        RetireSectors(slot.sector_, slot.sectors_);
+        slot = {};
+        slot_map_dirty_[logical_page_id / SLOT_MAP_ENTRIES] = true;
+    }
+}
+
+uint32_t DiskManager::AllocateSectors(uint16_t count) {
+    // the smallest free slot that is large enough, its rest stays free
+    for (uint16_t size = count; size <= MAX_SLOT_SECTORS; size++) {
+        if (!free_sectors_[size].empty()) {
+            uint32_t sector = free_sectors_[size].back();
+            free_sectors_[size].pop_back();
+            if (size > count) {
+                FreeSectors(sector + count, size - count);
+            }
+            return sector;
+        }
+    }
+    uint32_t sector = data_end_;
+    data_end_ += count;
+    return sector;
+}
+
+void DiskManager::FreeSectors(uint32_t sector, uint32_t count) {
+    for (; count > MAX_SLOT_SECTORS; count -= MAX_SLOT_SECTORS, sector += MAX_SLOT_SECTORS) {
+        free_sectors_[MAX_SLOT_SECTORS].push_back(sector);
+    }
+    free_sectors_[count].push_back(sector);
+}
+
+uint16_t DiskManager::EncodePage(const char *page_data, char *out) {
+    // a page that does not save a sector is stored as it is
+    size_t length = LzCodec::Compress(page_data, PAGE_SIZE, out, PAGE_SIZE - COMPRESSED_SECTOR_SIZE);
+    if (length == 0) {
+        memcpy(out, page_data, PAGE_SIZE);
+        return PAGE_SIZE;
+    }
+    return length;
+}
+
+void DiskManager::DecodeSlot(const PageSlot &slot, const char *data, size_t available, char *page_data) {
+    bool decoded;
+    if (slot.length_ == PAGE_SIZE) {
+        decoded = available >= PAGE_SIZE;
+        if (decoded) {
+            memcpy(page_data, data, PAGE_SIZE);
+        }
+    } else {
+        decoded = available >= slot.length_ && LzCodec::Decompress(data, slot.length_, page_data, PAGE_SIZE);
+    }
+    if (!decoded) {
+        LOG(ERROR) << "Failed to decompress a page of " << file_name_ << " at sector " << slot.sector_;
+        memset(page_data, 0, PAGE_SIZE);
+    }
+}
+
+void DiskManager::ReadCompressedPage(page_id_t logical_page_id, char *page_data) {
+    auto start = std::chrono::steady_clock::now();
+    PageSlot slot = GetSlot(logical_page_id);
+    if (slot.length_ == 0) {
+        memset(page_data, 0, PAGE_SIZE);
+        RecordIo({1, 0, 0, 0, ElapsedNs(start)});
         return;
     }
-    // needs to flush to keep disk file in sync
-    db_io_.flush();
+    char data[PAGE_SIZE];
+    size_t read_count = ReadAt(data_fd_, data, slot.sectors_ * COMPRESSED_SECTOR_SIZE,
+                               static_cast<size_t>(slot.sector_) * COMPRESSED_SECTOR_SIZE);
+    DecodeSlot(slot, data, read_count, page_data);
+    RecordIo({1, 0, read_count, 0, ElapsedNs(start)});
+}
+
+void DiskManager::WriteCompressedPage(page_id_t logical_page_id, const char *page_data) {
+    auto start = std::chrono::steady_clock::now();
+    char data[PAGE_SIZE];
+    uint16_t length = EncodePage(page_data, data);
+    PageSlot slot = PlaceSlot(logical_page_id, length);
+    size_t size = slot.sectors_ * COMPRESSED_SECTOR_SIZE;
+    memset(data + length, 0, size - length);
+    if (WriteAt(data_fd_, data, size, static_cast<size_t>(slot.sector_) * COMPRESSED_SECTOR_SIZE)) {
+        RecordIo({0, 1, 0, size, ElapsedNs(start)});
+    }
+}
+
+IoHandle DiskManager::ReadCompressedPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) {
+    auto start = std::chrono::steady_clock::now();
+    IoOwner owner = IoOwnerScope::Current();
+    std::vector<PageSlot> slots;
+    size_t size = 0;
+    for (size_t i = 0; i < pages.size(); i++) {
+        slots.push_back(GetSlot(first_page_id + i));
+        // pages written in order usually sit next to each other in the data file
+        if (slots[i].length_ == 0 || (i > 0 && slots[i].sector_ != slots[i - 1].sector_ + slots[i - 1].sectors_)) {
+            for (size_t j = 0; j < pages.size(); j++) {
+                ReadCompressedPage(first_page_id + j, pages[j]);
+            }
+            return IoHandle();
+        }
+        size += slots[i].sectors_ * COMPRESSED_SECTOR_SIZE;
+    }
+    auto data = std::make_shared<std::vector<char>>(size);
+    auto request = std::make_shared<IoRequest>();
+    request->op_ = IoRequest::Op::kRead;
+    request->fd_ = data_fd_;
+    request->buf_ = data->data();
+    request->len_ = size;
+    request->offset_ = static_cast<size_t>(slots[0].sector_) * COMPRESSED_SECTOR_SIZE;
+    request->on_complete_ = [this, pages, slots, data, start, owner](ssize_t result) {
+        size_t read_count = result > 0 ? result : 0;
+        if (result < 0) {
+            LOG(ERROR) << "I/O error while reading " << file_name_ << ".z: " << strerror(-result);
+        }
+        size_t offset = 0;
+        for (size_t i = 0; i < pages.size(); i++) {
+            DecodeSlot(slots[i], data->data() + offset, read_count - std::min(read_count, offset), pages[i]);
+            offset += slots[i].sectors_ * COMPRESSED_SECTOR_SIZE;
+        }
+        RecordIo({pages.size(), 0, read_count, 0, ElapsedNs(start)}, owner);
+    };
+    return GetAsyncIo()->Submit(std::move(request));
+}
+
+IoHandle DiskManager::WriteCompressedPageAsync(page_id_t logical_page_id, const char *page_data) {
+    auto start = std::chrono::steady_clock::now();
+    IoOwner owner = IoOwnerScope::Current();
+    // compressed right away, so page_data is free again when this returns
+    auto data = std::make_shared<AlignedBuffer>();
+    uint16_t length = EncodePage(page_data, data->Data());
+    PageSlot slot = PlaceSlot(logical_page_id, length);
+    size_t size = slot.sectors_ * COMPRESSED_SECTOR_SIZE;
+    memset(data->Data() + length, 0, size - length);
+    auto request = std::make_shared<IoRequest>();
+    request->op_ = IoRequest::Op::kWrite;
+    request->fd_ = data_fd_;
+    request->buf_ = data->Data();
+    request->len_ = size;
+    request->offset_ = static_cast<size_t>(slot.sector_) * COMPRESSED_SECTOR_SIZE;
+    request->on_complete_ = [this, data, size, start, owner](ssize_t result) {
+        if (result < 0) {
+            LOG(ERROR) << "I/O error while writing " << file_name_ << ".z: " << strerror(-result);
+            return;
+        }
+        RecordIo({0, 1, 0, size, ElapsedNs(start)}, owner);
+    };
+    return GetAsyncIo()->Submit(std::move(request));
+}
+
+uint64_t DiskManager::ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void DiskManager::RecordIo(const IoStats &stats, IoOwner owner) {
+    if (parent_ != nullptr) {
+        parent_->RecordIo(stats, owner);
+        return;
+    }
+    pages_read_ += stats.pages_read_;
+    pages_written_ += stats.pages_written_;
+    bytes_read_ += stats.bytes_read_;
+    bytes_written_ += stats.bytes_written_;
+    io_time_ns_ += stats.io_time_ns_;
+    if (owner.kind_ != IoOwner::Kind::kNone) {
+        std::scoped_lock<std::mutex> lock(stats_latch_);
+        owner_stats_[owner.Key()] += stats;
+    }
 }
\ No newline at end of file
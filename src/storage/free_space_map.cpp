@@ -0,0 +1,169 @@
+#include "storage/free_space_map.h"
+
+bool FreeSpaceMap::Create() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  page_id_t page_id;
+  PageGuard guard = allocator_.NewPageGuarded(page_id);
+  if (!guard.IsValid()) {
+    return false;
+  }
+  guard.AsMut<FreeSpaceMapPage>()->Init();
+  root_page_id_ = page_id;
+  map_pages_.push_back(page_id);
+  max_categories_.push_back(0);
+  return true;
+}
+
+void FreeSpaceMap::Load(page_id_t root_page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  root_page_id_ = root_page_id;
+  for (page_id_t page_id = root_page_id; page_id != INVALID_PAGE_ID;) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    ASSERT(guard.IsValid(), "Free space map page not found.");
+    auto *map_page = guard.As<FreeSpaceMapPage>();
+    map_pages_.push_back(page_id);
+    max_categories_.push_back(0);
+    for (uint32_t i = 0; i < map_page->GetCount(); i++) {
+      Append(map_page->GetPageId(i), map_page->GetCategory(i));
+    }
+    page_id = map_page->GetNextPageId();
+  }
+}
+
+void FreeSpaceMap::Append(page_id_t page_id, uint8_t category) {
+  auto entry = static_cast<uint32_t>(page_ids_.size());
+  if (entry / FreeSpaceMapPage::CAPACITY == max_categories_.size()) {
+    max_categories_.push_back(0);
+  }
+  page_ids_.push_back(page_id);
+  categories_.push_back(category);
+  if (page_id != INVALID_PAGE_ID) {
+    entries_[page_id] = entry;
+  }
+  uint8_t &max_category = max_categories_[entry / FreeSpaceMapPage::CAPACITY];
+  max_category = std::max(max_category, category);
+}
+
+// 1.   Append the entry in memory.
+// 2.   For a map on disk, append it to the last map page, starting a new map page if that one is full.
+void FreeSpaceMap::AddPage(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  uint8_t category = ToCategory(free_space);
+  Append(page_id, category);
+  if (map_pages_.empty()) {
+    return;
+  }
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(map_pages_.back());
+  ASSERT(guard.IsValid(), "Free space map page not found.");
+  auto *map_page = guard.AsMut<FreeSpaceMapPage>();
+  if (map_page->Add(page_id, category)) {
+    return;
+  }
+  page_id_t next_page_id;
+  PageGuard next_guard = allocator_.NewPageGuarded(next_page_id);
+  ASSERT(next_guard.IsValid(), "No frame left for a free space map page.");
+  auto *next_page = next_guard.AsMut<FreeSpaceMapPage>();
+  next_page->Init();
+  next_page->Add(page_id, category);
+  map_page->SetNextPageId(next_page_id);
+  map_pages_.push_back(next_page_id);
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) {
+    return;
+  }
+  uint32_t entry = it->second;
+  uint8_t category = ToCategory(free_space);
+  uint8_t old_category = categories_[entry];
+  if (category == old_category) {
+    return;
+  }
+  categories_[entry] = category;
+  uint32_t map_index = entry / FreeSpaceMapPage::CAPACITY;
+  uint8_t &max_category = max_categories_[map_index];
+  if (category > max_category) {
+    max_category = category;
+  } else if (old_category == max_category) {
+    auto begin = categories_.begin() + map_index * FreeSpaceMapPage::CAPACITY;
+    auto end = categories_.begin() + std::min<size_t>(categories_.size(), (map_index + 1) * FreeSpaceMapPage::CAPACITY);
+    max_category = *std::max_element(begin, end);
+  }
+  if (map_pages_.empty()) {
+    return;
+  }
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(map_pages_[map_index]);
+  ASSERT(guard.IsValid(), "Free space map page not found.");
+  guard.AsMut<FreeSpaceMapPage>()->SetCategory(entry % FreeSpaceMapPage::CAPACITY, category);
+}
+
+void FreeSpaceMap::RemovePage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) {
+    return;
+  }
+  uint32_t entry = it->second;
+  ASSERT(entry + 1 != page_ids_.size(), "The last page of a heap can not be removed.");
+  entries_.erase(it);
+  page_ids_[entry] = INVALID_PAGE_ID;
+  categories_[entry] = 0;
+  uint32_t map_index = entry / FreeSpaceMapPage::CAPACITY;
+  auto begin = categories_.begin() + map_index * FreeSpaceMapPage::CAPACITY;
+  auto end = categories_.begin() + std::min<size_t>(categories_.size(), (map_index + 1) * FreeSpaceMapPage::CAPACITY);
+  max_categories_[map_index] = *std::max_element(begin, end);
+  if (map_pages_.empty()) {
+    return;
+  }
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(map_pages_[map_index]);
+  ASSERT(guard.IsValid(), "Free space map page not found.");
+  auto *map_page = guard.AsMut<FreeSpaceMapPage>();
+  map_page->SetPageId(entry % FreeSpaceMapPage::CAPACITY, INVALID_PAGE_ID);
+  map_page->SetCategory(entry % FreeSpaceMapPage::CAPACITY, 0);
+}
+
+// The largest category of each map page is kept, so only the entries of one map page are looked at.
+page_id_t FreeSpaceMap::FindPage(uint32_t size, const std::vector<page_id_t> &skip) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  uint32_t needed = (size + CATEGORY_BYTES - 1) / CATEGORY_BYTES;
+  if (needed > UINT8_MAX) {
+    return INVALID_PAGE_ID;
+  }
+  for (size_t map_index = 0; map_index < max_categories_.size(); map_index++) {
+    if (max_categories_[map_index] < needed) {
+      continue;
+    }
+    size_t end = std::min<size_t>(categories_.size(), (map_index + 1) * FreeSpaceMapPage::CAPACITY);
+    for (size_t entry = map_index * FreeSpaceMapPage::CAPACITY; entry < end; entry++) {
+      if (categories_[entry] >= needed && std::find(skip.begin(), skip.end(), page_ids_[entry]) == skip.end()) {
+        return page_ids_[entry];
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+page_id_t FreeSpaceMap::GetLastPageId() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return page_ids_.empty() ? INVALID_PAGE_ID : page_ids_.back();
+}
+
+size_t FreeSpaceMap::GetPageCount() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return entries_.size();
+}
+
+void FreeSpaceMap::Free() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto page_id : map_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  root_page_id_ = INVALID_PAGE_ID;
+  page_ids_.clear();
+  categories_.clear();
+  entries_.clear();
+  map_pages_.clear();
+  max_categories_.clear();
+}
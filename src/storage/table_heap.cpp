@@ -1,65 +1,395 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+std::atomic<uint32_t> next_thread_slot{0};
+// spreads the threads over the insert points of a heap, hashing thread ids would map many of them to one point
+thread_local const uint32_t thread_slot = next_thread_slot.fetch_add(1, std::memory_order_relaxed);
+
+}  // namespace
+
 /**
  * TODO: Student Implement
  */
-bool TableHeap::InsertTuple(Row &row, Txn *txn) {
-    // 1. 尝试在已有页面中插
-    page_id_t cur_pid = first_page_id_;
-    page_id_t prev_pid = INVALID_PAGE_ID;  // 记录上一次的非空页
-    while (cur_pid != INVALID_PAGE_ID) {
-        auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(cur_pid));
-        if (!page) return false;
-        page->WLatch();
-        bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-        page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_pid, inserted);
-        if (inserted) return true;
-
-        // 记录当前页号，然后跳到下一个
-        prev_pid = cur_pid;
-        cur_pid = page->GetNextPageId();
-    }
-
-    // 2. 所有旧页都满了，prev_pid 正好是最后一页的页号
+bool TableHeap::InsertTuple(Row &row, Txn *txn, BufferAccessStrategy *strategy) {
+    IoOwnerScope owner_scope(io_owner_);
+    PageChainUser chain_user(this);
+    // 1. 尝试在已有页面中插: on the page the thread's insert point is filling, then on the pages the free space map
+    //    finds room in, except the ones other insert points are filling. A page that turns out to be too full, e.g.
+    //    because another insert got there first, has its entry corrected and the map is asked again. Inserts that
+    //    succeed keep the map out of the way, the page stays with the insert point until it is full.
+    uint32_t size = row.GetSerializedSize(schema_) + TablePage::SIZE_TUPLE;
+    FreeSpaceMap &free_space_map = GetFreeSpaceMap();
+    std::atomic<page_id_t> &insert_page = insert_pages_[thread_slot % insert_pages_.size()];
+    page_id_t pid = insert_page.load(std::memory_order_relaxed);
+    if (pid == INVALID_PAGE_ID) {
+        pid = free_space_map.FindPage(size, GetOtherInsertPages(insert_page));
+    }
+    while (pid != INVALID_PAGE_ID) {
+        bool inserted;
+        uint32_t free_space = 0;
+        {
+            WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(pid, strategy);
+            if (!guard.IsValid()) return false;
+            auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+            inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+            // counting the free space walks every slot, it is only needed to correct the map
+            if (inserted) {
+                guard.SetDirty();
+            } else {
+                free_space = page->GetFreeSpaceRemaining();
+            }
+        }
+        if (inserted) {
+            insert_page.store(pid, std::memory_order_relaxed);
+            live_tuples_++;
+            return true;
+        }
+        free_space_map.Update(pid, free_space);
+        pid = free_space_map.FindPage(size, GetOtherInsertPages(insert_page));
+    }
+
+    // 2. 所有旧页都满了，prev_pid 正好是最后一页的页号: pages are only appended under append_latch_, so the last page
+    //    of the chain is the one added to the map last
+    std::scoped_lock<std::mutex> lock(append_latch_);
+    page_id_t prev_pid = free_space_map.GetLastPageId();
     page_id_t new_pid;
-    Page *raw = buffer_pool_manager_->NewPage(new_pid);
-    if (!raw) return false;
-    auto new_page = reinterpret_cast<TablePage *>(raw);
+    PageGuard new_guard = extent_allocator_.NewPageGuarded(new_pid, strategy);
+    if (!new_guard.IsValid()) return false;
+    auto new_page = reinterpret_cast<TablePage *>(new_guard.GetPage());
     // 用 prev_pid 初始化新页
     new_page->Init(new_pid, prev_pid, log_manager_, txn);
+    new_guard.SetDirty();
 
     // 3. 如果 prev_pid 有效，就把它的 next 指向 new_pid
     if (prev_pid != INVALID_PAGE_ID) {
-        auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_pid));
-        prev_page->WLatch();
-        prev_page->SetNextPageId(new_pid);
-        prev_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(prev_pid, /*is_dirty=*/true);
+        WritePageGuard prev_guard = buffer_pool_manager_->FetchPageWrite(prev_pid, strategy);
+        reinterpret_cast<TablePage *>(prev_guard.GetPage())->SetNextPageId(new_pid);
+        prev_guard.SetDirty();
     }
 
     // 4. 向新页插入
-    new_page->WLatch();
-    bool ok = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-    new_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(new_pid, ok);
-    return ok;
+    WritePageGuard write_guard = new_guard.UpgradeWrite();
+    bool inserted = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_space = new_page->GetFreeSpaceRemaining();
+    write_guard.Drop();
+    free_space_map.AddPage(new_pid, free_space);
+    insert_page.store(new_pid, std::memory_order_relaxed);
+    if (inserted) live_tuples_++;
+    return inserted;
+}
+
+std::vector<std::atomic<page_id_t>> TableHeap::MakeInsertPoints(uint32_t count) {
+    if (count == 0) {
+        count = std::clamp(std::thread::hardware_concurrency(), 1u, MAX_TABLE_INSERT_POINTS);
+    }
+    std::vector<std::atomic<page_id_t>> insert_pages(count);
+    for (auto &insert_page : insert_pages) {
+        insert_page.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    }
+    return insert_pages;
+}
+
+std::vector<page_id_t> TableHeap::GetOtherInsertPages(const std::atomic<page_id_t> &insert_page) const {
+    std::vector<page_id_t> pages;
+    for (auto &other : insert_pages_) {
+        page_id_t pid = other.load(std::memory_order_relaxed);
+        if (&other != &insert_page && pid != INVALID_PAGE_ID) {
+            pages.push_back(pid);
+        }
+    }
+    return pages;
+}
+
+void TableHeap::EnterPageChain() {
+    while (true) {
+        page_chain_users_.fetch_add(1);
+        if (!freeing_pages_.load()) {
+            return;
+        }
+        // a vacuum checks for users after it started freeing, back off until it is done
+        page_chain_users_.fetch_sub(1);
+        while (freeing_pages_.load()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// 1.   Walk the page chain. On each page apply the deletes no rollback needs anymore and compact the page, see
+//      TablePage::Vacuum, and count its live and dead tuples.
+// 2.   Unlink the pages left empty, except the first and the last one, if no insert or scan holds the page chain.
+//      Users that come while the pages are unlinked wait, so none of them can have the id of an unlinked page.
+// 3.   Give the unlinked pages back to the disk manager, including the ones an earlier vacuum could not free.
+size_t TableHeap::Vacuum() {
+    IoOwnerScope owner_scope(io_owner_);
+    std::scoped_lock<std::mutex> vacuum_lock(vacuum_latch_);
+    FreeSpaceMap &free_space_map = GetFreeSpaceMap();
+    BufferAccessStrategy strategy(AccessStrategyType::kBulkRead);
+    auto can_apply = [this](const RowId &rid) { return pending_deletes_.count(rid) == 0; };
+    int64_t live_tuples = 0;
+    int64_t dead_tuples = 0;
+    size_t reclaimed = 0;
+    std::vector<page_id_t> empty_pages;
+    for (page_id_t pid = first_page_id_; pid != INVALID_PAGE_ID;) {
+        uint32_t page_live;
+        uint32_t page_dead;
+        uint32_t page_reclaimed;
+        uint32_t free_space;
+        bool empty;
+        page_id_t next_pid;
+        {
+            WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(pid, &strategy);
+            if (!guard.IsValid()) break;
+            auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+            {
+                std::scoped_lock<std::mutex> lock(pending_deletes_latch_);
+                page_reclaimed = page->Vacuum(can_apply, &page_live, &page_dead);
+            }
+            if (page_reclaimed > 0) guard.SetDirty();
+            free_space = page->GetFreeSpaceRemaining();
+            empty = page->IsEmpty();
+            next_pid = page->GetNextPageId();
+        }
+        if (page_reclaimed > 0) {
+            free_space_map.Update(pid, free_space);
+        }
+        if (empty && pid != first_page_id_) {
+            empty_pages.push_back(pid);
+        }
+        live_tuples += page_live;
+        dead_tuples += page_dead;
+        reclaimed += page_reclaimed;
+        pid = next_pid;
+    }
+
+    if (!empty_pages.empty()) {
+        std::scoped_lock<std::mutex> lock(append_latch_);
+        freeing_pages_.store(true);
+        if (page_chain_users_.load() == 0) {
+            std::vector<page_id_t> unlinked = UnlinkEmptyPages(empty_pages);
+            unlinked_pages_.insert(unlinked_pages_.end(), unlinked.begin(), unlinked.end());
+        }
+        freeing_pages_.store(false);
+    }
+    // nobody can reach an unlinked page anymore, only a read ahead still in flight may hold it
+    auto freed = std::remove_if(unlinked_pages_.begin(), unlinked_pages_.end(),
+                                [this](page_id_t page_id) { return FreeUnlinkedPage(page_id); });
+    freed_pages_ += unlinked_pages_.end() - freed;
+    unlinked_pages_.erase(freed, unlinked_pages_.end());
+
+    live_tuples_ = live_tuples;
+    dead_tuples_ = dead_tuples;
+    tuple_counts_known_ = true;
+    reclaimed_bytes_ += reclaimed;
+    vacuums_++;
+    return reclaimed;
+}
+
+std::vector<page_id_t> TableHeap::UnlinkEmptyPages(const std::vector<page_id_t> &page_ids) {
+    FreeSpaceMap &free_space_map = GetFreeSpaceMap();
+    std::vector<page_id_t> unlinked;
+    for (page_id_t pid : page_ids) {
+        // the last page is where the next page is appended
+        if (pid == free_space_map.GetLastPageId()) continue;
+        page_id_t prev_pid;
+        page_id_t next_pid;
+        {
+            ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(pid);
+            if (!guard.IsValid()) continue;
+            auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+            // only an insert fills a page again, and there is none now
+            if (!page->IsEmpty()) continue;
+            prev_pid = page->GetPrevPageId();
+            next_pid = page->GetNextPageId();
+        }
+        {
+            WritePageGuard prev_guard = buffer_pool_manager_->FetchPageWrite(prev_pid);
+            reinterpret_cast<TablePage *>(prev_guard.GetPage())->SetNextPageId(next_pid);
+            prev_guard.SetDirty();
+        }
+        if (next_pid != INVALID_PAGE_ID) {
+            WritePageGuard next_guard = buffer_pool_manager_->FetchPageWrite(next_pid);
+            reinterpret_cast<TablePage *>(next_guard.GetPage())->SetPrevPageId(prev_pid);
+            next_guard.SetDirty();
+        }
+        free_space_map.RemovePage(pid);
+        for (auto &insert_page : insert_pages_) {
+            page_id_t expected = pid;
+            insert_page.compare_exchange_strong(expected, INVALID_PAGE_ID);
+        }
+        unlinked.push_back(pid);
+    }
+    return unlinked;
+}
+
+bool TableHeap::FreeUnlinkedPage(page_id_t page_id) {
+    // DeletePage only frees a page that is resident
+    PageGuard guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    if (!guard.IsValid()) {
+        return false;
+    }
+    guard.Drop();
+    buffer_pool_manager_->DeletePage(page_id);
+    return buffer_pool_manager_->IsPageFree(page_id);
+}
+
+bool TableHeap::NeedsVacuum() const {
+    if (!tuple_counts_known_) {
+        return true;
+    }
+    int64_t dead_tuples = dead_tuples_;
+    int64_t tuples = live_tuples_ + dead_tuples;
+    return dead_tuples >= VACUUM_MIN_DEAD_TUPLES && dead_tuples >= VACUUM_DEAD_TUPLE_RATIO * tuples;
+}
+
+VacuumStats TableHeap::GetVacuumStats() const {
+    VacuumStats stats;
+    stats.live_tuples_ = std::max<int64_t>(live_tuples_, 0);
+    stats.dead_tuples_ = std::max<int64_t>(dead_tuples_, 0);
+    stats.reclaimed_bytes_ = reclaimed_bytes_;
+    stats.freed_pages_ = freed_pages_;
+    stats.vacuums_ = vacuums_;
+    return stats;
+}
+
+// 1.   Fill the page of the thread's insert point, then the pages the free space map finds room in. Each page is
+//      latched once for as many tuples as fit into it.
+// 2.   Append new pages for the rest, filling each one before the next is allocated. A page is linked to its
+//      successor while it is still latched, so the page chain is written in one pass.
+// 3.   Tell the free space map about the new pages, the last one is left to the insert point.
+bool TableHeap::InsertTuples(std::vector<Row> &rows, Txn *txn, std::vector<RowId> *rids,
+                             BufferAccessStrategy *strategy) {
+    IoOwnerScope owner_scope(io_owner_);
+    PageChainUser chain_user(this);
+    for (auto &row : rows) {
+        if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) return false;
+    }
+    size_t next = 0;
+    auto fill = [&](TablePage *page) {
+        size_t first = next;
+        while (next < rows.size() && page->InsertTuple(rows[next], schema_, txn, lock_manager_, log_manager_)) {
+            next++;
+        }
+        return next > first;
+    };
+    auto size_of_next = [&]() { return rows[next].GetSerializedSize(schema_) + TablePage::SIZE_TUPLE; };
+
+    FreeSpaceMap &free_space_map = GetFreeSpaceMap();
+    std::atomic<page_id_t> &insert_page = insert_pages_[thread_slot % insert_pages_.size()];
+    page_id_t pid = insert_page.load(std::memory_order_relaxed);
+    if (pid == INVALID_PAGE_ID && !rows.empty()) {
+        pid = free_space_map.FindPage(size_of_next(), GetOtherInsertPages(insert_page));
+    }
+    while (next < rows.size() && pid != INVALID_PAGE_ID) {
+        uint32_t free_space;
+        {
+            WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(pid, strategy);
+            if (!guard.IsValid()) return false;
+            auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+            if (fill(page)) guard.SetDirty();
+            free_space = page->GetFreeSpaceRemaining();
+        }
+        if (next == rows.size()) {
+            insert_page.store(pid, std::memory_order_relaxed);
+            break;
+        }
+        free_space_map.Update(pid, free_space);
+        pid = free_space_map.FindPage(size_of_next(), GetOtherInsertPages(insert_page));
+    }
+
+    if (next < rows.size()) {
+        std::scoped_lock<std::mutex> lock(append_latch_);
+        std::vector<std::pair<page_id_t, uint32_t>> new_pages;
+        page_id_t prev_pid = free_space_map.GetLastPageId();
+        WritePageGuard prev_guard;
+        if (prev_pid != INVALID_PAGE_ID) {
+            prev_guard = buffer_pool_manager_->FetchPageWrite(prev_pid, strategy);
+        }
+        while (next < rows.size()) {
+            page_id_t new_pid;
+            PageGuard new_guard = extent_allocator_.NewPageGuarded(new_pid, strategy);
+            if (!new_guard.IsValid()) break;
+            auto new_page = reinterpret_cast<TablePage *>(new_guard.GetPage());
+            new_page->Init(new_pid, prev_pid, log_manager_, txn);
+            new_guard.SetDirty();
+            WritePageGuard write_guard = new_guard.UpgradeWrite();
+            fill(new_page);
+            new_pages.emplace_back(new_pid, new_page->GetFreeSpaceRemaining());
+            if (prev_guard.IsValid()) {
+                reinterpret_cast<TablePage *>(prev_guard.GetPage())->SetNextPageId(new_pid);
+                prev_guard.SetDirty();
+            }
+            prev_guard = std::move(write_guard);
+            prev_pid = new_pid;
+        }
+        prev_guard.Drop();
+        for (auto &[page_id, free_space] : new_pages) {
+            free_space_map.AddPage(page_id, free_space);
+        }
+        if (!new_pages.empty()) {
+            insert_page.store(new_pages.back().first, std::memory_order_relaxed);
+        }
+    }
+
+    if (rids != nullptr) {
+        for (size_t i = 0; i < next; i++) {
+            rids->push_back(rows[i].GetRowId());
+        }
+    }
+    live_tuples_ += next;
+    return next == rows.size();
+}
+
+FreeSpaceMap &TableHeap::GetFreeSpaceMap() {
+    if (free_space_map_ready_.load(std::memory_order_acquire)) {
+        return free_space_map_;
+    }
+    std::scoped_lock<std::mutex> lock(append_latch_);
+    if (!free_space_map_ready_.load(std::memory_order_relaxed)) {
+        // the map never holds a page latch of the heap, so each page is released before it is added
+        for (page_id_t pid = first_page_id_; pid != INVALID_PAGE_ID;) {
+            ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(pid);
+            if (!guard.IsValid()) break;
+            auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+            page_id_t next_pid = page->GetNextPageId();
+            uint32_t free_space = page->GetFreeSpaceRemaining();
+            guard.Drop();
+            free_space_map_.AddPage(pid, free_space);
+            pid = next_pid;
+        }
+        free_space_map_ready_.store(true, std::memory_order_release);
+    }
+    return free_space_map_;
 }
 
 
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
+  IoOwnerScope owner_scope(io_owner_);
+  // A transaction may still roll the delete back, vacuums leave the tuple alone.
+  if (txn != nullptr) {
+    std::scoped_lock<std::mutex> lock(pending_deletes_latch_);
+    pending_deletes_.insert(rid);
+  }
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the recovery.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     return false;
   }
   // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  if (reinterpret_cast<TablePage *>(guard.GetPage())->MarkDelete(rid, txn, lock_manager_, log_manager_)) {
+    live_tuples_--;
+    dead_tuples_++;
+    // The commit applies the delete, an abort rolls it back.
+    if (txn != nullptr) {
+      txn->GetDeleteSet().push_back({rid, this});
+    }
+  }
+  guard.SetDirty();
   return true;
 }
 
@@ -67,22 +397,19 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
  * TODO: Student Implement
  */
 bool TableHeap::UpdateTuple(Row &new_row, const RowId &rid, Txn *txn) {
-    page_id_t pid = rid.GetPageId();
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(pid));
-    if (page == nullptr) {
+    IoOwnerScope owner_scope(io_owner_);
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+    if (!guard.IsValid()) {
         return false;
-
     }
+    auto page = reinterpret_cast<TablePage *>(guard.GetPage());
 
     // —— 第一步，用 old_row 读取旧值，确保这个行存在 ——
     Row old_row;
     old_row.SetRowId(rid);
-    page->WLatch();
     bool ok = page->GetTuple(&old_row, schema_, txn, lock_manager_);
-    page->WUnlatch();
-    // 如果读失败，unpin 并返回
+    // 如果读失败，直接返回，guard 负责 unpin
     if (!ok) {
-        buffer_pool_manager_->UnpinPage(pid, false);
         return false;
     }
 
@@ -90,18 +417,28 @@ bool TableHeap::UpdateTuple(Row &new_row, const RowId &rid, Txn *txn) {
     // —— 关键：要给 page->UpdateTuple 一个空 fields_ 的 Row ——
     Row fresh_row_for_update;
     fresh_row_for_update.SetRowId(rid);
-    page->WLatch();
     ok = page->UpdateTuple(new_row, &fresh_row_for_update, schema_, txn, lock_manager_, log_manager_);
-    page->WUnlatch();
-    // 完成这次访问后 unpin
-    buffer_pool_manager_->UnpinPage(pid, ok);
+    if (ok) {
+        guard.SetDirty();
+    }
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    // MarkDelete and InsertTuple below latch the page again
+    guard.Drop();
+    GetFreeSpaceMap().Update(rid.GetPageId(), free_space);
 
     if (!ok) {
-        // 空间不足时：逻辑删除 + 插入
+        // 空间不足时：逻辑删除 + 插入, a vacuum must not take the old tuple before the insert succeeded
+        {
+            std::scoped_lock<std::mutex> lock(pending_deletes_latch_);
+            pending_deletes_.insert(rid);
+        }
         MarkDelete(rid, txn);
         bool inserted = InsertTuple(new_row, txn);
         if (!inserted) {
             RollbackDelete(rid, txn);
+        } else if (txn == nullptr) {
+            std::scoped_lock<std::mutex> lock(pending_deletes_latch_);
+            pending_deletes_.erase(rid);
         }
         return inserted;
     }
@@ -117,86 +454,131 @@ bool TableHeap::UpdateTuple(Row &new_row, const RowId &rid, Txn *txn) {
  * TODO: Student Implement
  */
 void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
+  IoOwnerScope owner_scope(io_owner_);
   // Step1: Find the page which contains the tuple.
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-    if (page == nullptr) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+    if (!guard.IsValid()) {
         return;
     }
     // Step2: Delete the tuple from the page.
-    page->WLatch();
+    auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+    bool marked = page->IsMarkedDeleted(rid.GetSlotNum());
     page->ApplyDelete(rid, txn, log_manager_);
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+    guard.SetDirty();
+    ForgetDelete(rid, txn);
+    // a tuple that was not marked deleted is an insert rolled back
+    if (marked) {
+        dead_tuples_--;
+    } else {
+        live_tuples_--;
+    }
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    guard.Drop();
+    GetFreeSpaceMap().Update(rid.GetPageId(), free_space);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
+  IoOwnerScope owner_scope(io_owner_);
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
+  auto page = reinterpret_cast<TablePage *>(guard.GetPage());
+  bool marked = page->IsMarkedDeleted(rid.GetSlotNum());
   // Rollback to delete.
-  page->WLatch();
   page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.SetDirty();
+  guard.Drop();
+  ForgetDelete(rid, txn);
+  if (marked) {
+    dead_tuples_--;
+    live_tuples_++;
+  }
+}
+
+void TableHeap::ForgetDelete(const RowId &rid, Txn *txn) {
+  {
+    std::scoped_lock<std::mutex> lock(pending_deletes_latch_);
+    pending_deletes_.erase(rid);
+  }
+  // The transaction ended the delete itself, its commit or abort must not repeat it.
+  if (txn != nullptr) {
+    auto &delete_set = txn->GetDeleteSet();
+    delete_set.erase(std::remove_if(delete_set.begin(), delete_set.end(),
+                                    [&](const Txn::DeleteRecord &record) {
+                                      return record.table_heap_ == this && record.rid_ == rid;
+                                    }),
+                     delete_set.end());
+  }
 }
 
 /**
  * TODO: Student Implement
  */
 bool TableHeap::GetTuple(Row *row, Txn *txn) {
+    IoOwnerScope owner_scope(io_owner_);
     // 先找到row对应的页
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(row->GetRowId().GetPageId()));
-    if (page == nullptr) {
+    PageGuard guard = buffer_pool_manager_->FetchPageBasic(row->GetRowId().GetPageId());
+    if (!guard.IsValid()) {
         return false;
     }
-    // 然后从页中获取行
-    page->RLatch();
-    bool ok = page->GetTuple(row, schema_, txn, lock_manager_);
-    page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-    return ok;
+    // 然后从页中获取行, point reads do not take the page latch
+    return reinterpret_cast<TablePage *>(guard.GetPage())->GetTupleOptimistic(row, schema_, txn, lock_manager_);
 }
 
 void TableHeap::DeleteTable(page_id_t page_id) {
-    if (page_id != INVALID_PAGE_ID) {
-        auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
-        if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID)
-            DeleteTable(temp_table_page->GetNextPageId());
-        buffer_pool_manager_->UnpinPage(page_id, false);
+    IoOwnerScope owner_scope(io_owner_);
+    if (page_id == INVALID_PAGE_ID) {
+        page_id = first_page_id_;
+    }
+    // a heap with a file of its own is dropped without reading its pages
+    if (page_id == first_page_id_ && DropSegment()) {
+        return;
+    }
+    // 删除table_heap, a page can only be deleted once its guard has given back the pin
+    while (page_id != INVALID_PAGE_ID) {
+        PageGuard guard = buffer_pool_manager_->FetchPageBasic(page_id);
+        if (!guard.IsValid()) {
+            return;
+        }
+        page_id_t next_page_id = reinterpret_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+        guard.Drop();
         buffer_pool_manager_->DeletePage(page_id);
-    } else {
-        DeleteTable(first_page_id_);
+        page_id = next_page_id;
     }
+    free_space_map_.Free();
+    extent_allocator_.Release();
 }
 
 /**
  * TODO: Student Implement
  */
-TableIterator TableHeap::Begin(Txn *txn) {
+TableIterator TableHeap::Begin(Txn *txn, std::shared_ptr<BufferAccessStrategy> strategy) {
+    IoOwnerScope owner_scope(io_owner_);
+    PageChainUser chain_user(this);
     page_id_t pid = first_page_id_;
     // cout << "TableHeap::Begin: first_page_id_ = " << first_page_id_ << endl;
     // 遍历链表中所有页面，找到第一个有 tuple 的位置
     while (pid != INVALID_PAGE_ID) {
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(pid));
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(pid, strategy.get());
     // cout << "TableHeap::Begin: Fetching page with id = " << pid << endl;
-    if (page == nullptr) {
+    if (!guard.IsValid()) {
         break;  // 无法取到页，直接退出
     }
     // 锁住页面，找第一个 tuple
-    page->RLatch();
+    auto page = reinterpret_cast<TablePage *>(guard.GetPage());
     RowId first_rid;
     bool ok = page->GetFirstTupleRid(&first_rid);
     // cout << "TableHeap::Begin: GetFirstTupleRid returned " << ok  << endl;
-    page->RUnlatch();
-    // 释放页面引用，不标记脏
-    buffer_pool_manager_->UnpinPage(pid, /*is_dirty=*/false);
+    page_id_t next_pid = page->GetNextPageId();
+    // 释放页面引用，不标记脏; the iterator fetches the page again
+    guard.Drop();
 
     if (ok) {
         // 找到合法的 tuple，返回指向它的迭代器
-        return TableIterator(this, first_rid, txn);
+        return TableIterator(this, first_rid, txn, strategy);
     }
     // 否则跳到下一页继续
-    pid = page->GetNextPageId();
+    pid = next_pid;
     }
     // 整个表都没有 tuple，返回 end()
     return End();
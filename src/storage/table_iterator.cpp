@@ -1,32 +1,41 @@
 #include "storage/table_iterator.h"
 
+#include <algorithm>
+
 #include "common/macros.h"
 #include "storage/table_heap.h"
 
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn)
-        : table_heap_(table_heap), rid_(rid), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+        : table_heap_(table_heap), rid_(rid), txn_(txn), strategy_(std::move(strategy)) {
+    // an iterator keeps the id of its page between steps, see TableHeap::EnterPageChain
+    if (table_heap_ != nullptr) {
+        table_heap_->EnterPageChain();
+    }
     // 如果是合法的开始迭代位置，就把这一行 load 进 cur_row_
     if (table_heap_ != nullptr && rid_.GetPageId() != INVALID_PAGE_ID) {
+        IoOwnerScope owner_scope(table_heap_->io_owner_);
         cur_row_ = Row();
         // —— 先给 cur_row_ 设上正确的 RowId ——
         cur_row_.SetRowId(rid_);
-        auto page = reinterpret_cast<TablePage *>(
-                table_heap_->buffer_pool_manager_->FetchPage(rid_.GetPageId()));
+        PageGuard guard = table_heap_->buffer_pool_manager_->FetchPageBasic(rid_.GetPageId(), strategy_.get());
         // // std::cout << "TableIterator::TableIterator: rid_ = " << rid_.GetPageId() << std::endl;
-        if (page != nullptr) {
-            page->RLatch();
-            bool ok = page->GetTuple(&cur_row_, table_heap_->schema_, txn_,
-                                     table_heap_->lock_manager_);
-            page->RUnlatch();
-            table_heap_->buffer_pool_manager_->UnpinPage(rid_.GetPageId(), false);
+        if (guard.IsValid()) {
+            bool ok = reinterpret_cast<TablePage *>(guard.GetPage())
+                              ->GetTupleOptimistic(&cur_row_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
+            guard.Drop();
             if (!ok) {
                 // 读不到就认为是 end()
+                table_heap_->LeavePageChain();
                 table_heap_ = nullptr;
+            } else {
+                ReadAhead(rid_.GetPageId());
             }
         } else {
+            table_heap_->LeavePageChain();
             table_heap_ = nullptr;
         }
     }
@@ -38,11 +47,21 @@ TableIterator::TableIterator(const TableIterator &other) {
     rid_ = other.rid_;
     txn_ = other.txn_;
     cur_row_ = other.cur_row_;
+    strategy_ = other.strategy_;
+    cur_page_id_ = other.cur_page_id_;
+    read_ahead_frontier_ = other.read_ahead_frontier_;
+    pages_ahead_ = other.pages_ahead_;
     // 这里不需要复制 table_heap_ 的数据，因为它是一个指针
+    if (table_heap_ != nullptr) {
+        table_heap_->EnterPageChain();
+    }
 }
 
-// 析构函数：默认
-TableIterator::~TableIterator() = default;
+TableIterator::~TableIterator() {
+    if (table_heap_ != nullptr) {
+        table_heap_->LeavePageChain();
+    }
+}
 
 bool TableIterator::operator==(const TableIterator &itr) const {
     // 两个 end() 或者同表同位置 就相等
@@ -74,10 +93,20 @@ Row *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
     if (this != &itr) {
+        if (itr.table_heap_ != nullptr) {
+            itr.table_heap_->EnterPageChain();
+        }
+        if (table_heap_ != nullptr) {
+            table_heap_->LeavePageChain();
+        }
         table_heap_ = itr.table_heap_;
         rid_ = itr.rid_;
         txn_ = itr.txn_;
         cur_row_ = itr.cur_row_;
+        strategy_ = itr.strategy_;
+        cur_page_id_ = itr.cur_page_id_;
+        read_ahead_frontier_ = itr.read_ahead_frontier_;
+        pages_ahead_ = itr.pages_ahead_;
     }
     return *this;
 }
@@ -90,44 +119,46 @@ TableIterator &TableIterator::operator++() {
     if (table_heap_ == nullptr) {
         return *this;
     }
+    IoOwnerScope owner_scope(table_heap_->io_owner_);
 
     // 1) 本页内尝试找下一个 slot
     RowId next_rid;
     bool found = false;
-    auto page = reinterpret_cast<TablePage *>(
-            table_heap_->buffer_pool_manager_->FetchPage(rid_.GetPageId()));
-    if (page) {
-        page->RLatch();
+    ReadPageGuard guard = table_heap_->buffer_pool_manager_->FetchPageRead(rid_.GetPageId(), strategy_.get());
+    page_id_t pid = INVALID_PAGE_ID;
+    if (guard.IsValid()) {
+        auto page = reinterpret_cast<TablePage *>(guard.GetPage());
         found = page->GetNextTupleRid(rid_, &next_rid);
-        page->RUnlatch();
-        table_heap_->buffer_pool_manager_->UnpinPage(rid_.GetPageId(), false);
+        pid = page->GetNextPageId();
+        guard.Drop();
+        ReadAhead(rid_.GetPageId());
     }
 
     // 2) 如果本页没找到，沿 “next page” 链找第一个非删除 tuple
     if (!found) {
-        page_id_t pid = page ? page->GetNextPageId() : INVALID_PAGE_ID;
         while (pid != INVALID_PAGE_ID) {
-            auto p = reinterpret_cast<TablePage *>(
-                    table_heap_->buffer_pool_manager_->FetchPage(pid));
-            if (!p) {
+            guard = table_heap_->buffer_pool_manager_->FetchPageRead(pid, strategy_.get());
+            if (!guard.IsValid()) {
                 break;
             }
+            auto p = reinterpret_cast<TablePage *>(guard.GetPage());
             RowId first_rid;
-            p->RLatch();
             bool ok = p->GetFirstTupleRid(&first_rid);
-            p->RUnlatch();
-            table_heap_->buffer_pool_manager_->UnpinPage(pid, false);
+            page_id_t next_pid = p->GetNextPageId();
+            guard.Drop();
+            ReadAhead(pid);
             if (ok) {
                 next_rid = first_rid;
                 found    = true;
                 break;
             }
-            pid = p->GetNextPageId();
+            pid = next_pid;
         }
     }
 
     // 3) 如果确实没找到，下沉到 end()
     if (!found) {
+        table_heap_->LeavePageChain();
         table_heap_ = nullptr;
         rid_        = RowId();   // 默认就是 INVALID_PAGE_ID, 0
         txn_        = nullptr;
@@ -138,18 +169,50 @@ TableIterator &TableIterator::operator++() {
     rid_     = next_rid;
     cur_row_ = Row();
     cur_row_.SetRowId(rid_);
-    auto np = reinterpret_cast<TablePage *>(
-            table_heap_->buffer_pool_manager_->FetchPage(rid_.GetPageId()));
-    if (np) {
-        np->RLatch();
-        np->GetTuple(&cur_row_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
-        np->RUnlatch();
-        table_heap_->buffer_pool_manager_->UnpinPage(rid_.GetPageId(), false);
+    PageGuard tuple_guard = table_heap_->buffer_pool_manager_->FetchPageBasic(rid_.GetPageId(), strategy_.get());
+    if (tuple_guard.IsValid()) {
+        reinterpret_cast<TablePage *>(tuple_guard.GetPage())
+                ->GetTupleOptimistic(&cur_row_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
     }
     return *this;
 }
 
 
+void TableIterator::ReadAhead(page_id_t page_id) {
+    auto bpm = table_heap_->buffer_pool_manager_;
+    if (page_id != cur_page_id_) {
+        cur_page_id_ = page_id;
+        if (pages_ahead_ == 0 || page_id == read_ahead_frontier_) {
+            read_ahead_frontier_ = page_id;
+            pages_ahead_ = 0;
+        } else {
+            pages_ahead_--;
+        }
+    }
+
+    // pages read ahead into a strategy ring must not recycle each other before the scan reaches them
+    size_t window = TABLE_READ_AHEAD_PAGES;
+    if (strategy_ != nullptr) {
+        window = std::min(window, strategy_->GetRingSize() / 2);
+    }
+    vector<page_id_t> batch;
+    while (pages_ahead_ < window && read_ahead_frontier_ != INVALID_PAGE_ID &&
+           bpm->IsPageResident(read_ahead_frontier_)) {
+        ReadPageGuard guard = bpm->FetchPageRead(read_ahead_frontier_, strategy_.get());
+        if (!guard.IsValid()) {
+            break;
+        }
+        page_id_t next_page_id = reinterpret_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+        guard.Drop();
+        read_ahead_frontier_ = next_page_id;
+        if (next_page_id != INVALID_PAGE_ID) {
+            batch.push_back(next_page_id);
+            pages_ahead_++;
+        }
+    }
+    bpm->PrefetchPages(batch, strategy_);
+}
+
 // iter++
 TableIterator TableIterator::operator++(int) {
     TableIterator old(*this);
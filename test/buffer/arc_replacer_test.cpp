@@ -0,0 +1,48 @@
+#include "buffer/arc_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer arc_replacer(4);
+
+  // Scenario: frame i holds page i + 1, pages 1 and 2 are accessed twice and move to T2.
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    arc_replacer.RecordAccess(frame_id, frame_id + 1);
+    arc_replacer.Unpin(frame_id);
+  }
+  for (frame_id_t frame_id = 0; frame_id < 2; frame_id++) {
+    arc_replacer.Pin(frame_id);
+    arc_replacer.RecordAccess(frame_id, frame_id + 1);
+    arc_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(4, arc_replacer.Size());
+  EXPECT_EQ(0, arc_replacer.GetTargetT1Size());
+
+  // Scenario: T1 is above its target, so its least recently used page 3 is evicted into B1.
+  int value;
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: page 3 comes back, the B1 hit grows the target of T1 and the page goes to T2.
+  arc_replacer.RecordAccess(2, 3);
+  arc_replacer.Unpin(2);
+  EXPECT_EQ(1, arc_replacer.GetTargetT1Size());
+
+  // Scenario: T1 is at its target now, the least recently used page of T2 is evicted into B2.
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: page 1 comes back, the B2 hit shrinks the target of T1 again.
+  arc_replacer.RecordAccess(0, 1);
+  arc_replacer.Unpin(0);
+  EXPECT_EQ(0, arc_replacer.GetTargetT1Size());
+
+  // Scenario: pinned frames are skipped, only page 4 is left in T1.
+  arc_replacer.Pin(0);
+  arc_replacer.Pin(1);
+  arc_replacer.Pin(2);
+  EXPECT_EQ(1, arc_replacer.Size());
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_FALSE(arc_replacer.Victim(&value));
+}
@@ -1,9 +1,15 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <memory>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
 TEST(BufferPoolManagerTest, BinaryDataTest) {
@@ -71,4 +77,513 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlusherTest) {
+  const std::string db_name = "bpm_flusher_test.db";
+  const size_t buffer_pool_size = 32;
+  const size_t num_pages = 4 * buffer_pool_size;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  bpm->StartBackgroundFlusher(0.25, 5);
+
+  // Scenario: pages are dirtied far beyond the pool size, the flusher keeps most victims clean.
+  uint64_t background_write_backs = 0;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%zu", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    if (i % buffer_pool_size == buffer_pool_size - 1) {
+      // the whole pool is dirty, wait until the flusher has cleaned at least half of it
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+      while (bpm->GetBackgroundWriteBacks() < background_write_backs + buffer_pool_size / 2 &&
+             std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      background_write_backs = bpm->GetBackgroundWriteBacks();
+    }
+  }
+  EXPECT_GT(bpm->GetBackgroundWriteBacks(), 0);
+  EXPECT_LT(bpm->GetForegroundWriteBacks(), num_pages - buffer_pool_size);
+
+  // Scenario: pages written back in the background read back unchanged.
+  char expected[PAGE_SIZE];
+  for (size_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%zu", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PrefetchPagesTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 4 * buffer_pool_size;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%zu", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the first pages were evicted, prefetching brings them back without pinning them.
+  std::vector<page_id_t> page_ids;
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size / 2); i++) {
+    EXPECT_FALSE(bpm->IsPageResident(i));
+    page_ids.push_back(i);
+  }
+  bpm->PrefetchPages(page_ids);
+  for (auto page_id : page_ids) {
+    for (int retry = 0; retry < 100 && !bpm->IsPageResident(page_id); retry++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(bpm->IsPageResident(page_id));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: prefetched pages hold the content written before eviction.
+  char expected[PAGE_SIZE];
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, AccessStrategyTest) {
+  const std::string db_name = "bpm_strategy_test.db";
+  const size_t buffer_pool_size = 32;
+  const page_id_t hot_pages = 16;
+  const page_id_t bulk_pages = 200;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a bulk load only recycles the frames of its ring, the hot pages stay resident.
+  BufferAccessStrategy bulk_write(AccessStrategyType::kBulkWrite, 4);
+  for (page_id_t i = 0; i < bulk_pages; i++) {
+    auto *page = bpm->NewPage(page_id, &bulk_write);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t i = 0; i < hot_pages; i++) {
+    EXPECT_TRUE(bpm->IsPageResident(i));
+  }
+
+  // Scenario: so does a scan, and every page it reads holds what the bulk load wrote.
+  BufferAccessStrategy bulk_read(AccessStrategyType::kBulkRead, 4);
+  char expected[PAGE_SIZE];
+  for (page_id_t i = hot_pages; i < hot_pages + bulk_pages; i++) {
+    auto *page = bpm->FetchPage(i, &bulk_read);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  for (page_id_t i = 0; i < hot_pages; i++) {
+    EXPECT_TRUE(bpm->IsPageResident(i));
+  }
+
+  // Scenario: without a strategy the same scan pushes the hot pages out.
+  for (page_id_t i = hot_pages; i < hot_pages + bulk_pages; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_FALSE(bpm->IsPageResident(0));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * Micro-benchmark of the frame layout with a default sized pool: random hits on resident pages, which walk the
+ * descriptors and touch the page data, and full scans over the frame descriptors like the flusher does.
+ */
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  const IoOwner table = IoOwner::Table(7);
+  const IoOwner index = IoOwner::Index(3);
+  IoStats disk_before = disk_manager->GetIoStats();
+
+  // Scenario: new pages beyond the pool size evict the older dirty ones, charged to the table.
+  {
+    IoOwnerScope scope(table);
+    for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+  }
+  // Scenario: one hit, then one miss that evicts a dirty page, charged to the index.
+  {
+    IoOwnerScope scope(index);
+    ASSERT_NE(nullptr, bpm->FetchPage(7));
+    EXPECT_TRUE(bpm->UnpinPage(7, false));
+    ASSERT_NE(nullptr, bpm->FetchPage(0));
+    EXPECT_TRUE(bpm->UnpinPage(0, false));
+  }
+  // Scenario: activity outside any scope only shows up in the totals.
+  BufferPoolStats before = bpm->GetStats();
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_EQ(IoOwner::Kind::kNone, IoOwnerScope::Current().kind_);
+
+  BufferPoolStats total = bpm->GetStats();
+  EXPECT_EQ(1, total.hits_);
+  EXPECT_EQ(2, total.misses_);
+  EXPECT_EQ(6, total.evictions_);
+  EXPECT_EQ(6, total.dirty_write_backs_);
+  BufferPoolStats delta = total - before;
+  EXPECT_EQ(0, delta.hits_);
+  EXPECT_EQ(1, delta.misses_);
+
+  auto owners = bpm->GetOwnerStats();
+  ASSERT_EQ(2, owners.size());
+  EXPECT_EQ(0, owners[table.Key()].hits_ + owners[table.Key()].misses_);
+  EXPECT_EQ(4, owners[table.Key()].evictions_);
+  EXPECT_EQ(4, owners[table.Key()].dirty_write_backs_);
+  EXPECT_EQ(1, owners[index.Key()].hits_);
+  EXPECT_EQ(1, owners[index.Key()].misses_);
+  EXPECT_EQ(1, owners[index.Key()].evictions_);
+  EXPECT_EQ(1, owners[index.Key()].dirty_write_backs_);
+
+  // Scenario: the disk manager counts every physical transfer and charges it to the same owners.
+  IoStats disk = disk_manager->GetIoStats() - disk_before;
+  EXPECT_GE(disk.pages_written_, 5);
+  EXPECT_EQ(disk.pages_written_ * PAGE_SIZE, disk.bytes_written_);
+  EXPECT_GE(disk.pages_read_, 2);
+  auto disk_owners = disk_manager->GetOwnerIoStats();
+  EXPECT_GE(disk_owners[table.Key()].pages_written_, 4);
+  EXPECT_EQ(1, disk_owners[index.Key()].pages_written_);
+  EXPECT_EQ(1, disk_owners[index.Key()].pages_read_);
+  EXPECT_EQ(PAGE_SIZE, disk_owners[index.Key()].bytes_read_);
+  EXPECT_LE(disk_owners[index.Key()].io_time_ns_, disk.io_time_ns_);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, ReplacerType::kARC);
+  char expected[PAGE_SIZE];
+
+  // Scenario: growing adds free frames, twice as many pages stay resident without evictions.
+  ASSERT_TRUE(bpm->Resize(2 * buffer_pool_size));
+  EXPECT_EQ(2 * buffer_pool_size, bpm->GetPoolSize());
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(0, bpm->GetStats().evictions_);
+
+  // Scenario: shrinking fails cleanly while a frame to be released stays pinned.
+  auto *pinned = bpm->FetchPage(2 * buffer_pool_size - 1);
+  ASSERT_NE(nullptr, pinned);
+  EXPECT_FALSE(bpm->Resize(buffer_pool_size, 20));
+  EXPECT_EQ(2 * buffer_pool_size, bpm->GetPoolSize());
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(bpm->GetMaxPoolSize() + 1));
+
+  // Scenario: shrinking waits for the pin to be released, dirty pages of released frames are written back.
+  std::thread unpinner([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bpm->UnpinPage(2 * buffer_pool_size - 1, false);
+  });
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size, 5000));
+  unpinner.join();
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%zu", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(buffer_pool_size));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: a partitioned pool spreads the new size over its instances.
+  auto *parallel_bpm = new ParallelBufferPoolManager(3, 10, disk_manager);
+  EXPECT_TRUE(parallel_bpm->Resize(31));
+  EXPECT_EQ(31, parallel_bpm->GetPoolSize());
+  EXPECT_TRUE(parallel_bpm->Resize(5));
+  EXPECT_EQ(5, parallel_bpm->GetPoolSize());
+  EXPECT_FALSE(parallel_bpm->Resize(2));
+
+  delete parallel_bpm;
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FrameLayoutBenchmarkTest) {
+  const std::string db_name = "bpm_layout_bench.db";
+  const size_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE;
+  const size_t num_fetches = 500000;
+  const size_t num_scans = 200;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    bpm->UnpinPage(page_id, false);
+    page_ids.push_back(page_id);
+  }
+
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+  uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_fetches; i++) {
+    page_id_t page_id = page_ids[dist(rng)];
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    checksum += page->GetData()[i % PAGE_SIZE];
+    bpm->UnpinPage(page_id, false);
+  }
+  std::chrono::duration<double> fetch_elapsed = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_scans; i++) {
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+  }
+  std::chrono::duration<double> scan_elapsed = std::chrono::steady_clock::now() - start;
+
+  printf("[FrameLayout] frames=%zu fetch=%.0f ops/s descriptor scan=%.0f frames/s checksum=%lu\n", buffer_pool_size,
+         num_fetches / fetch_elapsed.count(), buffer_pool_size * num_scans / scan_elapsed.count(),
+         static_cast<unsigned long>(checksum));
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmRestartTest) {
+  const std::string db_name = "bpm_warm_restart_test.db";
+  const std::string working_set_file = DiskManager::WorkingSetFileName(db_name);
+  const size_t buffer_pool_size = 32;
+  const size_t num_pages = 4 * buffer_pool_size;
+
+  // Scenario: every policy lists its frames in the order it hands out victims.
+  std::mt19937 rng(19);
+  for (auto type : {ReplacerType::kLRU, ReplacerType::kClock, ReplacerType::kLRUK, ReplacerType::kARC}) {
+    std::unique_ptr<Replacer> replacer(Replacer::Create(type, 16));
+    for (int i = 0; i < 200; i++) {
+      auto frame_id = static_cast<frame_id_t>(rng() % 16);
+      replacer->Pin(frame_id);
+      replacer->RecordAccess(frame_id, static_cast<page_id_t>(rng() % 24));
+      if (rng() % 4 != 0) {
+        replacer->Unpin(frame_id);
+      }
+    }
+    std::vector<frame_id_t> order = replacer->GetEvictionOrder();
+    std::vector<frame_id_t> victims;
+    frame_id_t victim;
+    while (replacer->Victim(&victim)) {
+      victims.push_back(victim);
+    }
+    EXPECT_FALSE(victims.empty());
+    EXPECT_EQ(victims, order) << static_cast<int>(type);
+  }
+
+  DiskManager::RemoveFiles(db_name);
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%zu", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: on shutdown the pool saves the ids of its pages, the ones used last first.
+  std::vector<page_id_t> hot;
+  for (page_id_t page_id = 10; page_id < 20; page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    hot.insert(hot.begin(), page_id);
+  }
+  std::vector<page_id_t> working_set = bpm->GetWorkingSet();
+  ASSERT_EQ(buffer_pool_size, working_set.size());
+  EXPECT_EQ(hot, std::vector<page_id_t>(working_set.begin(), working_set.begin() + hot.size()));
+  bpm->SetWorkingSetFile(working_set_file);
+  delete bpm;
+
+  // Scenario: a smaller pool is prewarmed with the hottest pages of the list and serves them without further reads.
+  bpm = new BufferPoolManager(buffer_pool_size / 2, disk_manager);
+  IoStats before = disk_manager->GetIoStats();
+  EXPECT_EQ(buffer_pool_size / 2, bpm->Prewarm(working_set_file));
+  EXPECT_EQ(buffer_pool_size / 2, (disk_manager->GetIoStats() - before).pages_read_);
+  before = disk_manager->GetIoStats();
+  char expected[PAGE_SIZE];
+  for (auto page_id : hot) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0u, (disk_manager->GetIoStats() - before).pages_read_);
+  delete bpm;
+
+  // Scenario: a parallel pool is prewarmed in the background, pages freed in the meantime are skipped.
+  disk_manager->DeAllocatePage(hot[0]);
+  auto *parallel = new ParallelBufferPoolManager(4, 2 * buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size, parallel->Prewarm(working_set_file, true));
+  size_t resident = 0;
+  for (int retry = 0; retry < 100 && resident < working_set.size() - 1; retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    resident = 0;
+    for (auto page_id : working_set) {
+      resident += parallel->IsPageResident(page_id) ? 1 : 0;
+    }
+  }
+  EXPECT_EQ(working_set.size() - 1, resident);
+  EXPECT_FALSE(parallel->IsPageResident(hot[0]));
+
+  // Scenario: a parallel pool saves the pages of all its instances.
+  parallel->SetWorkingSetFile(working_set_file);
+  delete parallel;
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_EQ(working_set.size() - 1, bpm->Prewarm(working_set_file));
+  delete bpm;
+  delete disk_manager;
+  DiskManager::RemoveFiles(db_name);
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "bpm_flush_all_test.db";
+  const size_t buffer_pool_size = 1024;
+
+  for (bool parallel : {false, true}) {
+    DiskManager::RemoveFiles(db_name);
+    auto *disk_manager = new DiskManager(db_name);
+    BufferPoolManager *bpm = parallel ? new ParallelBufferPoolManager(4, buffer_pool_size, disk_manager)
+                                      : new BufferPoolManager(buffer_pool_size, disk_manager);
+    std::vector<page_id_t> page_ids;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      page_ids.push_back(page_id);
+    }
+    std::shuffle(page_ids.begin(), page_ids.end(), std::default_random_engine(0));
+    auto dirty_all = [&](int round) {
+      for (auto page_id : page_ids) {
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "page-%d-round-%d", page_id, round);
+        ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    };
+
+    // Scenario: the pages are dirtied in random order, flushing them one by one seeks all over the file.
+    dirty_all(0);
+    auto start = std::chrono::steady_clock::now();
+    for (auto page_id : page_ids) {
+      ASSERT_TRUE(bpm->FlushPage(page_id));
+    }
+    disk_manager->Sync();
+    std::chrono::duration<double> one_by_one = std::chrono::steady_clock::now() - start;
+
+    // Scenario: FlushAllPages writes every dirty page once, a pinned page included, and leaves them all clean.
+    dirty_all(1);
+    page_id_t pinned_id = page_ids[0];
+    auto *pinned = bpm->FetchPage(pinned_id);
+    ASSERT_NE(nullptr, pinned);
+    IoStats before = disk_manager->GetIoStats();
+    start = std::chrono::steady_clock::now();
+    bpm->FlushAllPages();
+    std::chrono::duration<double> sorted = std::chrono::steady_clock::now() - start;
+    IoStats written = disk_manager->GetIoStats() - before;
+    EXPECT_EQ(buffer_pool_size, written.pages_written_);
+    EXPECT_FALSE(pinned->IsDirty());
+    EXPECT_TRUE(bpm->UnpinPage(pinned_id, false));
+    for (auto page_id : page_ids) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_FALSE(page->IsDirty());
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    printf("[FlushAll] parallel=%d pages=%zu one_by_one=%.1fms sorted=%.1fms\n", parallel, buffer_pool_size,
+           one_by_one.count() * 1000, sorted.count() * 1000);
+
+    // Scenario: nothing is left to write, a second flush does no I/O.
+    before = disk_manager->GetIoStats();
+    bpm->FlushAllPages();
+    EXPECT_EQ(0, (disk_manager->GetIoStats() - before).pages_written_);
+
+    // Scenario: the pages written by the sorted flush are the ones read back after a restart.
+    delete bpm;
+    disk_manager->Close();
+    delete disk_manager;
+    disk_manager = new DiskManager(db_name);
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    char expected[PAGE_SIZE];
+    for (auto page_id : page_ids) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page-%d-round-%d", page_id, 1);
+      EXPECT_STREQ(expected, page->GetData());
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    delete bpm;
+    disk_manager->Close();
+    delete disk_manager;
+  }
+  DiskManager::RemoveFiles(db_name);
+}
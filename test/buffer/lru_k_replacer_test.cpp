@@ -0,0 +1,72 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: access five frames once, then frames 1 and 2 a second time.
+  for (frame_id_t frame_id = 1; frame_id <= 5; frame_id++) {
+    lru_k_replacer.RecordAccess(frame_id, frame_id);
+  }
+  lru_k_replacer.RecordAccess(1, 1);
+  lru_k_replacer.RecordAccess(2, 2);
+  for (frame_id_t frame_id = 1; frame_id <= 5; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.Unpin(1);  // Unpin 1 again, should have no effect.
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // Scenario: frames accessed once have an infinite backward 2-distance and go first, oldest first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: pinned frames are not victimized.
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: a frame reused for another page starts a new history.
+  lru_k_replacer.RecordAccess(1, 10);
+  lru_k_replacer.RecordAccess(1, 10);
+  lru_k_replacer.RecordAccess(2, 11);
+  lru_k_replacer.RecordAccess(2, 11);
+  lru_k_replacer.RecordAccess(2, 12);
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Unpin(5);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+
+  // Scenario: with a correlated reference period, back-to-back accesses count as one.
+  LRUKReplacer correlated_replacer(7, 2, 2);
+  correlated_replacer.RecordAccess(1, 1);
+  correlated_replacer.RecordAccess(1, 1);
+  correlated_replacer.RecordAccess(2, 2);
+  correlated_replacer.RecordAccess(3, 3);
+  correlated_replacer.RecordAccess(4, 4);
+  correlated_replacer.RecordAccess(2, 2);
+  for (frame_id_t frame_id = 1; frame_id <= 4; frame_id++) {
+    correlated_replacer.Unpin(frame_id);
+  }
+  ASSERT_TRUE(correlated_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(correlated_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(correlated_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  ASSERT_TRUE(correlated_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+}
@@ -0,0 +1,142 @@
+#include "buffer/page_guard.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+TEST(PageGuardTest, PinReleaseTest) {
+  const std::string db_name = "page_guard_test.db";
+  const size_t buffer_pool_size = 5;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  {
+    PageGuard guard = bpm->NewPageGuarded(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  // Scenario: the guard gave its pin back when it went out of scope.
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: moving a guard transfers the pin, the moved-from guard releases nothing.
+  {
+    PageGuard guard = bpm->FetchPageBasic(page_id);
+    Page *page = guard.GetPage();
+    PageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+    PageGuard assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(0, strcmp(assigned.GetData(), "Hello"));
+    assigned.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+    // a second drop must not unpin again
+    assigned.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+  }
+
+  // Scenario: a fetch that fails yields an empty guard.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t temp;
+    ASSERT_NE(nullptr, bpm->NewPage(temp));
+  }
+  page_id_t temp;
+  EXPECT_FALSE(bpm->NewPageGuarded(temp).IsValid());
+  EXPECT_FALSE(bpm->FetchPageRead(page_id).IsValid());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(PageGuardTest, LatchTest) {
+  const std::string db_name = "page_guard_test.db";
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 10, disk_manager);
+
+  page_id_t page_id;
+  bpm->NewPageGuarded(page_id).Drop();
+  {
+    // Scenario: several readers share the page, each guard holds one pin.
+    ReadPageGuard reader1 = bpm->FetchPageRead(page_id);
+    ReadPageGuard reader2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, reader1.GetPage()->GetPinCount());
+    reader1.Drop();
+    EXPECT_EQ(1, reader2.GetPage()->GetPinCount());
+  }
+  {
+    // Scenario: the write latch is free again once the readers are gone, changes are kept.
+    WritePageGuard writer = bpm->FetchPageWrite(page_id);
+    ASSERT_TRUE(writer.IsValid());
+    writer.AsMut<int>()[0] = 42;
+  }
+  {
+    PageGuard guard = bpm->FetchPageBasic(page_id);
+    WritePageGuard writer = guard.UpgradeWrite();
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(42, writer.As<int>()[0]);
+    EXPECT_EQ(1, writer.GetPage()->GetPinCount());
+    EXPECT_TRUE(writer.GetPage()->IsDirty());
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(PageGuardTest, OptimisticReadTest) {
+  const std::string db_name = "page_guard_optimistic_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  bpm->NewPageGuarded(page_id).Drop();
+  PageGuard guard = bpm->FetchPageBasic(page_id);
+  Page *page = guard.GetPage();
+
+  // Scenario: a read no writer got in the way of stays valid.
+  uint64_t version;
+  EXPECT_TRUE(page->ReadOptimistic([&]() { return guard.As<int>()[0] == 0; }, &version));
+  EXPECT_TRUE(page->ValidateVersion(version));
+
+  // Scenario: a write latch taken after the read invalidates it.
+  {
+    WritePageGuard writer = bpm->FetchPageWrite(page_id);
+    writer.AsMut<int>()[0] = 7;
+  }
+  EXPECT_FALSE(page->ValidateVersion(version));
+  EXPECT_TRUE(page->ReadOptimistic([&]() { return guard.As<int>()[0] == 7; }, &version));
+
+  // Scenario: inside a write scope, mutable access latches the page until the last guard holding it is gone.
+  {
+    PageWriteScope scope;
+    PageGuard first = bpm->FetchPageBasic(page_id);
+    PageGuard second = bpm->FetchPageBasic(page_id);
+    first.AsMut<int>()[0] = 8;
+    second.AsMut<int>()[1] = 9;
+    EXPECT_FALSE(page->ValidateVersion(version));
+    first.Drop();
+    EXPECT_FALSE(page->ValidateVersion(version));
+  }
+  EXPECT_TRUE(page->ReadOptimistic([&]() { return guard.As<int>()[0] == 8 && guard.As<int>()[1] == 9; }, &version));
+  guard.Drop();
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
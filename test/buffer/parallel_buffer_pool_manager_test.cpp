@@ -0,0 +1,174 @@
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
+  const std::string db_name = "parallel_bpm_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 20;
+
+  std::random_device r;
+  std::default_random_engine rng(r());
+  std::uniform_int_distribution<unsigned> uniform_dist(0, 127);
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  ASSERT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: page ids are spread over all instances, so the whole pool can be filled.
+  std::vector<std::vector<char>> contents;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id);
+    std::vector<char> data(PAGE_SIZE);
+    for (auto &c : data) {
+      c = static_cast<char>(uniform_dist(rng));
+    }
+    memcpy(page->GetData(), data.data(), PAGE_SIZE);
+    contents.emplace_back(std::move(data));
+  }
+
+  // Scenario: once every frame is pinned, no more pages can be created and no page id is leaked.
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_TRUE(bpm->IsPageFree(buffer_pool_size));
+
+  // Scenario: unpinned pages are evicted to disk and read back unchanged.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_EQ(buffer_pool_size + i, page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, memcmp(page->GetData(), contents[i].data(), PAGE_SIZE));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(ParallelBufferPoolManagerTest, NewPageWithFullInstanceTest) {
+  const std::string db_name = "parallel_bpm_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 20;
+  const size_t instance_size = buffer_pool_size / num_instances;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: pin every frame of the first instance, the ids it owns are left unpinned in the others.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < num_instances * instance_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    if (page_id % num_instances == 0) {
+      page_ids.push_back(page_id);
+    } else {
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+  ASSERT_EQ(instance_size, page_ids.size());
+
+  // Scenario: the next id belongs to the full instance, new pages are still created in the others.
+  page_id_t next_page_id = num_instances * instance_size;
+  ASSERT_EQ(0u, next_page_id % num_instances);
+  for (size_t i = 0; i < 2 * num_instances; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_NE(0u, page_id % num_instances);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  // the skipped id was given back
+  EXPECT_TRUE(bpm->IsPageFree(next_page_id));
+
+  // Scenario: once the full instance unpins a page, its id is handed out again.
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(next_page_id, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  for (size_t i = 1; i < page_ids.size(); i++) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * Measures FetchPage/UnpinPage throughput of a single instance against a partitioned pool. All pages are resident,
+ * so the numbers reflect latch contention rather than disk I/O.
+ */
+static double MeasureFetchUnpinThroughput(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids,
+                                          size_t num_threads, size_t ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = page_ids[dist(rng)];
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * ops_per_thread) / elapsed.count();
+}
+
+TEST(ParallelBufferPoolManagerTest, FetchUnpinThroughputTest) {
+  const std::string db_name = "parallel_bpm_bench.db";
+  const size_t buffer_pool_size = 1024;
+  const size_t num_pages = 512;
+  const size_t ops_per_thread = 50000;
+  const size_t max_threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    double throughput[2];
+    for (int parallel = 0; parallel < 2; parallel++) {
+      remove(db_name.c_str());
+      auto *disk_manager = new DiskManager(db_name);
+      BufferPoolManager *bpm = parallel ? new ParallelBufferPoolManager(num_threads, buffer_pool_size, disk_manager)
+                                        : new BufferPoolManager(buffer_pool_size, disk_manager);
+      std::vector<page_id_t> page_ids;
+      for (size_t i = 0; i < num_pages; i++) {
+        page_id_t page_id;
+        ASSERT_NE(nullptr, bpm->NewPage(page_id));
+        bpm->UnpinPage(page_id, false);
+        page_ids.push_back(page_id);
+      }
+      throughput[parallel] = MeasureFetchUnpinThroughput(bpm, page_ids, num_threads, ops_per_thread);
+      EXPECT_TRUE(bpm->CheckAllUnpinned());
+      delete bpm;
+      delete disk_manager;
+    }
+    printf("[ParallelBPM] threads=%zu single=%.0f ops/s parallel=%.0f ops/s speedup=%.2fx\n", num_threads,
+           throughput[0], throughput[1], throughput[1] / throughput[0]);
+  }
+  remove(db_name.c_str());
+}
@@ -0,0 +1,168 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+
+/**
+ * A buffer pool that records the id of every page handed out to its callers.
+ */
+class TracingBufferPoolManager : public BufferPoolManager {
+ public:
+  TracingBufferPoolManager(size_t pool_size, DiskManager *disk_manager) : BufferPoolManager(pool_size, disk_manager) {}
+
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) override {
+    trace_.push_back(page_id);
+    return BufferPoolManager::FetchPage(page_id, strategy);
+  }
+
+  std::vector<page_id_t> trace_;
+};
+
+/**
+ * Replays a page access trace against a replacer the way BufferPoolManager drives it.
+ * @return the fraction of accesses that found their page resident
+ */
+static double ReplayTrace(ReplacerType type, size_t pool_size, const std::vector<page_id_t> &trace) {
+  std::unique_ptr<Replacer> replacer(Replacer::Create(type, pool_size));
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frames(pool_size, INVALID_PAGE_ID);
+  size_t next_free = 0;
+  size_t hits = 0;
+  for (auto page_id : trace) {
+    frame_id_t frame_id;
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+      hits++;
+      frame_id = it->second;
+      replacer->Pin(frame_id);
+    } else {
+      if (next_free < pool_size) {
+        frame_id = static_cast<frame_id_t>(next_free++);
+      } else {
+        EXPECT_TRUE(replacer->Victim(&frame_id));
+        page_table.erase(frames[frame_id]);
+      }
+      frames[frame_id] = page_id;
+      page_table[page_id] = frame_id;
+    }
+    replacer->RecordAccess(frame_id, page_id);
+    replacer->Unpin(frame_id);
+  }
+  return trace.empty() ? 0 : static_cast<double>(hits) / trace.size();
+}
+
+static const std::vector<std::pair<ReplacerType, const char *>> kPolicies = {
+    {ReplacerType::kLRU, "LRU"}, {ReplacerType::kClock, "CLOCK"}, {ReplacerType::kLRUK, "LRU-K"}, {ReplacerType::kARC, "ARC"}};
+
+static std::unordered_map<ReplacerType, double> ReportHitRatios(const std::string &name, size_t pool_size,
+                                                                const std::vector<page_id_t> &trace) {
+  std::unordered_map<ReplacerType, double> ratios;
+  printf("[ReplacerTrace] %s accesses=%zu pool=%zu", name.c_str(), trace.size(), pool_size);
+  for (auto &policy : kPolicies) {
+    ratios[policy.first] = ReplayTrace(policy.first, pool_size, trace);
+    printf(" %s=%.4f", policy.second, ratios[policy.first]);
+  }
+  printf("\n");
+  return ratios;
+}
+
+/**
+ * Point lookups on a hot set of pages, interrupted by sequential scans over a table several times the pool size.
+ */
+TEST(ReplacerBenchmarkTest, HotSetWithScansTest) {
+  const size_t pool_size = 256;
+  const page_id_t hot_pages = 128;
+  const page_id_t scan_pages = 2048;
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, hot_pages - 1);
+
+  std::vector<page_id_t> trace;
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < 5000; i++) {
+      trace.push_back(hot_dist(rng));
+    }
+    for (page_id_t page_id = 0; page_id < scan_pages; page_id++) {
+      trace.push_back(hot_pages + page_id);
+    }
+  }
+  auto ratios = ReportHitRatios("hot-set+scan", pool_size, trace);
+  EXPECT_GT(ratios[ReplacerType::kLRUK], ratios[ReplacerType::kLRU]);
+  EXPECT_GT(ratios[ReplacerType::kARC], ratios[ReplacerType::kLRU]);
+}
+
+/**
+ * Records the page accesses of real table heap operations: point reads of a small table while a large table is
+ * scanned over and over, then replays them with a pool that only holds a part of the large table.
+ */
+TEST(ReplacerBenchmarkTest, TableHeapTraceTest) {
+  const std::string db_name = "replacer_trace_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new TracingBufferPoolManager(4096, disk_manager);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *hot_table = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  TableHeap *scan_table = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  char name[64];
+  memset(name, 'x', sizeof(name));
+  std::vector<RowId> hot_rows;
+  for (int i = 0; i < 8000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE((i % 4 == 0 ? hot_table : scan_table)->InsertTuple(row, nullptr));
+    if (i % 4 == 0) {
+      hot_rows.push_back(row.GetRowId());
+    }
+  }
+
+  bpm->trace_.clear();
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<size_t> hot_dist(0, hot_rows.size() - 1);
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 2000; i++) {
+      Row row(hot_rows[hot_dist(rng)]);
+      ASSERT_TRUE(hot_table->GetTuple(&row, nullptr));
+    }
+    for (auto it = scan_table->Begin(nullptr); it != scan_table->End(); ++it) {
+    }
+  }
+  std::vector<page_id_t> trace = std::move(bpm->trace_);
+  ReportHitRatios("table-heap", 48, trace);
+
+  delete hot_table;
+  delete scan_table;
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * Replays a trace recorded elsewhere, one page id per line, named by the MINISQL_PAGE_TRACE environment variable.
+ * MINISQL_PAGE_TRACE_POOL_SIZE overrides the replayed pool size.
+ */
+TEST(ReplacerBenchmarkTest, RecordedTraceFileTest) {
+  const char *trace_file = std::getenv("MINISQL_PAGE_TRACE");
+  if (trace_file == nullptr) {
+    GTEST_SKIP() << "MINISQL_PAGE_TRACE not set";
+  }
+  std::ifstream in(trace_file);
+  ASSERT_TRUE(in.is_open());
+  std::vector<page_id_t> trace;
+  page_id_t page_id;
+  while (in >> page_id) {
+    trace.push_back(page_id);
+  }
+  const char *pool_size = std::getenv("MINISQL_PAGE_TRACE_POOL_SIZE");
+  ReportHitRatios(trace_file, pool_size == nullptr ? 1024 : std::strtoul(pool_size, nullptr, 10), trace);
+}
@@ -127,4 +127,61 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+TEST(CatalogTest, CatalogSegmentTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  auto &catalog_01 = db_01->catalog_mgr_;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateTable("table-1", schema.get(), &txn, table_info));
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog_01->CreateIndex("table-1", "index-1", {"id"}, &txn, index_info, "bptree"));
+
+  // Scenario: the table and its index live in segment files of their own.
+  std::string db_file = "./databases/" + db_file_name;
+  segment_id_t table_segment = table_info->GetTableHeap()->GetSegmentId();
+  ASSERT_NE(0u, table_segment);
+  std::string table_file = DiskManager::SegmentFileName(db_file, table_segment);
+  std::string index_file = DiskManager::SegmentFileName(db_file, table_segment + 1);
+  for (int i = 0; i < 1000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, &txn));
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+    Row key(key_fields);
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key, row.GetRowId(), &txn));
+  }
+  EXPECT_EQ(table_segment, DiskManager::SegmentOf(table_info->GetTableHeap()->GetFirstPageId()));
+  delete db_01;
+  EXPECT_EQ(0, access(table_file.c_str(), F_OK));
+  EXPECT_EQ(0, access(index_file.c_str(), F_OK));
+
+  // Scenario: after a reopen the rows are read from the segment files, dropping removes the files.
+  auto db_02 = new DBStorageEngine(db_file_name, false);
+  auto &catalog_02 = db_02->catalog_mgr_;
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetTable("table-1", table_info));
+  ASSERT_EQ(DB_SUCCESS, catalog_02->GetIndex("table-1", "index-1", index_info));
+  size_t rows = 0;
+  for (auto it = table_info->GetTableHeap()->Begin(&txn); it != table_info->GetTableHeap()->End(); ++it) {
+    rows++;
+  }
+  EXPECT_EQ(1000, rows);
+  std::vector<Field> fields{Field(TypeId::kTypeInt, 500)};
+  Row key(fields);
+  std::vector<RowId> result;
+  ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, &txn));
+  ASSERT_EQ(1, result.size());
+  ASSERT_EQ(DB_SUCCESS, catalog_02->DropIndex("table-1", "index-1"));
+  EXPECT_NE(0, access(index_file.c_str(), F_OK));
+  ASSERT_EQ(DB_SUCCESS, catalog_02->DropTable("table-1"));
+  EXPECT_NE(0, access(table_file.c_str(), F_OK));
+  delete db_02;
+
+  auto db_03 = new DBStorageEngine(db_file_name, false);
+  ASSERT_EQ(DB_TABLE_NOT_EXIST, db_03->catalog_mgr_->GetTable("table-1", table_info));
+  delete db_03;
+}
@@ -1,5 +1,8 @@
 #include "index/b_plus_tree.h"
 
+#include <atomic>
+#include <thread>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/comparator.h"
@@ -71,4 +74,62 @@ TEST(BPlusTreeTests, SampleTest) {
     ASSERT_TRUE(tree.GetValue(delete_seq[i], ans));
     ASSERT_EQ(kv_map[delete_seq[i]], ans[ans.size() - 1]);
   }
-}
\ No newline at end of file
+}
+TEST(BPlusTreeTests, ConcurrentReadTest) {
+  const std::string concurrent_db_name = "bp_tree_concurrent_test.db";
+  remove(concurrent_db_name.c_str());
+  DBStorageEngine engine(concurrent_db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  // small nodes, so that the writer splits and merges all the time
+  BPlusTree tree(0, engine.bpm_, KP, 8, 8);
+  const int n = 2000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  // keys i % 4 == 0 stay in the tree, the writer inserts and removes the others
+  for (int i = 0; i < n; i += 2) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+
+  // Scenario: lookups of keys nobody removes always succeed while the tree is restructured under them.
+  std::atomic<bool> done{false};
+  std::atomic<int> misses{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; t++) {
+    readers.emplace_back([&, t]() {
+      for (int round = 0; !done || round < 2; round++) {
+        for (int i = t * 4; i < n; i += 12) {
+          vector<RowId> result;
+          if (!tree.GetValue(keys[i], result) || result.size() != 1 || !(result[0] == RowId(i))) {
+            misses++;
+          }
+        }
+      }
+    });
+  }
+  for (int i = 1; i < n; i += 2) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  for (int i = 2; i < n; i += 4) {
+    tree.Remove(keys[i]);
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, misses);
+  ASSERT_TRUE(tree.Check());
+
+  vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(i % 4 != 2, tree.GetValue(keys[i], result));
+  }
+}
@@ -0,0 +1,92 @@
+#include "page/table_page.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+
+TEST(PageTests, TablePageCompactionTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 256, 1, true, false)};
+  Schema schema(columns);
+  auto make_row = [](int id, const std::string &name) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, id),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    return Row(fields);
+  };
+  auto read_name = [&](TablePage &page, const RowId &rid, std::string *name) {
+    Row row(rid);
+    if (!page.GetTuple(&row, &schema, nullptr, nullptr)) {
+      return false;
+    }
+    *name = std::string(row.GetField(1)->GetData(), row.GetField(1)->GetLength());
+    return true;
+  };
+  TablePage page;
+  page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+
+  // Scenario: fill the page, then free every other tuple, the holes are counted as free space.
+  std::vector<RowId> rids;
+  std::string name(64, 'a');
+  for (int i = 0;; i++) {
+    Row row = make_row(i, name);
+    if (!page.InsertTuple(row, &schema, nullptr, nullptr, nullptr)) {
+      break;
+    }
+    rids.push_back(row.GetRowId());
+  }
+  ASSERT_GT(rids.size(), 8u);
+  uint32_t full = page.GetFreeSpaceRemaining();
+  for (size_t i = 0; i < rids.size(); i += 2) {
+    ASSERT_TRUE(page.MarkDelete(rids[i], nullptr, nullptr, nullptr));
+    page.ApplyDelete(rids[i], nullptr, nullptr);
+  }
+  uint32_t freed = page.GetFreeSpaceRemaining();
+  EXPECT_GT(freed, full + (rids.size() / 2 - 1) * 64);
+
+  // Scenario: a tuple larger than any single hole still fits, the compaction leaves the live tuples in their slots.
+  std::string large(2 * 64 + 32, 'b');
+  Row large_row = make_row(-1, large);
+  ASSERT_TRUE(page.InsertTuple(large_row, &schema, nullptr, nullptr, nullptr));
+  EXPECT_EQ(0u, large_row.GetRowId().GetSlotNum());
+  std::string read;
+  for (size_t i = 1; i < rids.size(); i += 2) {
+    ASSERT_TRUE(read_name(page, rids[i], &read));
+    EXPECT_EQ(name, read);
+  }
+  ASSERT_TRUE(read_name(page, large_row.GetRowId(), &read));
+  EXPECT_EQ(large, read);
+
+  // Scenario: updates that shrink and grow a tuple in turn keep it in its slot and do not use up the page.
+  RowId updated = rids[1];
+  for (int i = 0; i < 1000; i++) {
+    std::string value(i % 2 == 0 ? 8 : 200, 'c');
+    Row new_row = make_row(1, value);
+    Row old_row(updated);
+    ASSERT_TRUE(page.UpdateTuple(new_row, &old_row, &schema, nullptr, nullptr, nullptr));
+    ASSERT_TRUE(read_name(page, updated, &read));
+    EXPECT_EQ(value, read);
+  }
+  for (size_t i = 3; i < rids.size(); i += 2) {
+    ASSERT_TRUE(read_name(page, rids[i], &read));
+    EXPECT_EQ(name, read);
+  }
+
+  // Scenario: a tuple deleted but not yet applied keeps its bytes through a compaction and can be rolled back.
+  RowId marked = rids[3];
+  ASSERT_TRUE(page.MarkDelete(marked, nullptr, nullptr, nullptr));
+  page.Compact();
+  EXPECT_FALSE(read_name(page, marked, &read));
+  page.RollbackDelete(marked, nullptr, nullptr);
+  ASSERT_TRUE(read_name(page, marked, &read));
+  EXPECT_EQ(name, read);
+
+  // Scenario: once every tuple is gone the empty slots are dropped and the whole page is free again.
+  for (RowId rid = RowId(0, 0); page.GetFirstTupleRid(&rid);) {
+    ASSERT_TRUE(page.MarkDelete(rid, nullptr, nullptr, nullptr));
+    page.ApplyDelete(rid, nullptr, nullptr);
+  }
+  EXPECT_EQ(static_cast<uint32_t>(TablePage::SIZE_MAX_ROW + TablePage::SIZE_TUPLE), page.GetFreeSpaceRemaining());
+}
@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+#include "utils/utils.h"
+
+static const std::string db_file_name = "compression_benchmark_test.db";
+using Fields = std::vector<Field>;
+using RowMaker = std::function<Fields(int)>;
+
+struct CompressionResult {
+  double ratio_;
+  double scan_mb_per_s_;
+  int rows_;
+};
+
+/**
+ * Loads a table into a segment of its own, flushes it and scans it back through a cold buffer pool.
+ */
+static CompressionResult LoadAndScan(Schema *schema, int row_nums, const RowMaker &make_row, bool compressed) {
+  DiskManager::RemoveFiles(db_file_name);
+  auto disk_mgr = new DiskManager(db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  auto heap = TableHeap::Create(bpm, schema, nullptr, nullptr, nullptr, TABLE_HEAP_EXTENT_SIZE,
+                                bpm->CreateSegment(compressed));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields = make_row(i);
+    Row row(fields);
+    EXPECT_TRUE(heap->InsertTuple(row, nullptr));
+  }
+  page_id_t first_page_id = heap->GetFirstPageId();
+  delete heap;
+  IoStats before = disk_mgr->GetIoStats();
+  // write back every page
+  delete bpm;
+  IoStats written = disk_mgr->GetIoStats() - before;
+
+  bpm = new BufferPoolManager(64, disk_mgr);
+  heap = TableHeap::Create(bpm, first_page_id, schema, nullptr, nullptr);
+  before = disk_mgr->GetIoStats();
+  auto start = std::chrono::steady_clock::now();
+  int rows = 0;
+  for (auto it = heap->Begin(nullptr); it != heap->End(); ++it) {
+    rows++;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  IoStats read = disk_mgr->GetIoStats() - before;
+  delete heap;
+  delete bpm;
+  disk_mgr->Close();
+  delete disk_mgr;
+  DiskManager::RemoveFiles(db_file_name);
+  // logical bytes scanned per second, so that both layouts are measured against the same amount of table data
+  return {static_cast<double>(written.bytes_written_) / (written.pages_written_ * PAGE_SIZE),
+          read.pages_read_ * PAGE_SIZE / (seconds * 1024 * 1024), rows};
+}
+
+static double ReportCompression(const std::string &name, Schema *schema, int row_nums, const RowMaker &make_row) {
+  CompressionResult plain = LoadAndScan(schema, row_nums, make_row, false);
+  CompressionResult compressed = LoadAndScan(schema, row_nums, make_row, true);
+  printf("[Compression] %s rows=%d ratio=%.3f scan_plain=%.1fMB/s scan_compressed=%.1fMB/s\n", name.c_str(),
+         row_nums, compressed.ratio_, plain.scan_mb_per_s_, compressed.scan_mb_per_s_);
+  EXPECT_EQ(row_nums, plain.rows_);
+  EXPECT_EQ(row_nums, compressed.rows_);
+  EXPECT_DOUBLE_EQ(1.0, plain.ratio_);
+  return compressed.ratio_;
+}
+
+TEST(CompressionBenchmarkTest, ExecutorDataTest) {
+  const int row_nums = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  Schema schema(columns);
+
+  // Scenario: the rows of the executor tests, random names of random length, still shrink a little.
+  std::vector<std::string> names(row_nums);
+  for (auto &name : names) {
+    name.resize(RandomUtils::RandomInt(0, 64));
+    RandomUtils::RandomString(&name[0], name.size());
+  }
+  std::mt19937 rng(row_nums);
+  std::uniform_real_distribution<float> account(-999.f, 999.f);
+  double ratio = ReportCompression("executor", &schema, row_nums, [&](int i) {
+    return Fields{Field(TypeId::kTypeInt, i),
+                  Field(TypeId::kTypeChar, const_cast<char *>(names[i].c_str()), names[i].size(), true),
+                  Field(TypeId::kTypeFloat, account(rng))};
+  });
+  EXPECT_LE(ratio, 1.0);
+
+  // Scenario: repetitive CHAR columns, a handful of distinct padded values, compress to less than half.
+  std::vector<std::string> cities;
+  for (auto city : {"Hangzhou", "Shanghai", "Beijing", "Shenzhen", "Chengdu"}) {
+    cities.push_back(std::string(city) + std::string(64 - strlen(city), ' '));
+  }
+  ratio = ReportCompression("repetitive", &schema, row_nums, [&](int i) {
+    auto &city = cities[i % cities.size()];
+    return Fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, const_cast<char *>(city.c_str()), 64, true),
+                  Field(TypeId::kTypeFloat, static_cast<float>(i % 100))};
+  });
+  EXPECT_LT(ratio, 0.5);
+}
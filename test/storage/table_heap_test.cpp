@@ -1,9 +1,16 @@
 #include "storage/table_heap.h"
 
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "common/instance.h"
+#include "concurrency/txn_manager.h"
 #include "gtest/gtest.h"
 #include "record/field.h"
 #include "record/schema.h"
@@ -61,3 +68,562 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, TableIteratorReadAheadTest) {
+  // a pool much smaller than the table, so that the scan runs on prefetched pages
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(64, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  for (int i = 0; i < row_nums; i++) {
+    std::string name = std::to_string(i);
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+
+  std::vector<bool> seen(row_nums, false);
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    int id = std::stoi(std::string(it->GetField(1)->GetData(), it->GetField(1)->GetLength()));
+    ASSERT_TRUE(id >= 0 && id < row_nums);
+    ASSERT_FALSE(seen[id]);
+    seen[id] = true;
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  ASSERT_TRUE(bpm_->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ExtentAllocationTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new ParallelBufferPoolManager(4, 64, disk_mgr_);
+  const int row_nums = 4000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *heaps[2] = {TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr),
+                         TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr)};
+  for (int i = 0; i < row_nums; i++) {
+    std::string name = std::to_string(i);
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(heaps[i % 2]->InsertTuple(row, nullptr));
+  }
+
+  // Scenario: tables growing side by side still get their pages in runs of adjacent pages.
+  std::vector<page_id_t> chain;
+  for (page_id_t page_id = heaps[0]->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+    chain.push_back(page_id);
+    PageGuard guard = bpm_->FetchPageBasic(page_id);
+    page_id = reinterpret_cast<TablePage *>(guard.GetPage())->GetNextPageId();
+  }
+  ASSERT_GT(chain.size(), 2 * TABLE_HEAP_EXTENT_SIZE);
+  size_t jumps = 0;
+  for (size_t i = 1; i < chain.size(); i++) {
+    if (chain[i] != chain[i - 1] + 1) {
+      jumps++;
+    }
+  }
+  EXPECT_LE(jumps, (chain.size() - 1) / TABLE_HEAP_EXTENT_SIZE);
+
+  // Scenario: a scan through prefetched runs sees every row once.
+  int count = 0;
+  for (auto it = heaps[0]->Begin(nullptr); it != heaps[0]->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(row_nums / 2, count);
+  ASSERT_TRUE(bpm_->CheckAllUnpinned());
+
+  // Scenario: dropping a table gives back its pages, including the ones reserved but not used yet.
+  size_t tail_run = 1;
+  while (tail_run < chain.size() && chain[chain.size() - tail_run - 1] == chain.back() - static_cast<int>(tail_run)) {
+    tail_run++;
+  }
+  size_t reserved = (TABLE_HEAP_EXTENT_SIZE - tail_run % TABLE_HEAP_EXTENT_SIZE) % TABLE_HEAP_EXTENT_SIZE;
+  ASSERT_GT(reserved, 0);
+  EXPECT_FALSE(disk_mgr_->IsPageFree(chain.back() + 1));
+  heaps[0]->DeleteTable();
+  for (auto page_id : chain) {
+    EXPECT_TRUE(disk_mgr_->IsPageFree(page_id));
+  }
+  for (size_t i = 1; i <= reserved; i++) {
+    EXPECT_TRUE(disk_mgr_->IsPageFree(chain.back() + i));
+  }
+
+  delete heaps[0];
+  delete heaps[1];
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 20000;
+  const int batch = 1000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::string name(64, 'x');
+  auto make_row = [&](int i) {
+    return Fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), 64, true)};
+  };
+  auto fetches = [&]() {
+    BufferPoolStats stats = bpm_->GetStats();
+    return stats.hits_ + stats.misses_;
+  };
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  ASSERT_NE(INVALID_PAGE_ID, table_heap->GetFreeSpaceMapPageId());
+
+  // Scenario: an insert fetches about as many pages into a large table as into a small one.
+  std::vector<RowId> rids;
+  uint64_t first_batch = 0;
+  uint64_t last_batch = 0;
+  for (int i = 0; i < row_nums; i++) {
+    uint64_t before = fetches();
+    Fields fields = make_row(i);
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+    if (i < batch) {
+      first_batch += fetches() - before;
+    } else if (i >= row_nums - batch) {
+      last_batch += fetches() - before;
+    }
+  }
+  printf("[FreeSpaceMap] rows=%d fetches per insert: first %d rows=%.2f last %d rows=%.2f\n", row_nums, batch,
+         static_cast<double>(first_batch) / batch, batch, static_cast<double>(last_batch) / batch);
+  EXPECT_LE(last_batch, 2 * first_batch);
+
+  // Scenario: the space freed by deletes on an early page is found once the page being filled is full.
+  auto free_page = [&](page_id_t page_id) {
+    for (auto &rid : rids) {
+      if (rid.GetPageId() == page_id) {
+        ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+        table_heap->ApplyDelete(rid, nullptr);
+      }
+    }
+  };
+  page_id_t second_page_id = rids[row_nums / 2].GetPageId();
+  free_page(second_page_id);
+  Fields fields = make_row(row_nums);
+  bool reused = false;
+  for (int i = 0; i < 2 * PAGE_SIZE / 64 && !reused; i++) {
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    reused = row.GetRowId().GetPageId() == second_page_id;
+  }
+  EXPECT_TRUE(reused);
+
+  // Scenario: the map is kept on disk, a heap opened with its root still knows about freed space.
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  page_id_t third_page_id = rids[row_nums / 4].GetPageId();
+  free_page(third_page_id);
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, TABLE_HEAP_EXTENT_SIZE,
+                                 free_space_map_page_id);
+  Row reopened_row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(reopened_row, nullptr));
+  EXPECT_EQ(third_page_id, reopened_row.GetRowId().GetPageId());
+
+  // Scenario: a heap opened without a map rebuilds it from the heap pages before its first insert.
+  page_id_t fourth_page_id = rids[row_nums / 8].GetPageId();
+  free_page(fourth_page_id);
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  Row rebuilt_row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(rebuilt_row, nullptr));
+  EXPECT_EQ(fourth_page_id, rebuilt_row.GetRowId().GetPageId());
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, BatchInsertTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 20000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::string name(32, 'x');
+  auto make_rows = [&](int first, int count) {
+    std::vector<Row> rows;
+    for (int i = first; i < first + count; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i),
+                    Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+      rows.emplace_back(fields);
+    }
+    return rows;
+  };
+  auto fetches = [&]() {
+    BufferPoolStats stats = bpm_->GetStats();
+    return stats.hits_ + stats.misses_;
+  };
+
+  // Scenario: a batch latches each page once, where single inserts fetch a page per row.
+  TableHeap *single_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<Row> rows = make_rows(0, row_nums);
+  uint64_t before = fetches();
+  auto start = std::chrono::steady_clock::now();
+  for (auto &row : rows) {
+    ASSERT_TRUE(single_heap->InsertTuple(row, nullptr));
+  }
+  double single_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  uint64_t single_fetches = fetches() - before;
+
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  rows = make_rows(0, row_nums);
+  std::vector<RowId> rids;
+  before = fetches();
+  start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(table_heap->InsertTuples(rows, nullptr, &rids));
+  double batch_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  uint64_t batch_fetches = fetches() - before;
+  printf("[BatchInsert] rows=%d single: %.0f rows/s %lu fetches, batch: %.0f rows/s %lu fetches\n", row_nums,
+         row_nums / single_seconds, static_cast<unsigned long>(single_fetches), row_nums / batch_seconds,
+         static_cast<unsigned long>(batch_fetches));
+  EXPECT_LT(batch_fetches * 10, single_fetches);
+
+  // Scenario: every row gets a slot of its own and is found by a scan.
+  ASSERT_EQ(static_cast<size_t>(row_nums), rids.size());
+  std::unordered_map<int64_t, int> seen;
+  for (auto &rid : rids) {
+    seen[rid.Get()]++;
+  }
+  EXPECT_EQ(static_cast<size_t>(row_nums), seen.size());
+
+  // Scenario: a second batch first fills the last page, then links its new pages behind it.
+  page_id_t last_page_id = rids.back().GetPageId();
+  rows = make_rows(row_nums, row_nums);
+  rids.clear();
+  ASSERT_TRUE(table_heap->InsertTuples(rows, nullptr, &rids));
+  EXPECT_EQ(last_page_id, rids.front().GetPageId());
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    EXPECT_EQ(CmpBool::kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  EXPECT_EQ(2 * row_nums, count);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete single_heap;
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+
+  // Scenario: a batch through a bulk write ring leaves the pages already cached in the buffer pool.
+  remove(db_file_name.c_str());
+  disk_mgr_ = new DiskManager(db_file_name);
+  bpm_ = new BufferPoolManager(2 * BULK_WRITE_RING_SIZE, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<page_id_t> hot_pages(BULK_WRITE_RING_SIZE / 2);
+  for (auto &page_id : hot_pages) {
+    ASSERT_NE(nullptr, bpm_->NewPage(page_id));
+    EXPECT_TRUE(bpm_->UnpinPage(page_id, true));
+  }
+  BufferAccessStrategy bulk_write(AccessStrategyType::kBulkWrite);
+  rows = make_rows(0, row_nums);
+  ASSERT_TRUE(table_heap->InsertTuples(rows, nullptr, nullptr, &bulk_write));
+  for (auto page_id : hot_pages) {
+    EXPECT_TRUE(bpm_->IsPageResident(page_id));
+  }
+  count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(row_nums, count);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::string name(32, 'x');
+  auto make_row = [&](int i) {
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+    return Row(fields);
+  };
+  auto scan = [](TableHeap *table_heap) {
+    int count = 0;
+    for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+      count++;
+    }
+    return count;
+  };
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Row row = make_row(i);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  EXPECT_FALSE(table_heap->NeedsVacuum());
+
+  // Scenario: deletes only mark the tuples, a vacuum gives their space back and frees the pages left empty.
+  std::set<page_id_t> emptied_pages;
+  int deleted = 0;
+  for (int i = 0; i < row_nums; i++) {
+    if (i < row_nums / 2 || i % 2 == 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      deleted++;
+      if (i < row_nums / 2 && rids[i].GetPageId() != table_heap->GetFirstPageId()) {
+        emptied_pages.insert(rids[i].GetPageId());
+      }
+    }
+  }
+  // the page holding both halves keeps tuples
+  emptied_pages.erase(rids[row_nums / 2].GetPageId());
+  VacuumStats stats = table_heap->GetVacuumStats();
+  EXPECT_EQ(static_cast<uint64_t>(row_nums - deleted), stats.live_tuples_);
+  EXPECT_EQ(static_cast<uint64_t>(deleted), stats.dead_tuples_);
+  EXPECT_TRUE(table_heap->NeedsVacuum());
+  size_t reclaimed = table_heap->Vacuum();
+  stats = table_heap->GetVacuumStats();
+  printf("[Vacuum] rows=%d deleted=%d reclaimed=%zu bytes freed_pages=%lu dead_ratio=%.2f\n", row_nums, deleted,
+         reclaimed, static_cast<unsigned long>(stats.freed_pages_), stats.GetDeadTupleRatio());
+  EXPECT_GE(reclaimed, static_cast<size_t>(deleted) * name.size());
+  EXPECT_EQ(reclaimed, stats.reclaimed_bytes_);
+  EXPECT_EQ(0u, stats.dead_tuples_);
+  EXPECT_EQ(static_cast<uint64_t>(row_nums - deleted), stats.live_tuples_);
+  EXPECT_EQ(emptied_pages.size(), stats.freed_pages_);
+  for (auto page_id : emptied_pages) {
+    EXPECT_TRUE(bpm_->IsPageFree(page_id));
+  }
+  EXPECT_FALSE(table_heap->NeedsVacuum());
+  EXPECT_EQ(row_nums - deleted, scan(table_heap));
+  for (int i = row_nums / 2 + 1; i < row_nums; i += 2) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    EXPECT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+  }
+
+  // Scenario: the reclaimed space takes new rows without growing the heap.
+  // the first page stays in the heap even when it is empty
+  std::set<page_id_t> pages_before{table_heap->GetFirstPageId()};
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    pages_before.insert(it->GetRowId().GetPageId());
+  }
+  for (int i = 0; i < deleted / 4; i++) {
+    Row row = make_row(row_nums + i);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    EXPECT_TRUE(pages_before.count(row.GetRowId().GetPageId()));
+  }
+
+  // Scenario: a delete a transaction may still roll back is left alone.
+  RowId kept = rids[row_nums - 1];
+  Txn txn;
+  ASSERT_TRUE(table_heap->MarkDelete(kept, &txn));
+  table_heap->Vacuum();
+  EXPECT_EQ(1u, table_heap->GetVacuumStats().dead_tuples_);
+  table_heap->RollbackDelete(kept, &txn);
+  EXPECT_TRUE(txn.GetDeleteSet().empty());
+  Row kept_row(kept);
+  EXPECT_TRUE(table_heap->GetTuple(&kept_row, nullptr));
+
+  // Scenario: the commit applies the transaction's deletes, an abort rolls them back.
+  LockManager lock_mgr;
+  TxnManager txn_mgr(&lock_mgr);
+  Txn aborted;
+  txn_mgr.Begin(&aborted);
+  ASSERT_TRUE(table_heap->MarkDelete(kept, &aborted));
+  txn_mgr.Abort(&aborted);
+  EXPECT_TRUE(aborted.GetDeleteSet().empty());
+  Row aborted_row(kept);
+  EXPECT_TRUE(table_heap->GetTuple(&aborted_row, nullptr));
+  Txn committed;
+  txn_mgr.Begin(&committed);
+  ASSERT_TRUE(table_heap->MarkDelete(kept, &committed));
+  txn_mgr.Commit(&committed);
+  EXPECT_TRUE(committed.GetDeleteSet().empty());
+  Row committed_row(kept);
+  EXPECT_FALSE(table_heap->GetTuple(&committed_row, nullptr));
+  EXPECT_EQ(0u, table_heap->GetVacuumStats().dead_tuples_);
+  // an insert rolled back does not take the dead tuple count below zero
+  Row rolled_back_row = make_row(row_nums);
+  ASSERT_TRUE(table_heap->InsertTuple(rolled_back_row, nullptr));
+  uint64_t live_tuples = table_heap->GetVacuumStats().live_tuples_;
+  table_heap->ApplyDelete(rolled_back_row.GetRowId(), nullptr);
+  EXPECT_EQ(0u, table_heap->GetVacuumStats().dead_tuples_);
+  EXPECT_EQ(live_tuples - 1, table_heap->GetVacuumStats().live_tuples_);
+  ASSERT_TRUE(table_heap->MarkDelete(rids[row_nums / 2 + 1], nullptr));
+  EXPECT_EQ(1u, table_heap->GetVacuumStats().dead_tuples_);
+  table_heap->RollbackDelete(rids[row_nums / 2 + 1], nullptr);
+  EXPECT_EQ(0u, table_heap->GetVacuumStats().dead_tuples_);
+  EXPECT_FALSE(table_heap->NeedsVacuum());
+
+  // Scenario: an open scan keeps an emptied page linked, the next vacuum frees it.
+  page_id_t emptied_page_id = rids[row_nums * 3 / 4].GetPageId();
+  uint64_t freed_pages = table_heap->GetVacuumStats().freed_pages_;
+  auto it = table_heap->Begin(nullptr);
+  for (auto page_it = table_heap->Begin(nullptr); page_it != table_heap->End(); ++page_it) {
+    if (page_it->GetRowId().GetPageId() == emptied_page_id) {
+      ASSERT_TRUE(table_heap->MarkDelete(page_it->GetRowId(), nullptr));
+    }
+  }
+  EXPECT_GT(table_heap->Vacuum(), 0u);
+  EXPECT_EQ(freed_pages, table_heap->GetVacuumStats().freed_pages_);
+  it = table_heap->End();
+  table_heap->Vacuum();
+  EXPECT_EQ(freed_pages + 1, table_heap->GetVacuumStats().freed_pages_);
+  EXPECT_TRUE(bpm_->IsPageFree(emptied_page_id));
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+
+  // Scenario: the vacuum worker of a database finds the table with dead tuples by itself.
+  auto engine = new DBStorageEngine(db_file_name, true);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, engine->catalog_mgr_->CreateTable("vacuum", schema.get(), nullptr, table_info));
+  table_heap = table_info->GetTableHeap();
+  rids.clear();
+  for (int i = 0; i < 1000; i++) {
+    Row row = make_row(i);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    ASSERT_TRUE(table_heap->MarkDelete(row.GetRowId(), nullptr));
+  }
+  engine->StartVacuumWorker(10);
+  for (int i = 0; i < 200 && table_heap->GetVacuumStats().vacuums_ == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  stats = table_heap->GetVacuumStats();
+  EXPECT_EQ(1u, stats.vacuums_);
+  EXPECT_EQ(0u, stats.dead_tuples_);
+  EXPECT_GT(stats.reclaimed_bytes_, 0u);
+
+  // Scenario: shrinking the files pauses the vacuum worker and the flusher, both carry on afterwards.
+  Row kept_engine_row = make_row(-1);
+  ASSERT_TRUE(table_heap->InsertTuple(kept_engine_row, nullptr));
+  auto insert_and_delete = [&](int count) {
+    for (int i = 0; i < count; i++) {
+      Row row = make_row(i);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      ASSERT_TRUE(table_heap->MarkDelete(row.GetRowId(), nullptr));
+    }
+  };
+  auto wait_for_vacuums = [&](uint64_t vacuums) {
+    for (int i = 0; i < 200 && table_heap->GetVacuumStats().vacuums_ < vacuums; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return table_heap->GetVacuumStats().vacuums_ >= vacuums;
+  };
+  insert_and_delete(row_nums);
+  ASSERT_TRUE(wait_for_vacuums(stats.vacuums_ + 1));
+  EXPECT_GT(table_heap->GetVacuumStats().freed_pages_, 0u);
+  EXPECT_GT(engine->Shrink(), 0u);
+  Row read_back(kept_engine_row.GetRowId());
+  EXPECT_TRUE(table_heap->GetTuple(&read_back, nullptr));
+  stats = table_heap->GetVacuumStats();
+  insert_and_delete(1000);
+  EXPECT_TRUE(wait_for_vacuums(stats.vacuums_ + 1));
+
+  // Scenario: a table pinned by background work is dropped once it is unpinned, other tables are created meanwhile.
+  std::vector<TableInfo *> pinned;
+  engine->catalog_mgr_->PinTables(pinned);
+  std::atomic<bool> dropped{false};
+  std::thread dropper([&]() {
+    EXPECT_EQ(DB_SUCCESS, engine->catalog_mgr_->DropTable("vacuum"));
+    dropped = true;
+  });
+  TableInfo *other_info = nullptr;
+  EXPECT_EQ(DB_SUCCESS, engine->catalog_mgr_->CreateTable("vacuum_other", schema.get(), nullptr, other_info));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(dropped);
+  for (auto table : pinned) {
+    engine->catalog_mgr_->UnpinTable(table);
+  }
+  dropper.join();
+  EXPECT_TRUE(dropped);
+  delete engine;
+}
+
+TEST(TableHeapTest, ConcurrentInsertBenchmarkTest) {
+  const int rows_per_thread = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::string name(32, 'x');
+
+  for (uint32_t insert_points : {1u, MAX_TABLE_INSERT_POINTS}) {
+    for (int thread_num : {1, 4, 8}) {
+      remove(db_file_name.c_str());
+      auto disk_mgr_ = new DiskManager(db_file_name);
+      auto bpm_ = new ParallelBufferPoolManager(4, DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+      TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+      table_heap->SetInsertPointCount(insert_points);
+
+      // Scenario: sessions insert into one table at once, each row lands in a slot of its own.
+      std::vector<std::vector<RowId>> rids(thread_num);
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t]() {
+          for (int i = 0; i < rows_per_thread; i++) {
+            Fields fields{Field(TypeId::kTypeInt, t * rows_per_thread + i),
+                          Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+            Row row(fields);
+            ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+            rids[t].push_back(row.GetRowId());
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      printf("[ConcurrentInsert] insert_points=%u threads=%d rows=%d %.0f rows/s\n", insert_points, thread_num,
+             thread_num * rows_per_thread, thread_num * rows_per_thread / seconds);
+
+      std::unordered_map<int64_t, int> seen;
+      for (auto &thread_rids : rids) {
+        for (auto &rid : thread_rids) {
+          seen[rid.Get()]++;
+        }
+      }
+      EXPECT_EQ(static_cast<size_t>(thread_num * rows_per_thread), seen.size());
+      int count = 0;
+      for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+        count++;
+      }
+      EXPECT_EQ(thread_num * rows_per_thread, count);
+      EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+      delete table_heap;
+      delete bpm_;
+      delete disk_mgr_;
+    }
+  }
+  remove(db_file_name.c_str());
+}